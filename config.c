@@ -22,11 +22,14 @@
 #include "qrouter.h"
 #include "config.h"
 #include "lef.h"
+#include "order.h"
 
 int    CurrentPin = 0;
 int    Firstcall = TRUE;
 int    PinNumber = 0;
 
+static STRING CriticalLast = NULL;	// end of the CriticalNet list
+
 int     Num_layers   = MAX_LAYERS;	// layers to use to route
 
 double  PathWidth[MAX_LAYERS];		// width of the paths
@@ -43,6 +46,16 @@ char	StackedContacts = MAX_LAYERS;	// Value is number of contacts that may
 					// be stacked on top of each other.
 char	ViaPattern = VIA_PATTERN_NONE;	// Patterning to be used for vias based
 					// on grid position (i.e., checkerboarding)
+u_char	SearchAStar = FALSE;		// Goal-directed (A*) search in route_segs
+u_char	SearchJump = FALSE;		// Jump along free track in route_segs
+int	MaskExpand = -1;		// Route mask widenings before full grid search
+int	GlobalTile = 0;			// Global routing gcell size, in tracks (0 = off)
+int	Negotiate = 0;			// Negotiated congestion passes (0 = off)
+int	ReuseSearch = 0;		// Nodes in a net to keep the search between legs
+int	PatternRoute = 0;		// Tap span of nets to try as L/Z routes (0 = off)
+int	ProbeRoute = 0;			// Span of nets to try with line probes (0 = off)
+u_char	NetOrder = ORDER_FANOUT;	// Net ordering strategy (see order.c)
+char	*NetOrderFile = NULL;		// File to write the net order to
 
 double  Xlowerbound=0.0;		// Bounding Box of routes, in microns
 double  Xupperbound=0.0;      
@@ -57,6 +70,8 @@ int     BlockCost = 25;            // Cost of a crossover when node has
 				   // only one tap point
 int 	ConflictCost = 50;	   // Cost of shorting another route
 				   // during the rip-up and reroute stage
+int	HistCost = 10;		   // Cost of each past collision at a
+				   // position (negotiated congestion)
 
 char    *ViaX[MAX_LAYERS];
 char    *ViaY[MAX_LAYERS];
@@ -124,6 +139,38 @@ int read_config(FILE *fconfig)
 	    }
 	}
 
+	// Net order file:  "route order file <name>" writes the order
+	// of the nets out to <name>.  The file name keeps its case.
+
+	if (!strncasecmp(lineptr, "route order file", 16)) {
+	    if ((i = sscanf(lineptr + 16, "%s", sarg)) == 1) {
+	       OK = 1;
+	       if (NetOrderFile != NULL) free(NetOrderFile);
+	       NetOrderFile = strdup(sarg);
+	    }
+	}
+
+	// Critical nets:  "route priority <net>" (as written by "route
+	// order file") or "critical net <net>".  Net names keep their
+	// case, since find_net() matches them exactly.
+
+	sarg[0] = '\0';
+	if (!strncasecmp(lineptr, "route priority", 14))
+	    sscanf(lineptr + 14, "%s", sarg);
+	else if (!strncasecmp(lineptr, "critical net", 12))
+	    sscanf(lineptr + 12, "%s", sarg);
+	if (sarg[0] != '\0') {
+	    OK = 1; 
+	    cn = (STRING)malloc(sizeof(struct string_));
+	    cn->name = strdup(sarg);
+	    cn->next = NULL;
+	    if (CriticalNet != NULL)
+	       CriticalLast->next = cn;
+	    else
+	       CriticalNet = cn;
+	    CriticalLast = cn;
+	}
+
 	// The remainder of the statements is not case sensitive.
 
 	for (i = 0; line[i] && i < MAXLINE - 1; i++) {
@@ -236,42 +283,13 @@ int read_config(FILE *fconfig)
 	    OK = 1; 
 	    dnr = (STRING)malloc(sizeof(struct string_));
 	    dnr->name = strdup(sarg);
+	    dnr->next = NULL;
 	    if (DontRoute != NULL) {
 	       for (strl = DontRoute; strl->next; strl = strl->next);
 	       strl->next = dnr;
 	    }
-	    else {
-	       dnr->next = NULL;
+	    else
 	       DontRoute = dnr;
-	    }
-	}
-	
-	if ((i = sscanf(lineptr, "route priority %s\n", sarg)) == 1) {
-	    OK = 1; 
-	    cn = (STRING)malloc(sizeof(struct string_));
-	    cn->name = strdup(sarg);
-	    if (CriticalNet != NULL) {
-	       for (strl = CriticalNet; strl->next; strl = strl->next);
-	       strl->next = cn;
-	    }
-	    else {
-	       cn->next = NULL;
-	       CriticalNet = cn;
-	    }
-	}
-	
-	if ((i = sscanf(lineptr, "critical net %s\n", sarg)) == 1) {
-	    OK = 1; 
-	    cn = (STRING)malloc(sizeof(struct string_));
-	    cn->name = strdup(sarg);
-	    if (CriticalNet != NULL) {
-	       for (strl = CriticalNet; strl->next; strl = strl->next);
-	       strl->next = cn;
-	    }
-	    else {
-	       cn->next = NULL;
-	       CriticalNet = cn;
-	    }
 	}
 
 	// Search for "no stack".  This allows variants like "no stacked
@@ -295,6 +313,98 @@ int read_config(FILE *fconfig)
 	    if (StackedContacts == 0) StackedContacts = 1;
 	}
 
+	// Search mode:  "route search astar" directs the search toward
+	// the targets;  "route search maze" (default) floods outward from
+	// the source.
+
+	if ((i = sscanf(lineptr, "route search %s", sarg)) == 1) {
+	    if (!strcmp(sarg, "astar") || !strcmp(sarg, "a*")) {
+		OK = 1; SearchAStar = TRUE;
+	    }
+	    else if (!strcmp(sarg, "maze") || !strcmp(sarg, "lee")) {
+		OK = 1; SearchAStar = FALSE;
+	    }
+	}
+
+	// Jumps:  "route jump on" lets the search cross stretches of
+	// free track along the preferred direction of a layer in one
+	// step, stopping only where a via or jog opens up or a target
+	// comes into line.
+
+	if ((i = sscanf(lineptr, "route jump %s", sarg)) == 1) {
+	    if (!strcmp(sarg, "on") || !strcmp(sarg, "yes") || !strcmp(sarg, "1")) {
+		OK = 1; SearchJump = TRUE;
+	    }
+	    else if (!strcmp(sarg, "off") || !strcmp(sarg, "no") || !strcmp(sarg, "0")) {
+		OK = 1; SearchJump = FALSE;
+	    }
+	}
+
+	// Corridor search:  "route mask <n>" confines the search to the
+	// area around the ideal L-route or trunk line of the net, widening
+	// it by one track up to <n> times before searching the whole grid.
+	// A negative value (default) searches the whole grid from the start.
+
+	if ((i = sscanf(lineptr, "route mask %d", &iarg)) == 1) {
+	    OK = 1; MaskExpand = iarg;
+	}
+
+	// Global routing:  "route global <n>" routes all nets on a coarse
+	// grid first, and confines each detail route to the gcells used by
+	// its global route.  Gcells are taken from the DEF GCELLGRID if
+	// present, otherwise they are <n> tracks square.
+
+	if ((i = sscanf(lineptr, "route global %d", &iarg)) == 1) {
+	    OK = 1; GlobalTile = iarg;
+	}
+
+	// Negotiated congestion:  "route negotiate <n>" replaces the
+	// rip-up heuristic of the second stage with up to <n> passes in
+	// which colliding routes pay a rising present cost and a history
+	// cost ("route history cost <n>") for every past collision.
+
+	if ((i = sscanf(lineptr, "route negotiate %d", &iarg)) == 1) {
+	    OK = 1; Negotiate = iarg;
+	}
+
+	if ((i = sscanf(lineptr, "route history cost %d", &iarg)) == 1) {
+	    OK = 1; HistCost = iarg;
+	}
+
+	// Multi-terminal nets:  "route reuse <n>" routes each net of <n>
+	// or more nodes as one search, carrying on from the last leg with
+	// the new route as additional source, instead of starting over.
+
+	if ((i = sscanf(lineptr, "route reuse %d", &iarg)) == 1) {
+	    OK = 1; ReuseSearch = iarg;
+	}
+
+	// Pattern routes:  "route pattern <n>" tries the L- and Z-shaped
+	// routes of two-node nets with terminals within <n> tracks of
+	// each other before searching the grid.
+
+	if ((i = sscanf(lineptr, "route pattern %d", &iarg)) == 1) {
+	    OK = 1; PatternRoute = iarg;
+	}
+
+	// Line probes:  "route probe <n>" tries to connect each leg of a
+	// net spanning <n> tracks or more with lines shot along the tracks
+	// from its terminals, before searching the grid.
+
+	if ((i = sscanf(lineptr, "route probe %d", &iarg)) == 1) {
+	    OK = 1; ProbeRoute = iarg;
+	}
+
+	// Net order:  "route order <strategy>" sorts the nets that are
+	// not critical by fanout (default), area, hpwl, density, or not
+	// at all ("critical").  See order.c.
+
+	if ((i = sscanf(lineptr, "route order %s", sarg)) == 1) {
+	    if ((iarg = netorder_lookup(sarg)) >= 0) {
+		OK = 1; NetOrder = (u_char)iarg;
+	    }
+	}
+
 	// Look for via patterning specifications
 	if (strcasestr(lineptr, "via pattern") != NULL) {
 	    if (strcasestr(lineptr + 12, "normal") != NULL)
@@ -339,8 +449,7 @@ int read_config(FILE *fconfig)
 	    gateinfo->height = darg2;
 	    gateinfo->placedX = 0.0;	// implicit cell origin
 	    gateinfo->placedY = 0.0;
-	    gateinfo->next = GateInfo;	// prepend to linked gate list
-	    GateInfo = gateinfo;
+	    lefAddCell(gateinfo);	// prepend to linked gate list
 	}
 	
         if ((i = sscanf(lineptr, "endgate %s\n", sarg)) == 1) {
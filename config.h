@@ -25,6 +25,16 @@ extern int     Vert[MAX_LAYERS];        // 1 if verticle, 0 if horizontal
 extern int     Numpasses;               // number of times to iterate in route_segs
 extern char    StackedContacts;	  	// Number of vias that can be stacked together
 extern char    ViaPattern;		// Type of via patterning to use
+extern u_char  SearchAStar;		// Use goal-directed (A*) search
+extern u_char  SearchJump;		// Jump along free track runs
+extern int     MaskExpand;		// Route mask widenings (-1 = no mask)
+extern int     GlobalTile;		// Global routing gcell size (0 = off)
+extern int     Negotiate;		// Negotiated congestion passes (0 = off)
+extern int     ReuseSearch;		// Net size to keep the search between legs (0 = off)
+extern int     PatternRoute;		// Tap span of nets to try as L/Z routes (0 = off)
+extern int     ProbeRoute;		// Span of nets to try with line probes (0 = off)
+extern u_char  NetOrder;		// Net ordering strategy (ORDER_*)
+extern char   *NetOrderFile;		// File to write the net order to
 
 extern double  Xlowerbound;  // Bounding Box of routes
 extern double  Xupperbound;      
@@ -37,6 +47,7 @@ extern int     JogCost;
 extern int     XverCost;
 extern int     BlockCost;
 extern int     ConflictCost;
+extern int     HistCost;
 
 extern char    *ViaX[MAX_LAYERS];
 extern char    *ViaY[MAX_LAYERS];
@@ -31,6 +31,11 @@
 #include "config.h"
 #include "maze.h"
 #include "lef.h"
+#include "glroute.h"
+#include "hash.h"
+
+/* Gate instances of Nlgates by name (see DefReadGatePin()) */
+static HASHTABLE InstanceTable;
 
 /*
  *------------------------------------------------------------
@@ -53,7 +58,7 @@
  */
 
 char *
-DefAddRoutes(FILE *f, float oscale, NET net, char special)
+DefAddRoutes(LefFile *f, float oscale, NET net, char special)
 {
     char *token;
     SEG routeList, newRoute = NULL;
@@ -89,7 +94,8 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 
 	    if (routeLayer < 0)
 	    {
-		LefError("Unknown layer type \"%s\" for NEW route\n", token); 
+		LefError(f, "Unknown layer type \"%s\" for NEW route\n",
+				token);
 		continue;
 	    }
 	    paintLayer = routeLayer;
@@ -100,8 +106,8 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 		token = LefNextToken(f, TRUE);
 		if (sscanf(token, "%lg", &w) != 1)
 		{
-		    LefError("Bad width in special net\n");
-		    continue;
+		    LefError(f, "Bad width in special net\n");
+		continue;
 		}
 		if (w != 0)
 		    w /= oscale;
@@ -131,7 +137,8 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 
 	    else if (valid == FALSE)
 	    {
-		LefError("Route has via name \"%s\" but no points!\n", token);
+		LefError(f, "Route has via name \"%s\" but no points!\n",
+				token);
 		continue;
 	    }
 	    lefl = LefFindLayer(token);
@@ -168,7 +175,8 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 		}
 		else
 		{
-		    LefError("Error: Via \"%s\" named but undefined.\n", token);
+		    LefError(f, "Error: Via \"%s\" named but undefined.\n",
+				token);
 		    paintLayer = routeLayer;
 		}
 		if ((special == (char)0) && (paintLayer >= 0)) {
@@ -192,10 +200,10 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 		    }
 		}
 		else
-		    LefError("Via \"%s\" does not define a metal layer!\n", token);
-	    }
+		    LefError(f, "Via \"%s\" does not define a metal layer!\n", token);
+	}
 	    else
-		LefError("Via name \"%s\" unknown in route.\n", token);
+		LefError(f, "Via name \"%s\" unknown in route.\n", token);
 	}
 	else
 	{
@@ -214,8 +222,8 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 	    {
 		if (valid == FALSE)
 		{
-		    LefError("No reference point for \"*\" wildcard\n"); 
-		    goto endCoord;
+		    LefError(f, "No reference point for \"*\" wildcard\n"); 
+		goto endCoord;
 		}
 	    }
 	    else if (sscanf(token, "%lg", &x) == 1)
@@ -225,7 +233,7 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 	    }
 	    else
 	    {
-		LefError("Cannot parse X coordinate.\n"); 
+		LefError(f, "Cannot parse X coordinate.\n"); 
 		goto endCoord;
 	    }
 	    token = LefNextToken(f, TRUE);	/* read Y */
@@ -233,8 +241,8 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 	    {
 		if (valid == FALSE)
 		{
-		    LefError("No reference point for \"*\" wildcard\n"); 
-		    free(newRoute);
+		    LefError(f, "No reference point for \"*\" wildcard\n"); 
+		free(newRoute);
 		    newRoute = NULL;
 		    goto endCoord;
 		}
@@ -246,7 +254,7 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 	    }
 	    else
 	    {
-		LefError("Cannot parse Y coordinate.\n"); 
+		LefError(f, "Cannot parse Y coordinate.\n"); 
 		goto endCoord;
 	    }
 
@@ -261,7 +269,8 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 		/* Skip over nonmanhattan segments, reset the reference	*/
 		/* point, and output a warning.				*/
 
-		LefError("Can't deal with nonmanhattan geometry in route.\n");
+		LefError(f, "Can't deal with nonmanhattan "
+				"geometry in route.\n");
 		locarea.x1 = refp.x1;
 		locarea.y1 = refp.y1;
 		lx = x;
@@ -345,13 +354,17 @@ endCoord:
  *	DEF file NETS section, find the position of the
  *	gate, then the position of the pin within the gate,
  *	and add pin and obstruction information to the grid
- *	network.
+ *	network.  The gate is found in InstanceTable and its
+ *	macro with lefFindCell(), so names are not case
+ *	sensitive.  An endpoint on an unknown instance is
+ *	skipped;  one on an unknown macro or pin is reported.
  *
  *------------------------------------------------------------
  */
 
 void
-DefReadGatePin(NET net, NODE node, char *instname, char *pinname, double *home)
+DefReadGatePin(LefFile *f, NET net, NODE node, char *instname, char *pinname,
+	double *home)
 {
     NODE node2;
     int i, j;
@@ -362,85 +375,83 @@ DefReadGatePin(NET net, NODE node, char *instname, char *pinname, double *home)
     int gridx, gridy;
     DPOINT dp;
 
-    for (g = Nlgates; g; g = g->next) {
-	if (!strcasecmp(instname, g->gatename)) {
-	    for (gateginfo = GateInfo; gateginfo; gateginfo = gateginfo->next) {
-		if (!strcasecmp(g->gatetype, gateginfo->gatetype)) {
-		    for (i = 0; i < gateginfo->nodes; i++) {
-			if (!strcasecmp(gateginfo->node[i], pinname)) {
-			    node->taps = (DPOINT)NULL;
-			    node->extend = (DPOINT)NULL;
-
-			    for (drect = g->taps[i]; drect; drect = drect->next) {
-
-				// Add all routing gridpoints that fall inside
-				// the rectangle.  Much to do here:
-				// (1) routable area should extend 1/2 route width
-				// to each side, as spacing to obstructions allows.
-				// (2) terminals that are wide enough to route to
-				// but not centered on gridpoints should be marked
-				// in some way, and handled appropriately.
-
-				gridx = (int)((drect->x1 - Xlowerbound) /
-					PitchX[drect->layer]) - 1;
-				while (1) {
-				    dx = (gridx * PitchX[drect->layer]) + Xlowerbound;
-				    if (dx > drect->x2 + home[drect->layer]) break;
-				    if (dx < drect->x1 - home[drect->layer]) {
-					gridx++;
-				 	continue;
-				    }
-				    gridy = (int)((drect->y1 - Ylowerbound) /
-						PitchY[drect->layer]) - 1;
-				    while (1) {
-					dy = (gridy * PitchY[drect->layer])
-						+ Ylowerbound;
-					if (dy > drect->y2 + home[drect->layer]) break;
-					if (dy < drect->y1 - home[drect->layer]) {
-					    gridy++;
-					    continue;
-					}
-
-					// Routing grid point is an interior point
-					// of a gate port.  Record the position
-
-					dp = (DPOINT)malloc(sizeof(struct dpoint_));
-					dp->layer = drect->layer;
-					dp->x = dx;
-					dp->y = dy;
-					dp->gridx = gridx;
-					dp->gridy = gridy;
-
-					if (dy >= drect->y1 && dx >= drect->x1 &&
-						dy <= drect->y2 && dx <= drect->x2) {
-					    dp->next = node->taps;
-					    node->taps = dp;
-					}
-					else {
-					    dp->next = node->extend;
-					    node->extend = dp;
-					}
-					gridy++;
-				    }
-				    gridx++;
+    g = (GATE)HashLookup(instname, &InstanceTable);
+    if (g != NULL) {
+	gateginfo = lefFindCell(g->gatetype);
+	if (gateginfo != NULL) {
+	    for (i = 0; i < gateginfo->nodes; i++) {
+		if (!strcasecmp(gateginfo->node[i], pinname)) {
+		    node->taps = (DPOINT)NULL;
+		    node->extend = (DPOINT)NULL;
+
+		    for (drect = g->taps[i]; drect; drect = drect->next) {
+
+			// Add all routing gridpoints that fall inside
+			// the rectangle.  Much to do here:
+			// (1) routable area should extend 1/2 route width
+			// to each side, as spacing to obstructions allows.
+			// (2) terminals that are wide enough to route to
+			// but not centered on gridpoints should be marked
+			// in some way, and handled appropriately.
+
+			gridx = (int)((drect->x1 - Xlowerbound) /
+				PitchX[drect->layer]) - 1;
+			while (1) {
+			    dx = (gridx * PitchX[drect->layer]) + Xlowerbound;
+			    if (dx > drect->x2 + home[drect->layer]) break;
+			    if (dx < drect->x1 - home[drect->layer]) {
+				gridx++;
+				continue;
+			    }
+			    gridy = (int)((drect->y1 - Ylowerbound) /
+					PitchY[drect->layer]) - 1;
+			    while (1) {
+				dy = (gridy * PitchY[drect->layer])
+					+ Ylowerbound;
+				if (dy > drect->y2 + home[drect->layer]) break;
+				if (dy < drect->y1 - home[drect->layer]) {
+				    gridy++;
+				    continue;
+				}
+
+				// Routing grid point is an interior point
+				// of a gate port.  Record the position
+
+				dp = (DPOINT)malloc(sizeof(struct dpoint_));
+				dp->layer = drect->layer;
+				dp->x = dx;
+				dp->y = dy;
+				dp->gridx = gridx;
+				dp->gridy = gridy;
+
+				if (dy >= drect->y1 && dx >= drect->x1 &&
+					dy <= drect->y2 && dx <= drect->x2) {
+				    dp->next = node->taps;
+				    node->taps = dp;
 				}
+				else {
+				    dp->next = node->extend;
+				    node->extend = dp;
+				}
+				gridy++;
 			    }
-			    node->netnum = net->netnum;
-			    g->netnum[i] = net->netnum;
-			    g->noderec[i] = node;
-			    node->netname = net->netname;
-			    node->next = net->netnodes;
-			    net->netnodes = node;
-			    break;
+			    gridx++;
 			}
 		    }
-		    if (i < gateginfo->nodes) break;
+		    node->netnum = net->netnum;
+		    g->netnum[i] = net->netnum;
+		    g->noderec[i] = node;
+		    node->netname = net->netname;
+		    node->next = net->netnodes;
+		    net->netnodes = node;
+		    break;
 		}
 	    }
-	    if (!gateginfo)
-		LefError("Endpoint %s/%s of net %s not found\n",
-				instname, pinname, net->netname);
+	    if (i == gateginfo->nodes) gateginfo = NULL;	/* No such pin */
 	}
+	if (!gateginfo)
+	    LefError(f, "Endpoint %s/%s of net %s not found\n",
+				instname, pinname, net->netname);
     }
 }
 					   
@@ -469,7 +480,7 @@ enum def_netprop_keys {
 	DEF_NETPROP_PROPERTY};
 
 void
-DefReadNets(FILE *f, char *sname, float oscale, char special, int total)
+DefReadNets(LefFile *f, char *sname, float oscale, char special, int total)
 {
     char *token;
     int keyword, subkey;
@@ -525,7 +536,7 @@ DefReadNets(FILE *f, char *sname, float oscale, char special, int total)
 	keyword = Lookup(token, net_keys);
 	if (keyword < 0)
 	{
-	    LefError("Unknown keyword \"%s\" in NET "
+	    LefError(f, "Unknown keyword \"%s\" in NET "
 			"definition; ignoring.\n", token);
 	    LefEndStatement(f);
 	    continue;
@@ -549,6 +560,11 @@ DefReadNets(FILE *f, char *sname, float oscale, char special, int total)
 		net->netname = strdup(token);
 		net->netnodes = (NODE)NULL;
 		net->noripup = (NETLIST)NULL;
+		net->numnodes = 0;
+		net->routes = (ROUTE)NULL;
+		net->flags = (u_char)0;
+		net->guide = (int *)NULL;
+		net->numguide = 0;
 
 		net->next = Nlnets;
 		Nlnets = net;
@@ -582,7 +598,7 @@ DefReadNets(FILE *f, char *sname, float oscale, char special, int total)
 
 			node = (NODE)calloc(1, sizeof(struct node_));
 			node->nodenum = nodeidx++;
-			DefReadGatePin(net, node, instname, pinname, home);
+			DefReadGatePin(f, net, node, instname, pinname, home);
 
 			token = LefNextToken(f, TRUE);	/* should be ')' */
 
@@ -599,7 +615,7 @@ DefReadNets(FILE *f, char *sname, float oscale, char special, int total)
 		    subkey = Lookup(token, net_property_keys);
 		    if (subkey < 0)
 		    {
-			LefError("Unknown net property \"%s\" in "
+			LefError(f, "Unknown net property \"%s\" in "
 				"NET definition; ignoring.\n", token);
 			continue;
 		    }
@@ -629,8 +645,8 @@ DefReadNets(FILE *f, char *sname, float oscale, char special, int total)
 	    case DEF_NET_END:
 		if (!LefParseEndStatement(f, sname))
 		{
-		    LefError("Net END statement missing.\n");
-		    keyword = -1;
+		    LefError(f, "Net END statement missing.\n");
+		keyword = -1;
 		}
 		break;
 	}
@@ -656,7 +672,7 @@ DefReadNets(FILE *f, char *sname, float oscale, char special, int total)
 	fprintf(stdout, "  Processed %d%s nets total.\n", processed,
 		(special) ? " special" : "");
     else
-	LefError("Warning:  Number of nets read (%d) does not match "
+	LefError(f, "Warning:  Number of nets read (%d) does not match "
 		"the number declared (%d).\n", processed, total);
 }
 
@@ -683,7 +699,7 @@ enum def_orient {DEF_NORTH, DEF_SOUTH, DEF_EAST, DEF_WEST,
 int
 DefReadLocation(gate, f, oscale)
     GATE gate;
-    FILE *f;
+    LefFile *f;
     float oscale;
 {
     DSEG r;
@@ -710,7 +726,7 @@ DefReadLocation(gate, f, oscale)
     keyword = Lookup(token, orientations);
     if (keyword < 0)
     {
-	LefError("Unknown macro orientation \"%s\".\n", token);
+	LefError(f, "Unknown macro orientation \"%s\".\n", token);
 	return -1;
     }
 
@@ -734,7 +750,8 @@ DefReadLocation(gate, f, oscale)
 	case DEF_WEST:
 	case DEF_FLIPPED_EAST:
 	case DEF_FLIPPED_WEST:
-	    LefError("Error:  Cannot handle 90-degree rotated components!\n");
+	    LefError(f, "Error:  Cannot handle "
+			"90-degree rotated components!\n");
 	    break;
     }
 
@@ -748,7 +765,7 @@ DefReadLocation(gate, f, oscale)
     return 0;
 
 parse_error:
-    LefError("Cannot parse location: must be ( X Y ) orient\n");
+    LefError(f, "Cannot parse location: must be ( X Y ) orient\n");
     return -1;
 }
 
@@ -776,7 +793,7 @@ enum def_pins_prop_keys {
 	DEF_PINS_PROP_COVER};
 
 void
-DefReadPins(FILE *f, char *sname, float oscale, int total)
+DefReadPins(LefFile *f, char *sname, float oscale, int total)
 {
     char *token;
     char pinname[LEF_LINE_MAX];
@@ -830,7 +847,7 @@ DefReadPins(FILE *f, char *sname, float oscale, int total)
 
 	if (keyword < 0)
 	{
-	    LefError("Unknown keyword \"%s\" in PINS "
+	    LefError(f, "Unknown keyword \"%s\" in PINS "
 			"definition; ignoring.\n", token);
 	    LefEndStatement(f);
 	    continue;
@@ -848,8 +865,8 @@ DefReadPins(FILE *f, char *sname, float oscale, int total)
 		token = LefNextToken(f, TRUE);
 		if (sscanf(token, "%2047s", pinname) != 1)
 		{
-		    LefError("Bad pin statement:  Need pin name\n");
-		    LefEndStatement(f);
+		    LefError(f, "Bad pin statement:  Need pin name\n");
+		LefEndStatement(f);
 		    break;
 		}
 
@@ -875,7 +892,7 @@ DefReadPins(FILE *f, char *sname, float oscale, int total)
 		    subkey = Lookup(token, pin_property_keys);
 		    if (subkey < 0)
 		    {
-			LefError("Unknown pin property \"%s\" in "
+			LefError(f, "Unknown pin property \"%s\" in "
 				"PINS definition; ignoring.\n", token);
 			continue;
 		    }
@@ -891,7 +908,7 @@ DefReadPins(FILE *f, char *sname, float oscale, int total)
 			    token = LefNextToken(f, TRUE);
 			    subkey = Lookup(token, pin_classes);
 			    if (subkey < 0)
-				LefError("Unknown pin class\n");
+				LefError(f, "Unknown pin class\n");
 			    else
 				pinDir = lef_class_to_bitmask[subkey];
 			    break;
@@ -938,10 +955,11 @@ DefReadPins(FILE *f, char *sname, float oscale, int total)
 		    gate->vert = FALSE;
 		    gate->next = Nlgates;
 		    Nlgates = gate;
+		    HashInstall(gate->gatename, gate, &InstanceTable);
 		}
 		else {
-		    LefError("Pin %s is defined outside of route layer area!\n",
-				pinname);
+		    LefError(f, "Pin %s is defined outside of "
+				"route layer area!\n", pinname);
 		    free(gate);
 		}
 
@@ -950,8 +968,8 @@ DefReadPins(FILE *f, char *sname, float oscale, int total)
 	    case DEF_PINS_END:
 		if (!LefParseEndStatement(f, sname))
 		{
-		    LefError("Pins END statement missing.\n");
-		    keyword = -1;
+		    LefError(f, "Pins END statement missing.\n");
+		keyword = -1;
 		}
 		break;
 	}
@@ -961,7 +979,7 @@ DefReadPins(FILE *f, char *sname, float oscale, int total)
     if (processed == total)
 	fprintf(stdout, "  Processed %d pins total.\n", processed);
     else
-	LefError("Warning:  Number of pins read (%d) does not match "
+	LefError(f, "Warning:  Number of pins read (%d) does not match "
 		"the number declared (%d).\n", processed, total);
 }
  
@@ -989,7 +1007,7 @@ enum def_vias_prop_keys {
 
 void
 DefReadVias(f, sname, oscale, total)
-    FILE *f;
+    LefFile *f;
     char *sname;
     float oscale;
     int total;
@@ -1019,7 +1037,7 @@ DefReadVias(f, sname, oscale, total)
 
 	if (keyword < 0)
 	{
-	    LefError("Unknown keyword \"%s\" in VIAS "
+	    LefError(f, "Unknown keyword \"%s\" in VIAS "
 			"definition; ignoring.\n", token);
 	    LefEndStatement(f);
 	    continue;
@@ -1037,8 +1055,8 @@ DefReadVias(f, sname, oscale, total)
 		token = LefNextToken(f, TRUE);
 		if (sscanf(token, "%2047s", vianame) != 1)
 		{
-		    LefError("Bad via statement:  Need via name\n");
-		    LefEndStatement(f);
+		    LefError(f, "Bad via statement:  Need via name\n");
+		LefEndStatement(f);
 		    break;
 		}
 		lefl = LefFindLayer(token);
@@ -1062,8 +1080,8 @@ DefReadVias(f, sname, oscale, total)
 		}
 		else
 		{
-		    LefError("Warning:  Composite via \"%s\" redefined.\n", vianame);
-		    lefl = LefRedefined(lefl, vianame);
+		    LefError(f, "Warning:  Composite via \"%s\" redefined.\n", vianame);
+		lefl = LefRedefined(lefl, vianame);
 		}
 
 		/* Now do a search through the line for "+" entries	*/
@@ -1078,7 +1096,7 @@ DefReadVias(f, sname, oscale, total)
 		    subkey = Lookup(token, via_property_keys);
 		    if (subkey < 0)
 		    {
-			LefError("Unknown via property \"%s\" in "
+			LefError(f, "Unknown via property \"%s\" in "
 				"VIAS definition; ignoring.\n", token);
 			continue;
 		    }
@@ -1095,8 +1113,8 @@ DefReadVias(f, sname, oscale, total)
 	    case DEF_VIAS_END:
 		if (!LefParseEndStatement(f, sname))
 		{
-		    LefError("Vias END statement missing.\n");
-		    keyword = -1;
+		    LefError(f, "Vias END statement missing.\n");
+		keyword = -1;
 		}
 		break;
 	}
@@ -1106,7 +1124,7 @@ DefReadVias(f, sname, oscale, total)
     if (processed == total)
 	fprintf(stdout, "  Processed %d vias total.\n", processed);
     else
-	LefError("Warning:  Number of vias read (%d) does not match "
+	LefError(f, "Warning:  Number of vias read (%d) does not match "
 		"the number declared (%d).\n", processed, total);
 }
  
@@ -1136,7 +1154,7 @@ enum def_prop_keys {
 	DEF_PROP_EEQMASTER};
 
 void
-DefReadComponents(FILE *f, char *sname, float oscale, int total)
+DefReadComponents(LefFile *f, char *sname, float oscale, int total)
 {
     GATE gateginfo;
     GATE gate;
@@ -1144,7 +1162,6 @@ DefReadComponents(FILE *f, char *sname, float oscale, int total)
     char usename[512];
     int keyword, subkey, values, i;
     int processed = 0;
-    char OK;
     DSEG drect, newrect;
     double tmp, maxx, minx, maxy, miny;
 
@@ -1175,7 +1192,7 @@ DefReadComponents(FILE *f, char *sname, float oscale, int total)
 
 	if (keyword < 0)
 	{
-	    LefError("Unknown keyword \"%s\" in COMPONENT "
+	    LefError(f, "Unknown keyword \"%s\" in COMPONENT "
 			"definition; ignoring.\n", token);
 	    LefEndStatement(f);
 	    continue;
@@ -1193,23 +1210,17 @@ DefReadComponents(FILE *f, char *sname, float oscale, int total)
 		token = LefNextToken(f, TRUE);
 		if (sscanf(token, "%511s", usename) != 1)
 		{
-		    LefError("Bad component statement:  Need use and macro names\n");
-		    LefEndStatement(f);
+		    LefError(f, "Bad component statement:  Need use and macro names\n");
+		LefEndStatement(f);
 		    break;
 		}
 		token = LefNextToken(f, TRUE);
 
 		/* Find the corresponding macro */
-		OK = 0;
-		for (gateginfo = GateInfo; gateginfo; gateginfo = gateginfo->next) {
-		    if (!strcasecmp(gateginfo->gatetype, token)) {
-			OK = 1;
-			break;
-		    }
-		}
-		if (!OK) {
-		    LefError("Could not find a macro definition for \"%s\"\n",
-				token);
+		gateginfo = lefFindCell(token);
+		if (gateginfo == NULL) {
+		    LefError(f, "Could not find a macro "
+				"definition for \"%s\"\n", token);
 		    gate = NULL;
 		}
 		else {
@@ -1233,7 +1244,7 @@ DefReadComponents(FILE *f, char *sname, float oscale, int total)
 		    subkey = Lookup(token, property_keys);
 		    if (subkey < 0)
 		    {
-			LefError("Unknown component property \"%s\" in "
+			LefError(f, "Unknown component property \"%s\" in "
 				"COMPONENT definition; ignoring.\n", token);
 			continue;
 		    }
@@ -1385,14 +1396,15 @@ DefReadComponents(FILE *f, char *sname, float oscale, int total)
 		    }
 		    gate->next = Nlgates;
 		    Nlgates = gate;
+		    HashInstall(gate->gatename, gate, &InstanceTable);
 		}
 		break;
 
 	    case DEF_COMP_END:
 		if (!LefParseEndStatement(f, sname))
 		{
-		    LefError("Component END statement missing.\n");
-		    keyword = -1;
+		    LefError(f, "Component END statement missing.\n");
+		keyword = -1;
 		}
 
 		/* Finish final call by placing the cell use */
@@ -1409,7 +1421,7 @@ DefReadComponents(FILE *f, char *sname, float oscale, int total)
     if (processed == total)
 	fprintf(stdout, "  Processed %d subcell instances total.\n", processed);
     else
-	LefError("Warning:  Number of subcells read (%d) does not match "
+	LefError(f, "Warning:  Number of subcells read (%d) does not match "
 		"the number declared (%d).\n", processed, total);
 }
 
@@ -1446,7 +1458,7 @@ enum def_sections {DEF_VERSION = 0, DEF_NAMESCASESENSITIVE,
 float
 DefRead(char *inName)
 {
-    FILE *f;
+    LefFile *f;
     char filename[256];
     char *token;
     int keyword, dscale, total;
@@ -1456,6 +1468,7 @@ DefRead(char *inName)
     double start, step;
     double llx, lly, urx, ury;
     char corient = '.';
+    char gorient;
     DSEG diearea;
 
     static char *sections[] = {
@@ -1494,7 +1507,7 @@ DefRead(char *inName)
     else
 	strcpy(filename, inName);
    
-    f = fopen(filename, "r");
+    f = LefOpen(filename);
 
     if (f == NULL)
     {
@@ -1509,7 +1522,6 @@ DefRead(char *inName)
     fflush(stdout);
 
     oscale = 1;
-    lefCurrentLine = 0;
     v = h = -1;
 
     /* Read file contents */
@@ -1519,7 +1531,8 @@ DefRead(char *inName)
 	keyword = Lookup(token, sections);
 	if (keyword < 0)
 	{
-	    LefError("Unknown keyword \"%s\" in DEF file; ignoring.\n", token);
+	    LefError(f, "Unknown keyword \"%s\" in DEF file; ignoring.\n",
+			token);
 	    LefEndStatement(f);
 	    continue;
 	}
@@ -1588,8 +1601,8 @@ DefRead(char *inName)
 		token = LefNextToken(f, TRUE);
 		if (sscanf(token, "%d", &dscale) != 1)
 		{
-		    LefError("Invalid syntax for UNITS statement.\n");
-		    LefError("Assuming default value of 100\n");
+		    LefError(f, "Invalid syntax for UNITS statement.\n");
+		LefError(f, "Assuming default value of 100\n");
 		    dscale = 100;
 		}
 		/* We don't care if the scale is 100, 200, 1000, or 2000. */
@@ -1603,28 +1616,29 @@ DefRead(char *inName)
 	    case DEF_TRACKS:
 		token = LefNextToken(f, TRUE);
 		if (strlen(token) != 1) {
-		    LefError("Problem parsing track orientation (X or Y).\n");
+		    LefError(f, "Problem parsing track "
+				"orientation (X or Y).\n");
 		}
 		corient = tolower(token[0]);	// X or Y
 		token = LefNextToken(f, TRUE);
 		if (sscanf(token, "%lg", &start) != 1) {
-		    LefError("Problem parsing track start position.\n");
+		    LefError(f, "Problem parsing track start position.\n");
 		}
 		token = LefNextToken(f, TRUE);
 		if (strcmp(token, "DO")) {
-		    LefError("TRACKS missing DO loop.\n");
+		    LefError(f, "TRACKS missing DO loop.\n");
 		}
 		token = LefNextToken(f, TRUE);
 		if (sscanf(token, "%d", &channels) != 1) {
-		    LefError("Problem parsing number of track channels.\n");
+		    LefError(f, "Problem parsing number of track channels.\n");
 		}
 		token = LefNextToken(f, TRUE);
 		if (strcmp(token, "STEP")) {
-		    LefError("TRACKS missing STEP size.\n");
+		    LefError(f, "TRACKS missing STEP size.\n");
 		}
 		token = LefNextToken(f, TRUE);
 		if (sscanf(token, "%lg", &step) != 1) {
-		    LefError("Problem parsing track step size.\n");
+		    LefError(f, "Problem parsing track step size.\n");
 		}
 		token = LefNextToken(f, TRUE);
 		if (!strcmp(token, "LAYER")) {
@@ -1662,6 +1676,33 @@ DefRead(char *inName)
 		LefEndStatement(f);
 		break;
 	    case DEF_GCELLGRID:
+		token = LefNextToken(f, TRUE);
+		if (strlen(token) != 1) {
+		    LefError(f, "Problem parsing gcell grid orientation (X or Y).\n");
+		}
+		gorient = tolower(token[0]);	// X or Y
+		token = LefNextToken(f, TRUE);
+		if (sscanf(token, "%lg", &start) != 1) {
+		    LefError(f, "Problem parsing gcell grid start position.\n");
+		}
+		token = LefNextToken(f, TRUE);
+		if (strcmp(token, "DO")) {
+		    LefError(f, "GCELLGRID missing DO loop.\n");
+		}
+		token = LefNextToken(f, TRUE);
+		if (sscanf(token, "%d", &channels) != 1) {
+		    LefError(f, "Problem parsing number of "
+				"gcell grid lines.\n");
+		}
+		token = LefNextToken(f, TRUE);
+		if (strcmp(token, "STEP")) {
+		    LefError(f, "GCELLGRID missing STEP size.\n");
+		}
+		token = LefNextToken(f, TRUE);
+		if (sscanf(token, "%lg", &step) != 1) {
+		    LefError(f, "Problem parsing gcell grid step size.\n");
+		}
+		gcell_add_lines(gorient, start / oscale, channels, step / oscale);
 		LefEndStatement(f);
 		break;
 	    case DEF_DIVIDERCHAR:
@@ -1719,7 +1760,7 @@ DefRead(char *inName)
 		if (sscanf(token, "%d", &total) != 1) total = 0;
 		LefEndStatement(f);
 		if (total > MAX_NETNUMS) {
-		   LefError("Number of nets in design (%d) exceeds maximum (%d)\n",
+		   LefError(f, "Number of nets in design (%d) exceeds maximum (%d)\n",
 				total, MAX_NETNUMS);
 		}
 		DefReadNets(f, sections[DEF_NETS], oscale, FALSE, total);
@@ -1742,18 +1783,18 @@ DefRead(char *inName)
 	    case DEF_END:
 		if (!LefParseEndStatement(f, "DESIGN"))
 		{
-		    LefError("END statement out of context.\n");
-		    keyword = -1;
+		    LefError(f, "END statement out of context.\n");
+		keyword = -1;
 		}
 		break;
 	}
 	if (keyword == DEF_END) break;
     }
-    fprintf(stdout, "DEF read: Processed %d lines.\n", lefCurrentLine);
-    LefError(NULL);	/* print statement of errors, if any, and reset */
+    fprintf(stdout, "DEF read: Processed %d lines.\n", f->line);
+    LefError(f, NULL);	/* print statement of errors, if any, and reset */
 
     /* Cleanup */
 
-    if (f != NULL) fclose(f);
+    if (f != NULL) LefClose(f);
     return oscale;
 }
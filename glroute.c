@@ -0,0 +1,576 @@
+/*--------------------------------------------------------------*/
+/* glroute.c -- coarse global router.				*/
+/*								*/
+/* The route area is divided into gcells, either from the DEF	*/
+/* GCELLGRID statements or by tiling the grid at a fixed number	*/
+/* of tracks.  All nets are routed on the gcell graph with a	*/
+/* cost for crossing gcell edges beyond their track capacity,	*/
+/* and nets crossing overflowed edges are rerouted a few times	*/
+/* with an increasing history cost on those edges.  The gcells	*/
+/* used by each net are kept in the net record as its "guide",	*/
+/* which createMask() turns into the search area mask for the	*/
+/* detail router.						*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "qrouter.h"
+#include "config.h"
+#include "node.h"
+#include "maze.h"
+#include "lef.h"
+#include "glroute.h"
+
+#define GLOBAL_STEP	4	// Cost of crossing a gcell edge
+#define GLOBAL_OVER	16	// Added cost per net over edge capacity
+#define GLOBAL_HIST	4	// History cost added to overflowed edges
+#define GLOBAL_ITERS	4	// Maximum number of reroute iterations
+
+// GCELLGRID lines read from the DEF file, in microns
+
+static double *GLinesX = NULL;
+static double *GLinesY = NULL;
+static int NumGLinesX = 0, MaxGLinesX = 0;
+static int NumGLinesY = 0, MaxGLinesY = 0;
+
+// The gcell array.  Gcell (c, r) is tile number r * NumTilesX + c.
+// TileX[l][c] is the first grid column of gcell column c on layer l
+// (with TileX[l][NumTilesX] == NumChannelsX[l]), and ColOf[l][x] is
+// the gcell column of grid column x.  Likewise for rows.
+
+static int NumTilesX = 0;
+static int NumTilesY = 0;
+static int *TileX[MAX_LAYERS];
+static int *TileY[MAX_LAYERS];
+static int *ColOf[MAX_LAYERS];
+static int *RowOf[MAX_LAYERS];
+
+// Gcell edges.  Edge 2 * t joins tile t to its east neighbor, and
+// edge 2 * t + 1 joins tile t to its north neighbor.
+
+static int *GCap = NULL;	// Number of free tracks crossing the edge
+static int *GUse = NULL;	// Number of nets crossing the edge
+static int *GHist = NULL;	// History cost of the edge
+
+// Search scratch space, one entry per tile.  Entries are valid only
+// where the stamp matches the current search or net.
+
+static u_int *GDist = NULL;
+static u_char *GPred = NULL;
+static u_int *GSearch = NULL;	// Search which last set GDist
+static u_int *GInTree = NULL;	// Net whose route tree has the tile
+static u_int *GIsTerm = NULL;	// Net which has a terminal in the tile
+static u_int GSearchStamp = 0;
+static u_int GNetStamp = 0;
+
+// Route of each net on the gcell graph, as a list of edges
+
+typedef struct gnet_ {
+   NET net;
+   int *edges;
+   int numedges;
+} GNET;
+
+static GNET *GNets = NULL;
+static int NumGNets = 0;
+
+/*--------------------------------------------------------------*/
+/* gcell_add_lines() ---					*/
+/*								*/
+/* Record "num" gcell boundary lines in orientation "orient"	*/
+/* ('x' or 'y') starting at "start" and spaced by "step", all	*/
+/* in microns, from a DEF GCELLGRID statement.			*/
+/*--------------------------------------------------------------*/
+
+void gcell_add_lines(char orient, double start, int num, double step)
+{
+   double **lines;
+   int *numlines, *maxlines;
+   int i;
+
+   if (orient == 'x') {
+      lines = &GLinesX;
+      numlines = &NumGLinesX;
+      maxlines = &MaxGLinesX;
+   }
+   else {
+      lines = &GLinesY;
+      numlines = &NumGLinesY;
+      maxlines = &MaxGLinesY;
+   }
+
+   for (i = 0; i < num; i++) {
+      if (*numlines == *maxlines) {
+	 *maxlines = (*maxlines == 0) ? 64 : (*maxlines << 1);
+	 *lines = (double *)realloc(*lines, *maxlines * sizeof(double));
+      }
+      (*lines)[(*numlines)++] = start + i * step;
+   }
+}
+
+/*--------------------------------------------------------------*/
+/* Comparison of boundary positions for qsort()			*/
+/*--------------------------------------------------------------*/
+
+static int gcell_cmp(const void *a, const void *b)
+{
+   double p = *(double *)a;
+   double q = *(double *)b;
+
+   return (p < q) ? -1 : (p > q) ? 1 : 0;
+}
+
+/*--------------------------------------------------------------*/
+/* gcell_tiles() ---						*/
+/*								*/
+/* Set up the gcell columns (or rows) of each layer along one	*/
+/* axis.  "lines" are the GCELLGRID boundaries, if any;		*/
+/* otherwise gcells are "tile" tracks of layer 0 wide.  Returns	*/
+/* the number of gcells along the axis.				*/
+/*--------------------------------------------------------------*/
+
+static int gcell_tiles(double *lines, int numlines, double lower,
+		double *pitch, int *numchannels, int tile,
+		int **tilepos, int **tileof)
+{
+   double *bounds, pos;
+   int numbounds, ntiles, i, j, l, g;
+
+   // Collect the boundaries strictly inside the route area, sorted,
+   // with duplicates removed.  The route area itself is the first
+   // gcell boundary.
+
+   if (numlines > 0) {
+      bounds = (double *)malloc((numlines + 1) * sizeof(double));
+      qsort(lines, numlines, sizeof(double), gcell_cmp);
+      numbounds = 0;
+      bounds[numbounds++] = lower;
+      for (i = 0; i < numlines; i++) {
+	 if (lines[i] <= bounds[numbounds - 1] + EPS) continue;
+	 if (lines[i] >= lower + (numchannels[0] - 0.5) * pitch[0]) break;
+	 bounds[numbounds++] = lines[i];
+      }
+   }
+   else {
+      numbounds = (numchannels[0] + tile - 1) / tile;
+      bounds = (double *)malloc(numbounds * sizeof(double));
+      for (i = 0; i < numbounds; i++)
+	 bounds[i] = lower + (i * tile - 0.5) * pitch[0];
+   }
+   ntiles = numbounds;
+
+   // Grid column i of layer l is at lower + i * pitch[l], and belongs
+   // to the last gcell whose boundary is not beyond it.
+
+   for (l = 0; l < Num_layers; l++) {
+      tilepos[l] = (int *)malloc((ntiles + 1) * sizeof(int));
+      tileof[l] = (int *)malloc(numchannels[l] * sizeof(int));
+      g = 0;
+      tilepos[l][0] = 0;
+      for (j = 0; j < numchannels[l]; j++) {
+	 pos = lower + j * pitch[l];
+	 while ((g < ntiles - 1) && (pos >= bounds[g + 1] - EPS))
+	    tilepos[l][++g] = j;
+	 tileof[l][j] = g;
+      }
+      while (g < ntiles) tilepos[l][++g] = numchannels[l];
+   }
+   free(bounds);
+   return ntiles;
+}
+
+/*--------------------------------------------------------------*/
+/* gcell_bounds() ---						*/
+/*								*/
+/* Return in (x1, y1) to (x2, y2) the grid positions covered by	*/
+/* gcell "tile" on layer "lay".  The range is empty (x2 < x1 or	*/
+/* y2 < y1) if the gcell is narrower than the track pitch.	*/
+/*--------------------------------------------------------------*/
+
+void gcell_bounds(int tile, int lay, int *x1, int *y1, int *x2, int *y2)
+{
+   int c = tile % NumTilesX;
+   int r = tile / NumTilesX;
+
+   *x1 = TileX[lay][c];
+   *x2 = TileX[lay][c + 1] - 1;
+   *y1 = TileY[lay][r];
+   *y2 = TileY[lay][r + 1] - 1;
+}
+
+/*--------------------------------------------------------------*/
+/* gcell_capacity() ---						*/
+/*								*/
+/* Count the free tracks crossing each gcell edge.  Horizontal	*/
+/* layers cross east edges and vertical layers cross north	*/
+/* edges.  A track is counted if its grid position just across	*/
+/* the edge is not obstructed or already routed.		*/
+/*--------------------------------------------------------------*/
+
+static void gcell_capacity()
+{
+   int c, r, t, l, x, y;
+   u_int obs;
+
+   for (r = 0; r < NumTilesY; r++) {
+      for (c = 0; c < NumTilesX; c++) {
+	 t = r * NumTilesX + c;
+	 GCap[2 * t] = GCap[2 * t + 1] = 0;
+	 for (l = 0; l < Num_layers; l++) {
+	    if (LefGetRouteOrientation(l) == 1) {
+	       if (c == NumTilesX - 1) continue;
+	       x = TileX[l][c + 1];
+	       if (x >= NumChannelsX[l]) continue;
+	       for (y = TileY[l][r]; y < TileY[l][r + 1]; y++) {
+		  obs = Obs[l][OGRID(x, y, l)];
+		  if (!(obs & (NO_NET | ROUTED_NET))) GCap[2 * t]++;
+	       }
+	    }
+	    else {
+	       if (r == NumTilesY - 1) continue;
+	       y = TileY[l][r + 1];
+	       if (y >= NumChannelsY[l]) continue;
+	       for (x = TileX[l][c]; x < TileX[l][c + 1]; x++) {
+		  obs = Obs[l][OGRID(x, y, l)];
+		  if (!(obs & (NO_NET | ROUTED_NET))) GCap[2 * t + 1]++;
+	       }
+	    }
+	 }
+      }
+   }
+}
+
+/*--------------------------------------------------------------*/
+/* gcell_edge_cost() ---					*/
+/*								*/
+/* Cost for one more net to cross gcell edge "e".		*/
+/*--------------------------------------------------------------*/
+
+static u_int gcell_edge_cost(int e)
+{
+   u_int cost = GLOBAL_STEP + GHist[e];
+
+   if (GUse[e] >= GCap[e])
+      cost += GLOBAL_OVER * (GUse[e] - GCap[e] + 1);
+   return cost;
+}
+
+/*--------------------------------------------------------------*/
+/* gcell_route_net() ---					*/
+/*								*/
+/* Route net "gn" on the gcell graph.  Starting from the gcell	*/
+/* of the first node, the cheapest path from the route tree to	*/
+/* the nearest gcell holding an unconnected node is added to	*/
+/* the tree until all nodes are connected.  The edges used are	*/
+/* recorded in "gn" and their usage is updated, and the gcells	*/
+/* of the tree become the net's guide.				*/
+/*--------------------------------------------------------------*/
+
+static void gcell_route_net(GNET *gn)
+{
+   NET net = gn->net;
+   NODE node;
+   DPOINT tap;
+   PQUEUE frontier;
+   POINT gpoint;
+   int *tree, numtree, numterms, maxedges;
+   int t, n, e, i, c, r, dir;
+   u_int cost, newcost;
+
+   reset_points();
+   GNetStamp++;
+
+   tree = (int *)malloc(NumTilesX * NumTilesY * sizeof(int));
+   numtree = 0;
+   numterms = 0;
+
+   // Mark the gcells of the net's nodes.  The first one starts the
+   // route tree.
+
+   for (node = net->netnodes; node != NULL; node = node->next) {
+      tap = (node->taps == NULL) ? node->extend : node->taps;
+      if (tap == NULL) continue;
+      t = RowOf[tap->layer][tap->gridy] * NumTilesX
+		+ ColOf[tap->layer][tap->gridx];
+      if (numtree == 0) {
+	 GInTree[t] = GNetStamp;
+	 tree[numtree++] = t;
+      }
+      else if ((GIsTerm[t] != GNetStamp) && (GInTree[t] != GNetStamp))
+	 numterms++;
+      GIsTerm[t] = GNetStamp;
+   }
+
+   maxedges = 0;
+   while (numterms > 0) {
+
+      GSearchStamp++;
+      pqueue_init(&frontier);
+      for (i = 0; i < numtree; i++) {
+	 t = tree[i];
+	 GSearch[t] = GSearchStamp;
+	 GDist[t] = 0;
+	 pqueue_push(&frontier, t % NumTilesX, t / NumTilesX, 0, 0);
+      }
+
+      while ((gpoint = pqueue_pop(&frontier, (u_int)MAXRT, &cost)) != NULL) {
+	 c = gpoint->x1;
+	 r = gpoint->y1;
+	 free_point(gpoint);
+	 t = r * NumTilesX + c;
+	 if (cost > GDist[t]) continue;		// Stale entry
+
+	 if ((GIsTerm[t] == GNetStamp) && (GInTree[t] != GNetStamp)) break;
+
+	 for (dir = 0; dir < 4; dir++) {
+	    switch (dir) {
+	       case 0:		// East
+		  if (c == NumTilesX - 1) continue;
+		  n = t + 1;
+		  e = 2 * t;
+		  break;
+	       case 1:		// West
+		  if (c == 0) continue;
+		  n = t - 1;
+		  e = 2 * n;
+		  break;
+	       case 2:		// North
+		  if (r == NumTilesY - 1) continue;
+		  n = t + NumTilesX;
+		  e = 2 * t + 1;
+		  break;
+	       case 3:		// South
+		  if (r == 0) continue;
+		  n = t - NumTilesX;
+		  e = 2 * n + 1;
+		  break;
+	       default:
+		  continue;
+	    }
+	    newcost = cost + gcell_edge_cost(e);
+	    if ((GSearch[n] != GSearchStamp) || (newcost < GDist[n])) {
+	       GSearch[n] = GSearchStamp;
+	       GDist[n] = newcost;
+	       GPred[n] = dir;
+	       pqueue_push(&frontier, n % NumTilesX, n / NumTilesX, 0, newcost);
+	    }
+	 }
+      }
+      pqueue_free(&frontier);
+      if (gpoint == NULL) break;	// Cannot happen;  all gcells connect
+
+      // Walk back to the tree, claiming the edges on the way
+
+      while (GInTree[t] != GNetStamp) {
+	 GInTree[t] = GNetStamp;
+	 tree[numtree++] = t;
+	 if (GIsTerm[t] == GNetStamp) numterms--;
+
+	 switch (GPred[t]) {
+	    default:		// Only 0 to 3 are set
+	    case 0: n = t - 1; e = 2 * n; break;
+	    case 1: n = t + 1; e = 2 * t; break;
+	    case 2: n = t - NumTilesX; e = 2 * n + 1; break;
+	    case 3: n = t + NumTilesX; e = 2 * t + 1; break;
+	 }
+	 if (gn->numedges == maxedges) {
+	    maxedges = (maxedges == 0) ? 16 : (maxedges << 1);
+	    gn->edges = (int *)realloc(gn->edges, maxedges * sizeof(int));
+	 }
+	 gn->edges[gn->numedges++] = e;
+	 GUse[e]++;
+	 t = n;
+      }
+   }
+
+   if (numtree == 0) {
+      free(tree);
+      tree = NULL;
+   }
+   else
+      tree = (int *)realloc(tree, numtree * sizeof(int));
+   net->guide = tree;
+   net->numguide = numtree;
+}
+
+/*--------------------------------------------------------------*/
+/* gcell_ripup_net() ---					*/
+/*								*/
+/* Remove the gcell route of "gn", freeing its edges.		*/
+/*--------------------------------------------------------------*/
+
+static void gcell_ripup_net(GNET *gn)
+{
+   int i;
+
+   for (i = 0; i < gn->numedges; i++)
+      GUse[gn->edges[i]]--;
+   free(gn->edges);
+   gn->edges = NULL;
+   gn->numedges = 0;
+
+   free(gn->net->guide);
+   gn->net->guide = NULL;
+   gn->net->numguide = 0;
+}
+
+/*--------------------------------------------------------------*/
+/* gcell_overflow() ---						*/
+/*								*/
+/* Return the number of gcell edges used by more nets than	*/
+/* they have tracks.  If "hist" is set, add to the history	*/
+/* cost of each of these edges.					*/
+/*--------------------------------------------------------------*/
+
+static int gcell_overflow(u_char hist)
+{
+   int e, over = 0;
+
+   for (e = 0; e < 2 * NumTilesX * NumTilesY; e++) {
+      if (GUse[e] > GCap[e]) {
+	 over++;
+	 if (hist) GHist[e] += GLOBAL_HIST;
+      }
+   }
+   return over;
+}
+
+/*--------------------------------------------------------------*/
+/* global_route() ---						*/
+/*								*/
+/* Route all nets on the gcell graph and leave a guide in each	*/
+/* net record for the detail router.  Gcells come from the DEF	*/
+/* GCELLGRID, or are GlobalTile tracks wide if there was none.	*/
+/* Power and ground nets, which the detail router treats as	*/
+/* buses, are not given a guide.				*/
+/*								*/
+/* Returns the number of gcell edges left overflowed.		*/
+/*--------------------------------------------------------------*/
+
+int global_route()
+{
+   NET net;
+   int i, j, t, ntiles, over, iter;
+   u_char rip;
+
+   NumTilesX = gcell_tiles(GLinesX, NumGLinesX, Xlowerbound, PitchX,
+		NumChannelsX, GlobalTile, TileX, ColOf);
+   NumTilesY = gcell_tiles(GLinesY, NumGLinesY, Ylowerbound, PitchY,
+		NumChannelsY, GlobalTile, TileY, RowOf);
+   ntiles = NumTilesX * NumTilesY;
+
+   GCap = (int *)malloc(2 * ntiles * sizeof(int));
+   GUse = (int *)calloc(2 * ntiles, sizeof(int));
+   GHist = (int *)calloc(2 * ntiles, sizeof(int));
+   GDist = (u_int *)malloc(ntiles * sizeof(u_int));
+   GPred = (u_char *)malloc(ntiles * sizeof(u_char));
+   GSearch = (u_int *)calloc(ntiles, sizeof(u_int));
+   GInTree = (u_int *)calloc(ntiles, sizeof(u_int));
+   GIsTerm = (u_int *)calloc(ntiles, sizeof(u_int));
+
+   gcell_capacity();
+
+   // Collect the nets in routing order
+
+   GNets = (GNET *)malloc(Numnets * sizeof(GNET));
+   NumGNets = 0;
+   for (i = 0; i < Numnets; i++) {
+      net = getnettoroute(i);
+      if ((net == NULL) || (net->netnodes == NULL)) continue;
+      if ((net->netnum == VDD_NET) || (net->netnum == GND_NET)) continue;
+      GNets[NumGNets].net = net;
+      GNets[NumGNets].edges = NULL;
+      GNets[NumGNets].numedges = 0;
+      NumGNets++;
+   }
+
+   for (i = 0; i < NumGNets; i++)
+      gcell_route_net(&GNets[i]);
+   over = gcell_overflow(TRUE);
+
+   // Reroute every net crossing an overflowed edge, with the history
+   // cost steering it away from edges that were overflowed before.
+
+   for (iter = 0; (iter < GLOBAL_ITERS) && (over > 0); iter++) {
+      for (i = 0; i < NumGNets; i++) {
+	 rip = FALSE;
+	 for (j = 0; j < GNets[i].numedges; j++) {
+	    t = GNets[i].edges[j];
+	    if (GUse[t] > GCap[t]) {
+	       rip = TRUE;
+	       break;
+	    }
+	 }
+	 if (rip) {
+	    gcell_ripup_net(&GNets[i]);
+	    gcell_route_net(&GNets[i]);
+	 }
+      }
+      over = gcell_overflow(TRUE);
+   }
+
+   fprintf(stdout, "Global route: %d x %d gcells, %d nets, "
+		"%d edges overflowed after %d reroutes\n",
+		NumTilesX, NumTilesY, NumGNets, over, iter);
+
+   // Only the guides and the gcell bounds (see gcell_bounds()) are
+   // needed by the detail router.
+
+   for (i = 0; i < NumGNets; i++) free(GNets[i].edges);
+   free(GNets);
+   GNets = NULL;
+   NumGNets = 0;
+   free(GCap);
+   free(GUse);
+   free(GHist);
+   free(GDist);
+   free(GPred);
+   free(GSearch);
+   free(GInTree);
+   free(GIsTerm);
+   GCap = GUse = GHist = NULL;
+   GDist = NULL;
+   GPred = NULL;
+   GSearch = GInTree = GIsTerm = NULL;
+   for (i = 0; i < Num_layers; i++) {
+      free(ColOf[i]);
+      free(RowOf[i]);
+      ColOf[i] = RowOf[i] = NULL;
+   }
+   free(GLinesX);
+   free(GLinesY);
+   GLinesX = GLinesY = NULL;
+   NumGLinesX = MaxGLinesX = NumGLinesY = MaxGLinesY = 0;
+
+   return over;
+}
+
+/*--------------------------------------------------------------*/
+/* gcell_free() ---						*/
+/*								*/
+/* Free the guides left in the net records by global_route()	*/
+/* and the gcell bounds, once detail routing is done.		*/
+/*--------------------------------------------------------------*/
+
+void gcell_free()
+{
+   NET net;
+   int l;
+
+   for (net = Nlnets; net; net = net->next) {
+      free(net->guide);
+      net->guide = NULL;
+      net->numguide = 0;
+   }
+   for (l = 0; l < Num_layers; l++) {
+      free(TileX[l]);
+      free(TileY[l]);
+      TileX[l] = TileY[l] = NULL;
+   }
+   NumTilesX = NumTilesY = 0;
+}
+
+/* end of glroute.c */
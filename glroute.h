@@ -0,0 +1,15 @@
+/*--------------------------------------------------------------*/
+/* glroute.h -- coarse global router over the gcell grid	*/
+/*--------------------------------------------------------------*/
+
+#ifndef GLROUTE_H
+
+void	gcell_add_lines(char orient, double start, int num, double step);
+void	gcell_bounds(int tile, int lay, int *x1, int *y1, int *x2, int *y2);
+int	global_route();
+void	gcell_free();
+
+#define GLROUTE_H
+#endif 
+
+/* end of glroute.h */
@@ -0,0 +1,325 @@
+/*--------------------------------------------------------------*/
+/* grid.c -- storage of the per-layer route grid arrays.	*/
+/*								*/
+/* Each array indexed by OGRID() (Obs, Obs2, Stub, Nodeid,	*/
+/* etc.) is kept as one block for all layers, divided into	*/
+/* tiles of GRID_TILE x GRID_TILE grid positions.  Within a	*/
+/* tile, positions are stored row by row, and the tiles of all	*/
+/* layers at the same place follow each other.  So a step in	*/
+/* any direction, including up or down a layer, mostly stays	*/
+/* within a few cache lines of the current position.  The	*/
+/* array for layer "lay" points at the start of its tile in	*/
+/* the block, and OGRID() gives the same offset on all layers.	*/
+/*								*/
+/* All arrays are allocated, cleared and freed here, and a	*/
+/* record is kept of each, so that the layout can be changed	*/
+/* without changing the code that uses the arrays.  The macros	*/
+/* OGRID_EAST() etc. in qrouter.h step between neighboring	*/
+/* positions, and grid_index() checks positions against the	*/
+/* size of each layer in a -DGRID_DEBUG build.			*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "qrouter.h"
+#include "config.h"
+#include "grid.h"
+
+int GridTilesX = 0;	// Number of tiles across the grid
+int GridTilesY = 0;	// Number of tiles up the grid
+int GridStride = 0;	// Positions from one tile to the next (all layers)
+int GridRowStride = 0;	// Positions from one row of tiles to the next
+
+static GRIDPLANE GridPlanes[GRID_MAXPLANES];	// Arrays now allocated
+static int GridNumPlanes = 0;
+
+/*--------------------------------------------------------------*/
+/* grid_init() ---						*/
+/*								*/
+/* Set the tile layout from the grid size.  All layers share	*/
+/* the layout, so it covers the largest layer.  Must be called	*/
+/* after set_num_channels() and before any grid_alloc().	*/
+/*--------------------------------------------------------------*/
+
+void grid_init()
+{
+   int i, maxx = 0, maxy = 0;
+
+   for (i = 0; i < Num_layers; i++) {
+      if (NumChannelsX[i] > maxx) maxx = NumChannelsX[i];
+      if (NumChannelsY[i] > maxy) maxy = NumChannelsY[i];
+   }
+   GridTilesX = (maxx + GRID_TILE - 1) >> GRID_TILE_BITS;
+   GridTilesY = (maxy + GRID_TILE - 1) >> GRID_TILE_BITS;
+   GridStride = Num_layers * GRID_TILE * GRID_TILE;
+   GridRowStride = GridTilesX * GridStride;
+}
+
+/*--------------------------------------------------------------*/
+/* grid_find() ---						*/
+/*								*/
+/* Return the record of the array allocated to "planes", or	*/
+/* NULL if there is none.					*/
+/*--------------------------------------------------------------*/
+
+static GRIDPLANE *grid_find(void **planes)
+{
+   int i;
+
+   for (i = 0; i < GridNumPlanes; i++)
+      if (GridPlanes[i].planes == planes)
+	 return &GridPlanes[i];
+   return NULL;
+}
+
+/*--------------------------------------------------------------*/
+/* grid_alloc() ---						*/
+/*								*/
+/* Allocate a zeroed array of elements of "size" bytes for	*/
+/* every layer, and set planes[lay] to the array of each	*/
+/* layer.  The array is recorded under "name" until released	*/
+/* by grid_free().  Returns 0 on success, or -1 if out of	*/
+/* memory.							*/
+/*--------------------------------------------------------------*/
+
+int grid_alloc(void **planes, size_t size, char *name)
+{
+   GRIDPLANE *gp;
+   char *block;
+   int i;
+
+   if (GridNumPlanes == GRID_MAXPLANES) return -1;
+
+   block = (char *)calloc((size_t)GridTilesX * GridTilesY * GridStride, size);
+   if (block == NULL) return -1;
+
+   for (i = 0; i < Num_layers; i++)
+      planes[i] = (void *)(block + (size_t)i * GRID_TILE * GRID_TILE * size);
+
+   gp = &GridPlanes[GridNumPlanes++];
+   gp->planes = planes;
+   gp->size = size;
+   gp->name = name;
+   return 0;
+}
+
+/*--------------------------------------------------------------*/
+/* grid_clear() ---						*/
+/*								*/
+/* Zero the array of every layer.				*/
+/*--------------------------------------------------------------*/
+
+void grid_clear(void **planes)
+{
+   GRIDPLANE *gp = grid_find(planes);
+
+   if (gp == NULL) return;
+   memset(planes[0], 0, (size_t)GridTilesX * GridTilesY * GridStride * gp->size);
+}
+
+/*--------------------------------------------------------------*/
+/* grid_free() ---						*/
+/*								*/
+/* Release the arrays allocated by grid_alloc().		*/
+/*--------------------------------------------------------------*/
+
+void grid_free(void **planes)
+{
+   GRIDPLANE *gp = grid_find(planes);
+   int i;
+
+   if (gp == NULL) return;
+   free(planes[0]);
+   for (i = 0; i < Num_layers; i++) planes[i] = NULL;
+   *gp = GridPlanes[--GridNumPlanes];
+}
+
+/*--------------------------------------------------------------*/
+/* grid_memory() ---						*/
+/*								*/
+/* Return the number of bytes held by all grid arrays, and	*/
+/* list them if Verbose is set.					*/
+/*--------------------------------------------------------------*/
+
+size_t grid_memory()
+{
+   size_t total = 0, bytes;
+   int i;
+
+   for (i = 0; i < GridNumPlanes; i++) {
+      bytes = (size_t)GridTilesX * GridTilesY * GridStride * GridPlanes[i].size;
+      if (Verbose > 0)
+	 fprintf(stdout, "Grid array %s: %lu bytes\n", GridPlanes[i].name,
+		(unsigned long)bytes);
+      total += bytes;
+   }
+   return total;
+}
+
+/*--------------------------------------------------------------*/
+/* grid_index() ---						*/
+/*								*/
+/* OGRID() with a check that (x, y) lies inside the grid of	*/
+/* layer "lay".  Used in place of OGRID() when compiled with	*/
+/* -DGRID_DEBUG.  An out-of-range position is reported and	*/
+/* the program stops, so that it can be caught in a debugger.	*/
+/*--------------------------------------------------------------*/
+
+int grid_index(int x, int y, int lay)
+{
+   if ((lay < 0) || (lay >= Num_layers) || (x < 0) || (y < 0) ||
+		(x >= NumChannelsX[lay]) || (y >= NumChannelsY[lay])) {
+      fprintf(stderr, "Grid position (%d %d %d) out of range!\n", x, y, lay);
+      abort();
+   }
+   return GRID_OFFSET(x, y);
+}
+
+/*--------------------------------------------------------------*/
+/* grid_match_row() ---						*/
+/*								*/
+/* Compare the GRID_TILE entries of one row of a tile, starting	*/
+/* at "row", against "value" under "mask".  Bit i of the result	*/
+/* is set if (row[i] & mask) == value.  Rows are contiguous in	*/
+/* the tiled layout, so a window of an array can be searched a	*/
+/* row at a time, and rows with no match skipped without a	*/
+/* branch per position.  Uses SSE2 where available.		*/
+/*--------------------------------------------------------------*/
+
+u_int grid_match_row(u_int *row, u_int mask, u_int value)
+{
+#if defined(__SSE2__) && (GRID_TILE == 8)
+   __m128i m = _mm_set1_epi32((int)mask);
+   __m128i v = _mm_set1_epi32((int)value);
+   __m128i lo, hi;
+
+   lo = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128((__m128i *)row), m), v);
+   hi = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128((__m128i *)(row + 4)),
+		m), v);
+   return (u_int)(_mm_movemask_ps(_mm_castsi128_ps(lo)) |
+		(_mm_movemask_ps(_mm_castsi128_ps(hi)) << 4));
+#else
+   u_int bits = 0;
+   int i;
+
+   for (i = 0; i < GRID_TILE; i++)
+      bits |= (u_int)((row[i] & mask) == value) << i;
+   return bits;
+#endif
+}
+
+/*--------------------------------------------------------------*/
+/* Sparse arrays.  Stub and Obsinfo hold values only near pins,	*/
+/* so they are kept in a hash table instead of a full array.	*/
+/* An entry is keyed on the position that (x, y, lay) would	*/
+/* have in the block of a full array, plus one, so that key 0	*/
+/* marks an empty slot.  Positions never set read as 0.0.	*/
+/*--------------------------------------------------------------*/
+
+#define SGRID_KEY(x, y, lay) ((u_int)GRID_OFFSET(x, y) + \
+		(u_int)(lay) * GRID_TILE * GRID_TILE + 1)
+#define SGRID_HASH(key, size) (((key) * 2654435761U) & ((size) - 1))
+
+/*--------------------------------------------------------------*/
+/* sgrid_get() ---						*/
+/*								*/
+/* Return the value at (x, y, lay), or 0.0 if none was set.	*/
+/*--------------------------------------------------------------*/
+
+float sgrid_get(SPARSEGRID *sg, int x, int y, int lay)
+{
+   u_int key, slot;
+
+   if (sg->size == 0) return 0.0;
+
+#ifdef GRID_DEBUG
+   grid_index(x, y, lay);
+#endif
+   key = SGRID_KEY(x, y, lay);
+   for (slot = SGRID_HASH(key, sg->size); sg->key[slot] != 0;
+		slot = (slot + 1) & (sg->size - 1))
+      if (sg->key[slot] == key)
+	 return sg->value[slot];
+   return 0.0;
+}
+
+/*--------------------------------------------------------------*/
+/* sgrid_set() ---						*/
+/*								*/
+/* Set the value at (x, y, lay).  The table is doubled when it	*/
+/* gets half full.						*/
+/*--------------------------------------------------------------*/
+
+void sgrid_set(SPARSEGRID *sg, int x, int y, int lay, float value)
+{
+   u_int key, slot, i, oldsize;
+   u_int *oldkey;
+   float *oldvalue;
+
+#ifdef GRID_DEBUG
+   grid_index(x, y, lay);
+#endif
+   key = SGRID_KEY(x, y, lay);
+
+   if (sg->size > 0) {
+      for (slot = SGRID_HASH(key, sg->size); sg->key[slot] != 0;
+		slot = (slot + 1) & (sg->size - 1)) {
+	 if (sg->key[slot] == key) {
+	    sg->value[slot] = value;
+	    return;
+	 }
+      }
+   }
+   if (value == 0.0) return;	// Same as no entry
+
+   if (2 * (sg->count + 1) > sg->size) {
+      oldkey = sg->key;
+      oldvalue = sg->value;
+      oldsize = sg->size;
+      sg->size = (oldsize == 0) ? 1024 : oldsize * 2;
+      sg->key = (u_int *)calloc(sg->size, sizeof(u_int));
+      sg->value = (float *)malloc(sg->size * sizeof(float));
+      if ((sg->key == NULL) || (sg->value == NULL)) {
+	 fprintf(stderr, "Out of memory in sgrid_set().\n");
+	 exit(12);
+      }
+      for (i = 0; i < oldsize; i++) {
+	 if (oldkey[i] == 0) continue;
+	 for (slot = SGRID_HASH(oldkey[i], sg->size); sg->key[slot] != 0;
+		slot = (slot + 1) & (sg->size - 1));
+	 sg->key[slot] = oldkey[i];
+	 sg->value[slot] = oldvalue[i];
+      }
+      free(oldkey);
+      free(oldvalue);
+   }
+
+   for (slot = SGRID_HASH(key, sg->size); sg->key[slot] != 0;
+		slot = (slot + 1) & (sg->size - 1));
+   sg->key[slot] = key;
+   sg->value[slot] = value;
+   sg->count++;
+}
+
+/*--------------------------------------------------------------*/
+/* sgrid_free() ---						*/
+/*								*/
+/* Remove all entries and release the table.			*/
+/*--------------------------------------------------------------*/
+
+void sgrid_free(SPARSEGRID *sg)
+{
+   free(sg->key);
+   free(sg->value);
+   sg->key = NULL;
+   sg->value = NULL;
+   sg->size = sg->count = 0;
+}
+
+/* end of grid.c */
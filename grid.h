@@ -0,0 +1,36 @@
+/*--------------------------------------------------------------*/
+/* grid.h -- storage of the per-layer route grid arrays		*/
+/*--------------------------------------------------------------*/
+
+#ifndef GRID_H
+
+// Largest number of arrays that may be allocated at once
+
+#define GRID_MAXPLANES	16
+
+// Record of an allocated array
+
+typedef struct gridplane_ GRIDPLANE;
+
+struct gridplane_ {
+   void   **planes;	// array of layer pointers (e.g., Obs)
+   size_t size;		// bytes per grid position
+   char   *name;	// name used in diagnostics
+};
+
+void	grid_init();
+int	grid_alloc(void **planes, size_t size, char *name);
+void	grid_clear(void **planes);
+void	grid_free(void **planes);
+size_t	grid_memory();
+int	grid_index(int x, int y, int lay);
+u_int	grid_match_row(u_int *row, u_int mask, u_int value);
+
+float	sgrid_get(SPARSEGRID *sg, int x, int y, int lay);
+void	sgrid_set(SPARSEGRID *sg, int x, int y, int lay, float value);
+void	sgrid_free(SPARSEGRID *sg);
+
+#define GRID_H
+#endif 
+
+/* end of grid.h */
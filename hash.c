@@ -0,0 +1,173 @@
+/*--------------------------------------------------------------*/
+/* hash.c -- tables of names.					*/
+/*								*/
+/* LEF and DEF names are matched without regard to case, so	*/
+/* the tables used to find macros and instances by name hash	*/
+/* and compare names the same way.  Net names are matched	*/
+/* exactly (see HASHTABLE).  A table doubles its number of	*/
+/* buckets whenever it holds more entries than buckets.	*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string.h>
+
+#include "hash.h"
+
+#define HASH_MINSIZE	256	// Buckets of a new table
+
+/*--------------------------------------------------------------*/
+/* Hash of "name", ignoring case unless "ht" is exact.		*/
+/*--------------------------------------------------------------*/
+
+static unsigned int hash_name(char *name, HASHTABLE *ht)
+{
+   unsigned int h = 0;
+
+   if (ht->exact)
+      while (*name != '\0')
+	 h = h * 31 + (unsigned int)(unsigned char)*name++;
+   else
+      while (*name != '\0')
+	 h = h * 31 + (unsigned int)tolower((unsigned char)*name++);
+   return h;
+}
+
+/*--------------------------------------------------------------*/
+/* Compare two names as "ht" does;  return zero if they match.	*/
+/*--------------------------------------------------------------*/
+
+static int hash_cmp(char *name1, char *name2, HASHTABLE *ht)
+{
+   return (ht->exact) ? strcmp(name1, name2) : strcasecmp(name1, name2);
+}
+
+/*--------------------------------------------------------------*/
+/* Double the number of buckets of "ht" (or make the first	*/
+/* ones) and move the entries into them.			*/
+/*--------------------------------------------------------------*/
+
+static void hash_grow(HASHTABLE *ht)
+{
+   HASHENT *table, he, next;
+   int size, i;
+   unsigned int b;
+
+   size = (ht->size == 0) ? HASH_MINSIZE : ht->size * 2;
+   table = (HASHENT *)calloc(size, sizeof(HASHENT));
+
+   for (i = 0; i < ht->size; i++) {
+      for (he = ht->table[i]; he; he = next) {
+	 next = he->next;
+	 b = hash_name(he->name, ht) & (size - 1);
+	 he->next = table[b];
+	 table[b] = he;
+      }
+   }
+   if (ht->table != NULL) free(ht->table);
+   ht->table = table;
+   ht->size = size;
+}
+
+/*--------------------------------------------------------------*/
+/* HashLookup() ---						*/
+/*								*/
+/* Return the record installed under "name" in "ht", or NULL	*/
+/* if there is none.						*/
+/*--------------------------------------------------------------*/
+
+void *HashLookup(char *name, HASHTABLE *ht)
+{
+   HASHENT he;
+
+   if (ht->size == 0) return NULL;
+
+   for (he = ht->table[hash_name(name, ht) & (ht->size - 1)]; he;
+		he = he->next)
+      if (!hash_cmp(he->name, name, ht))
+	 return he->ptr;
+   return NULL;
+}
+
+/*--------------------------------------------------------------*/
+/* HashInstall() ---						*/
+/*								*/
+/* Install record "ptr" under "name" in "ht".  A record		*/
+/* already installed under the same name is replaced.		*/
+/*--------------------------------------------------------------*/
+
+void HashInstall(char *name, void *ptr, HASHTABLE *ht)
+{
+   HASHENT he;
+   unsigned int b;
+
+   if (ht->count >= ht->size) hash_grow(ht);
+
+   b = hash_name(name, ht) & (ht->size - 1);
+   for (he = ht->table[b]; he; he = he->next) {
+      if (!hash_cmp(he->name, name, ht)) {
+	 he->ptr = ptr;
+	 return;
+      }
+   }
+
+   he = (HASHENT)malloc(sizeof(struct hashent_));
+   he->name = strdup(name);
+   he->ptr = ptr;
+   he->next = ht->table[b];
+   ht->table[b] = he;
+   ht->count++;
+}
+
+/*--------------------------------------------------------------*/
+/* HashDelete() ---						*/
+/*								*/
+/* Remove the entry for "name" from "ht", if there is one.	*/
+/*--------------------------------------------------------------*/
+
+void HashDelete(char *name, HASHTABLE *ht)
+{
+   HASHENT he, *hp;
+
+   if (ht->size == 0) return;
+
+   hp = &ht->table[hash_name(name, ht) & (ht->size - 1)];
+   for (he = *hp; he; hp = &he->next, he = *hp) {
+      if (!hash_cmp(he->name, name, ht)) {
+	 *hp = he->next;
+	 free(he->name);
+	 free(he);
+	 ht->count--;
+	 return;
+      }
+   }
+}
+
+/*--------------------------------------------------------------*/
+/* HashKill() ---						*/
+/*								*/
+/* Remove all entries from "ht" and free its buckets, leaving	*/
+/* it empty (and as exact as it was).  The records themselves	*/
+/* are not freed.						*/
+/*--------------------------------------------------------------*/
+
+void HashKill(HASHTABLE *ht)
+{
+   HASHENT he, next;
+   int i;
+
+   for (i = 0; i < ht->size; i++) {
+      for (he = ht->table[i]; he; he = next) {
+	 next = he->next;
+	 free(he->name);
+	 free(he);
+      }
+   }
+   if (ht->table != NULL) free(ht->table);
+   ht->table = NULL;
+   ht->size = 0;
+   ht->count = 0;
+}
+
+/* end of hash.c */
@@ -0,0 +1,36 @@
+/*--------------------------------------------------------------*/
+/* hash.h -- tables of names					*/
+/*--------------------------------------------------------------*/
+
+#ifndef HASH_H
+
+// An entry of a name table
+
+typedef struct hashent_ *HASHENT;
+
+struct hashent_ {
+   char    *name;	// name, as installed
+   void    *ptr;	// record named
+   HASHENT next;	// next entry in the same bucket
+};
+
+// A name table.  A table of all zeros is empty and ready to use, and
+// matches names without regard to case, as LEF and DEF do.  Set
+// "exact" before the first entry is installed to match case.
+
+typedef struct hashtable_ {
+   HASHENT *table;	// buckets
+   int     size;	// number of buckets (a power of two)
+   int     count;	// number of entries
+   int     exact;	// nonzero to match names with case
+} HASHTABLE;
+
+void	*HashLookup(char *name, HASHTABLE *ht);
+void	HashInstall(char *name, void *ptr, HASHTABLE *ht);
+void	HashDelete(char *name, HASHTABLE *ht);
+void	HashKill(HASHTABLE *ht);
+
+#define HASH_H
+#endif
+
+/* end of hash.h */
@@ -26,6 +26,11 @@
 #include <errno.h>
 #include <stdarg.h>
 #include <sys/time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <math.h>
 
 #include "qrouter.h"
@@ -33,16 +38,32 @@
 #include "config.h"
 #include "maze.h"
 #include "lef.h"
+#include "hash.h"
 
 /* ---------------------------------------------------------------------*/
 
-/* Current line number for reading */
-int lefCurrentLine;
-
 /* Information about routing layers */
 LefList LefInfo;
 
 /* Gate information is in the linked list GateInfo, imported */
+/* Cells of GateInfo by name (see lefFindCell()) */
+static HASHTABLE MacroTable;
+
+/* Route rules by layer number, filled in by LefFreezeRules() */
+
+typedef struct {
+    LefList layer;			/* layer record (LefFindLayerByNum()) */
+    double  keepout, width, offset, spacing, pitch;
+    double  viawidth[MAX_LAYERS][2];	/* by layer and dir (LefGetViaWidth()) */
+    char   *name;
+    int     orient;
+} LefRule;
+
+static LefRule LefRules[MAX_LAYERS];
+static u_char LefRulesFrozen = FALSE;
+
+#define LEF_FROZEN(layer) (LefRulesFrozen && ((layer) >= 0) && \
+		((layer) < Num_layers))
 
 /*---------------------------------------------------------
  * Lookup --
@@ -173,6 +194,103 @@ LookupFull(name, table)
 }
 
 
+/*
+ *------------------------------------------------------------
+ *
+ * LefOpen --
+ *
+ *	Open a LEF or DEF file for parsing with LefNextToken().
+ *	The whole file is mapped into memory, read only, and
+ *	parsed a line at a time.  If the file cannot be mapped,
+ *	it is read into memory instead.
+ *
+ * Results:
+ *	The parser context for the file, or NULL if the file
+ *	cannot be opened (errno is set).
+ *
+ * Side Effects:
+ *	Memory is allocated, and the file is mapped.
+ *
+ *------------------------------------------------------------
+ */
+
+LefFile *
+LefOpen(char *filename)
+{
+    LefFile *f;
+    struct stat st;
+    char *data;
+    size_t size, got;
+    ssize_t n;
+    int fd;
+
+    fd = open(filename, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    if (fstat(fd, &st) < 0) {
+	close(fd);
+	return NULL;
+    }
+    size = (size_t)st.st_size;
+
+    f = (LefFile *)malloc(sizeof(LefFile));
+    f->mapped = FALSE;
+    f->midline = FALSE;
+    f->line = 0;
+    f->errors = 0;
+    f->bufsize = 256;
+    f->buf = (char *)malloc(f->bufsize);
+    f->next = NULL;
+
+    data = MAP_FAILED;
+    if (size > 0)
+	data = (char *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (data != MAP_FAILED)
+	f->mapped = TRUE;
+    else {
+	/* Not a regular file, or no mapping:  read it all */
+	if (size == 0) size = 65536;
+	data = (char *)malloc(size);
+	got = 0;
+	while ((n = read(fd, data + got, size - got)) > 0) {
+	    got += (size_t)n;
+	    if (got == size) {
+		size <<= 1;
+		data = (char *)realloc(data, size);
+	    }
+	}
+	size = got;
+    }
+    close(fd);
+
+    f->data = f->pos = data;
+    f->end = data + size;
+    return f;
+}
+
+/*
+ *------------------------------------------------------------
+ *
+ * LefClose --
+ *
+ *	Release a file opened with LefOpen().  Tokens returned
+ *	by LefNextToken() for the file are no longer valid.
+ *
+ *------------------------------------------------------------
+ */
+
+void
+LefClose(LefFile *f)
+{
+    if (f->mapped)
+	munmap(f->data, (size_t)(f->end - f->data));
+    else
+	free(f->data);
+    free(f->buf);
+    free(f);
+}
+
 /*
  *------------------------------------------------------------
  *
@@ -184,83 +302,115 @@ LookupFull(name, table)
  *	Otherwise, end-of-line will be ignored.
  *
  * Results:
- *	Pointer to next token to parse
+ *	Pointer to next token to parse, or NULL at end of file
  *
  * Side Effects:
- *	May read a new line from the specified file.
+ *	Advances the parser context "f".  Each line is copied
+ *	from the file into the line buffer of "f" (with any
+ *	quoted token that runs on over the lines after it), and
+ *	split into tokens there.  f->line is the line of the
+ *	token, for LefError(f, ).
  *
  * Warnings:
- *	The return result of LefNextToken will be overwritten by
- *	subsequent calls to LefNextToken if more than one line of
- *	input is parsed.
+ *	The token is valid until the next line is read, as it
+ *	was when lines were read with fgets().
  *
  *------------------------------------------------------------
  */
 
 char *
-LefNextToken(FILE *f, u_char ignore_eol)
+LefNextToken(LefFile *f, u_char ignore_eol)
 {
-    static char line[LEF_LINE_MAX + 2];	/* input buffer */
-    static char *nexttoken = NULL;	/* pointer to next token */
-    static char *curtoken;		/* pointer to current token */
-    static char eol_token='\n';
+    static char eol_token[] = "\n";
+    char *p, *q, *end, *token;
+    size_t len;
 
-    /* Read a new line if necessary */
+    /* Move to the first token of the next line if necessary, */
+    /* skipping blank lines and comment lines, and copy the   */
+    /* line to the line buffer.				  */
 
-    if (nexttoken == NULL)
+    if (!f->midline)
     {
-	for(;;)
+	end = f->end;
+	for (;;)
 	{
-	    if (fgets(line, LEF_LINE_MAX + 1, f) == NULL) return NULL;
-	    lefCurrentLine++;
-	    curtoken = line;
-	    while (isspace(*curtoken) && (*curtoken != '\n') && (*curtoken != '\0'))
-		curtoken++;		/* skip leading whitespace */
+	    p = f->pos;
+	    if (p >= end) return NULL;
+	    f->line++;
+	    while ((p < end) && isspace(*p) && (*p != '\n'))
+		p++;		/* skip leading whitespace */
 
-	    if ((*curtoken != '#') && (*curtoken != '\n') && (*curtoken != '\0'))
-	    {
-		nexttoken = curtoken;
+	    if ((p < end) && (*p != '#') && (*p != '\n'))
 		break;
+
+	    while ((p < end) && (*p != '\n'))
+		p++;		/* skip the rest of the line */
+	    f->pos = (p < end) ? p + 1 : end;
+	}
+
+	/* Find the end of the line, or of the comment ending it.	*/
+	/* Quoted material may span lines.				*/
+
+	q = p;
+	while ((q < end) && (*q != '\n') && (*q != '#'))
+	{
+	    if (*q == '\"') {
+		q++;
+		while ((q < end) && ((*q != '\"') || (*(q - 1) == '\\')))
+		    q++;
+		if (q < end) q++;
 	    }
+	    while ((q < end) && !isspace(*q))
+		q++;
+	    while ((q < end) && isspace(*q) && (*q != '\n'))
+		q++;
 	}
+
+	len = (size_t)(q - p);
+	if (len + 1 > f->bufsize) {
+	    while (len + 1 > f->bufsize) f->bufsize <<= 1;
+	    f->buf = (char *)realloc(f->buf, f->bufsize);
+	}
+	memcpy(f->buf, p, len);
+	f->buf[len] = '\0';
+	f->next = f->buf;
+
+	while ((q < end) && (*q != '\n'))
+	    q++;		/* skip any comment */
+	f->pos = (q < end) ? q + 1 : end;
+
+	f->midline = TRUE;
 	if (!ignore_eol)
-	    return &eol_token;
+	    return eol_token;
     }
-    else
-	curtoken = nexttoken;
-
-    /* Find the next token; set to NULL if none (end-of-line). */
-    /* Treat quoted material as a single token */
-
-    if (*nexttoken == '\"') {
-	nexttoken++;
-	while (((*nexttoken != '\"') || (*(nexttoken - 1) == '\\')) &&
-		(*nexttoken != '\0')) {
-	    if (*nexttoken == '\n') { 	
-		if (fgets(nexttoken + 1, LEF_LINE_MAX -
-				(size_t)(nexttoken - line), f) == NULL)
-		    return NULL;
-	    }
-	    nexttoken++;	/* skip all in quotes (move past current token) */
+
+    /* Find the end of the token.  Treat quoted material	*/
+    /* as a single token, which may span lines.		*/
+
+    token = p = f->next;
+    if (*p == '\"') {
+	p++;
+	while ((*p != '\0') && ((*p != '\"') || (*(p - 1) == '\\'))) {
+	    if (*p == '\n') f->line++;
+	    p++;	/* skip all in quotes (move past current token) */
 	}
-	if (*nexttoken == '\"')
-	    nexttoken++;
+	if (*p != '\0') p++;
     }
     else {
-	while (!isspace(*nexttoken) && (*nexttoken != '\0') && (*nexttoken != '\n'))
-	    nexttoken++;	/* skip non-whitespace (move past current token) */
+	while ((*p != '\0') && !isspace(*p))
+	    p++;	/* skip non-whitespace (move past current token) */
     }
 
     /* Terminate the current token */
-    if (*nexttoken != '\0') *nexttoken++ = '\0';
 
-    while (isspace(*nexttoken) && (*nexttoken != '\0') && (*nexttoken != '\n'))
-	nexttoken++;	/* skip any whitespace */
+    if (*p != '\0') *p++ = '\0';
 
-    if ((*nexttoken == '#') || (*nexttoken == '\n') || (*nexttoken == '\0'))
-	nexttoken = NULL;
+    while ((*p != '\0') && isspace(*p))
+	p++;	/* skip any whitespace */
 
-    return curtoken;
+    f->next = p;
+    if (*p == '\0') f->midline = FALSE;
+    return token;
 }
 
 /*
@@ -281,34 +431,33 @@ LefNextToken(FILE *f, u_char ignore_eol)
  */
 
 void
-LefError(char *fmt, ...)
+LefError(LefFile *f, char *fmt, ...)
 {  
-    static int errors = 0;
     va_list args;
 
     if (fmt == NULL)  /* Special case:  report any errors and reset */
     {
-	if (errors)
+	if (f->errors)
 	{
-	    printf("LEF Read: encountered %d error%s total.\n", errors,
-			(errors == 1) ? "" : "s");
-	    errors = 0;
+	    printf("LEF Read: encountered %d error%s total.\n", f->errors,
+			(f->errors == 1) ? "" : "s");
+	    f->errors = 0;
 	}
 	return;
     }
 
-    if (errors < LEF_MAX_ERRORS)
+    if (f->errors < LEF_MAX_ERRORS)
     {
-	fprintf(stderr, "LEF Read, Line %d: ", lefCurrentLine);
+	fprintf(stderr, "LEF Read, Line %d: ", f->line);
 	va_start(args, fmt);
 	vfprintf(stderr, fmt, args);
 	va_end(args);
 	fflush(stderr);
     }
-    else if (errors == LEF_MAX_ERRORS)
+    else if (f->errors == LEF_MAX_ERRORS)
 	fprintf(stderr, "LEF Read:  Further errors will not be reported.\n");
 
-    errors++;
+    f->errors++;
 }
 
 /*
@@ -332,7 +481,7 @@ LefError(char *fmt, ...)
  */
 
 u_char
-LefParseEndStatement(FILE *f, char *match)
+LefParseEndStatement(LefFile *f, char *match)
 {
     char *token;
     int keyword, words;
@@ -344,7 +493,7 @@ LefParseEndStatement(FILE *f, char *match)
     token = LefNextToken(f, (match == NULL) ? FALSE : TRUE);
     if (token == NULL)
     {
-	LefError("Bad file read while looking for END statement\n");
+	LefError(f, "Bad file read while looking for END statement\n");
 	return FALSE;
     }
 
@@ -384,7 +533,7 @@ LefParseEndStatement(FILE *f, char *match)
  */
 
 void
-LefSkipSection(FILE *f, char *section)
+LefSkipSection(LefFile *f, char *section)
 {
     char *token;
     int keyword;
@@ -408,7 +557,7 @@ LefSkipSection(FILE *f, char *section)
 	}
     }
 
-    LefError("Section %s has no END record!\n", section);
+    LefError(f, "Section %s has no END record!\n", section);
     return;
 }
 
@@ -419,7 +568,7 @@ LefSkipSection(FILE *f, char *section)
  *
  * 	"name" is the name of the cell to search for.
  *	Returns the GATE entry for the cell from the GateInfo
- *	list.
+ *	list, found by name (not case sensitive) in MacroTable.
  *
  *------------------------------------------------------------
  */
@@ -427,13 +576,27 @@ LefSkipSection(FILE *f, char *section)
 GATE
 lefFindCell(char *name)
 {
-    GATE gateginfo;
+    return (GATE)HashLookup(name, &MacroTable);
+}
 
-    for (gateginfo = GateInfo; gateginfo; gateginfo = gateginfo->next) { 
-	if (!strcasecmp(gateginfo->gatetype, name))
-	    return gateginfo;
-    }
-    return (GATE)NULL;
+/*
+ *------------------------------------------------------------
+ *
+ * lefAddCell --
+ *
+ *	Add the cell "gateginfo" to the GateInfo list, and to
+ *	MacroTable under its name.  A cell already of that
+ *	name is no longer found by lefFindCell().
+ *
+ *------------------------------------------------------------
+ */
+
+void
+lefAddCell(GATE gateginfo)
+{
+    gateginfo->next = GateInfo;
+    GateInfo = gateginfo;
+    HashInstall(gateginfo->gatetype, gateginfo, &MacroTable);
 }
 
 /*
@@ -574,6 +737,8 @@ LefFindLayerByNum(int layer)
 {
     LefList lefl, rlefl;
    
+    if (LEF_FROZEN(layer)) return LefRules[layer].layer;
+
     rlefl = (LefList)NULL;
     for (lefl = LefInfo; lefl; lefl = lefl->next) {
 	if (lefl->type == layer) {
@@ -626,6 +791,8 @@ LefGetRouteKeepout(int layer)
     LefList lefl;
     double dist;
 
+    if (LEF_FROZEN(layer)) return LefRules[layer].keepout;
+
     lefl = LefFindLayerByNum(layer);
     if (lefl) {
 	if (lefl->lefClass == CLASS_ROUTE) {
@@ -650,6 +817,8 @@ LefGetRouteWidth(int layer)
 {
     LefList lefl;
 
+    if (LEF_FROZEN(layer)) return LefRules[layer].width;
+
     lefl = LefFindLayerByNum(layer);
     if (lefl) {
 	if (lefl->lefClass == CLASS_ROUTE) {
@@ -673,6 +842,8 @@ LefGetRouteOffset(int layer)
 {
     LefList lefl;
 
+    if (LEF_FROZEN(layer)) return LefRules[layer].offset;
+
     lefl = LefFindLayerByNum(layer);
     if (lefl) {
 	if (lefl->lefClass == CLASS_ROUTE) {
@@ -708,6 +879,9 @@ LefGetViaWidth(int base, int layer, int dir)
     LefList lefl;
     double width;
 
+    if (LEF_FROZEN(base) && LEF_FROZEN(layer))
+	return LefRules[base].viawidth[layer][(dir) ? 1 : 0];
+
     lefl = LefFindLayer(ViaX[base]);
     if (lefl) {
 	if (lefl->lefClass == CLASS_VIA) {
@@ -743,6 +917,8 @@ LefGetRouteSpacing(int layer)
 {
     LefList lefl;
 
+    if (LEF_FROZEN(layer)) return LefRules[layer].spacing;
+
     lefl = LefFindLayerByNum(layer);
     if (lefl) {
 	if (lefl->lefClass == CLASS_ROUTE) {
@@ -791,6 +967,8 @@ LefGetRoutePitch(int layer)
 {
     LefList lefl;
 
+    if (LEF_FROZEN(layer)) return LefRules[layer].pitch;
+
     lefl = LefFindLayerByNum(layer);
     if (lefl) {
 	if (lefl->lefClass == CLASS_ROUTE) {
@@ -811,6 +989,8 @@ LefGetRouteName(int layer)
 {
     LefList lefl;
 
+    if (LEF_FROZEN(layer)) return LefRules[layer].name;
+
     lefl = LefFindLayerByNum(layer);
     if (lefl) {
 	if (lefl->lefClass == CLASS_ROUTE) {
@@ -833,6 +1013,8 @@ LefGetRouteOrientation(int layer)
 {
     LefList lefl;
 
+    if (LEF_FROZEN(layer)) return LefRules[layer].orient;
+
     lefl = LefFindLayerByNum(layer);
     if (lefl) {
 	if (lefl->lefClass == CLASS_ROUTE) {
@@ -842,6 +1024,43 @@ LefGetRouteOrientation(int layer)
     return -1;
 }
 
+/*
+ *------------------------------------------------------------
+ * LefFreezeRules --
+ *
+ *	Work out the route rules of each layer once, so that the
+ *	LefGet*() routines above read them from LefRules[]
+ *	instead of searching LefInfo on every call.  Must be
+ *	called after the LEF, DEF and configuration files have
+ *	all been read, since each of them may change the rules.
+ *	LefGetRouteWideSpacing() still walks the spacing rules
+ *	of the layer, as it depends on the width asked for.
+ *------------------------------------------------------------
+ */
+
+void
+LefFreezeRules()
+{
+    int i, j;
+
+    LefRulesFrozen = FALSE;
+    for (i = 0; i < Num_layers; i++) {
+	LefRules[i].layer = LefFindLayerByNum(i);
+	LefRules[i].keepout = LefGetRouteKeepout(i);
+	LefRules[i].width = LefGetRouteWidth(i);
+	LefRules[i].offset = LefGetRouteOffset(i);
+	LefRules[i].spacing = LefGetRouteSpacing(i);
+	LefRules[i].pitch = LefGetRoutePitch(i);
+	LefRules[i].name = LefGetRouteName(i);
+	LefRules[i].orient = LefGetRouteOrientation(i);
+	for (j = 0; j < Num_layers; j++) {
+	    LefRules[i].viawidth[j][0] = LefGetViaWidth(i, j, 0);
+	    LefRules[i].viawidth[j][1] = LefGetViaWidth(i, j, 1);
+	}
+    }
+    LefRulesFrozen = TRUE;
+}
+
 /*
  *------------------------------------------------------------
  * LefReadLayers --
@@ -864,7 +1083,7 @@ LefGetRouteOrientation(int layer)
 
 int
 LefReadLayers(f, obstruct, lreturn)
-    FILE *f;
+    LefFile *f;
     u_char obstruct;
     int *lreturn;
 {
@@ -875,7 +1094,7 @@ LefReadLayers(f, obstruct, lreturn)
     token = LefNextToken(f, TRUE);
     if (*token == ';')
     {
-	LefError("Bad Layer statement\n");
+	LefError(f, "Bad Layer statement\n");
 	return -1;
     }
     else
@@ -900,7 +1119,7 @@ LefReadLayers(f, obstruct, lreturn)
 	}
 	if ((curlayer < 0) && ((!lefl) || (lefl->lefClass != CLASS_IGNORE)))
 	{
-	    LefError("Don't know how to parse layer \"%s\"\n", token);
+	    LefError(f, "Don't know how to parse layer \"%s\"\n", token);
 	}
     }
     return curlayer;
@@ -925,7 +1144,7 @@ LefReadLayers(f, obstruct, lreturn)
  */
 
 int
-LefReadLayer(FILE *f, u_char obstruct)
+LefReadLayer(LefFile *f, u_char obstruct)
 {
     return LefReadLayers(f, obstruct, (int *)NULL);
 }
@@ -953,7 +1172,7 @@ LefReadLayer(FILE *f, u_char obstruct)
  */
 
 DSEG
-LefReadRect(FILE *f, int curlayer, float oscale)
+LefReadRect(LefFile *f, int curlayer, float oscale)
 {
     char *token;
     float llx, lly, urx, ury;
@@ -991,7 +1210,7 @@ LefReadRect(FILE *f, int curlayer, float oscale)
     }
     if (curlayer < 0) {
 	/* Issue warning but keep geometry with negative layer number */
-	LefError("No layer defined for RECT.\n");
+	LefError(f, "No layer defined for RECT.\n");
     }
 
     /* Scale coordinates (microns to centimicrons)	*/
@@ -1004,7 +1223,7 @@ LefReadRect(FILE *f, int curlayer, float oscale)
     return (&paintrect);
 
 parse_error:
-    LefError("Bad port geometry: RECT requires 4 values.\n");
+    LefError(f, "Bad port geometry: RECT requires 4 values.\n");
     return (DSEG)NULL;
 }
 
@@ -1161,7 +1380,7 @@ lefCross(DPOINT edge, int dir, double ybot, double ytop)
  */
 
 void
-LefPolygonToRects(DSEG *rectListPtr, DPOINT pointlist)
+LefPolygonToRects(LefFile *f, DSEG *rectListPtr, DPOINT pointlist)
 {
    DPOINT ptail, p, *pts, *edges;
    DSEG rtail, rex, new;
@@ -1209,7 +1428,7 @@ LefPolygonToRects(DSEG *rectListPtr, DPOINT pointlist)
 
     if (npts < 4)
     {
-	LefError("Polygon with fewer than 4 points.\n");
+	LefError(f, "Polygon with fewer than 4 points.\n");
 	goto done;
     }
 
@@ -1221,7 +1440,7 @@ LefPolygonToRects(DSEG *rectListPtr, DPOINT pointlist)
 
     if (!lefOrient(edges, npts, dir))
     {
-	LefError("I can't handle non-manhattan polygons!\n");
+	LefError(f, "I can't handle non-manhattan polygons!\n");
 	goto done;
     }
 
@@ -1291,7 +1510,7 @@ done:
  */
 
 DPOINT
-LefReadPolygon(FILE *f, int curlayer, float oscale)
+LefReadPolygon(LefFile *f, int curlayer, float oscale)
 {
     DPOINT plist = NULL, newPoint;
     char *token;
@@ -1303,21 +1522,21 @@ LefReadPolygon(FILE *f, int curlayer, float oscale)
 	if (token == NULL || *token == ';') break;
 	if (sscanf(token, "%lg", &px) != 1)
 	{
-	    LefError("Bad X value in polygon.\n");
-	    LefEndStatement(f);
+	    LefError(f, "Bad X value in polygon.\n");
+	LefEndStatement(f);
 	    break;
 	}
 
 	token = LefNextToken(f, TRUE);
 	if (token == NULL || *token == ';')
 	{
-	    LefError("Missing Y value in polygon point!\n");
-	    break;
+	    LefError(f, "Missing Y value in polygon point!\n");
+	break;
 	}
 	if (sscanf(token, "%lg", &py) != 1)
 	{
-	    LefError("Bad Y value in polygon.\n");
-	    LefEndStatement(f);
+	    LefError(f, "Bad Y value in polygon.\n");
+	LefEndStatement(f);
 	    break;
 	}
 
@@ -1354,7 +1573,7 @@ enum lef_geometry_keys {LEF_LAYER = 0, LEF_WIDTH, LEF_PATH,
 	LEF_RECT, LEF_POLYGON, LEF_VIA, LEF_GEOMETRY_END};
 
 DSEG
-LefReadGeometry(GATE lefMacro, FILE *f, float oscale)
+LefReadGeometry(GATE lefMacro, LefFile *f, float oscale)
 {
     int curlayer = -1, otherlayer = -1;
 
@@ -1380,7 +1599,8 @@ LefReadGeometry(GATE lefMacro, FILE *f, float oscale)
 	keyword = Lookup(token, geometry_keys);
 	if (keyword < 0)
 	{
-	    LefError("Unknown keyword \"%s\" in LEF file; ignoring.\n", token);
+	    LefError(f, "Unknown keyword \"%s\" in LEF file; ignoring.\n",
+			token);
 	    LefEndStatement(f);
 	    continue;
 	}
@@ -1410,7 +1630,7 @@ LefReadGeometry(GATE lefMacro, FILE *f, float oscale)
 		break;
 	    case LEF_POLYGON:
 		pointlist = LefReadPolygon(f, curlayer, oscale);
-		LefPolygonToRects(&rectList, pointlist);
+		LefPolygonToRects(f, &rectList, pointlist);
 		break;
 	    case LEF_VIA:
 		LefEndStatement(f);
@@ -1418,7 +1638,8 @@ LefReadGeometry(GATE lefMacro, FILE *f, float oscale)
 	    case LEF_GEOMETRY_END:
 		if (!LefParseEndStatement(f, NULL))
 		{
-		    LefError("Geometry (PORT or OBS) END statement missing.\n");
+		    LefError(f, "Geometry (PORT or OBS) END "
+				"statement missing.\n");
 		    keyword = -1;
 		}
 		break;
@@ -1449,7 +1670,7 @@ LefReadGeometry(GATE lefMacro, FILE *f, float oscale)
 void
 LefReadPort(lefMacro, f, pinName, pinNum, pinDir, pinUse, oscale)
     GATE lefMacro;
-    FILE *f;
+    LefFile *f;
     char *pinName;
     int pinNum, pinDir, pinUse;
     float oscale;
@@ -1496,7 +1717,7 @@ enum lef_pin_keys {LEF_DIRECTION = 0, LEF_USE, LEF_PORT, LEF_CAPACITANCE,
 void
 LefReadPin(lefMacro, f, pinname, pinNum, oscale)
    GATE lefMacro;
-   FILE *f;
+   LefFile *f;
    char *pinname;
    int pinNum;
    float oscale;
@@ -1558,7 +1779,8 @@ LefReadPin(lefMacro, f, pinname, pinNum, oscale)
 	keyword = Lookup(token, pin_keys);
 	if (keyword < 0)
 	{
-	    LefError("Unknown keyword \"%s\" in LEF file; ignoring.\n", token);
+	    LefError(f, "Unknown keyword \"%s\" in LEF file; ignoring.\n",
+			token);
 	    LefEndStatement(f);
 	    continue;
 	}
@@ -1568,7 +1790,7 @@ LefReadPin(lefMacro, f, pinname, pinNum, oscale)
 		token = LefNextToken(f, TRUE);
 		subkey = Lookup(token, pin_classes);
 		if (subkey < 0)
-		    LefError("Improper DIRECTION statement\n");
+		    LefError(f, "Improper DIRECTION statement\n");
 		else
 		    pinDir = lef_class_to_bitmask[subkey];
 		LefEndStatement(f);
@@ -1577,7 +1799,7 @@ LefReadPin(lefMacro, f, pinname, pinNum, oscale)
 		token = LefNextToken(f, TRUE);
 		subkey = Lookup(token, pin_uses);
 		if (subkey < 0)
-		    LefError("Improper USE statement\n");
+		    LefError(f, "Improper USE statement\n");
 		else
 		    pinUse = lef_use_to_bitmask[subkey];
 		LefEndStatement(f);
@@ -1591,8 +1813,8 @@ LefReadPin(lefMacro, f, pinname, pinNum, oscale)
 	    case LEF_PIN_END:
 		if (!LefParseEndStatement(f, pinname))
 		{
-		    LefError("Pin END statement missing.\n");
-		    keyword = -1;
+		    LefError(f, "Pin END statement missing.\n");
+		keyword = -1;
 		}
 		break;
 	}
@@ -1613,7 +1835,7 @@ LefReadPin(lefMacro, f, pinname, pinNum, oscale)
  */
 
 void
-LefEndStatement(FILE *f)
+LefEndStatement(LefFile *f)
 {
     char *token;
 
@@ -1643,7 +1865,7 @@ enum lef_macro_keys {LEF_CLASS = 0, LEF_SIZE, LEF_ORIGIN,
 
 void
 LefReadMacro(f, mname, oscale)
-    FILE *f;			/* LEF file being read	*/
+    LefFile *f;			/* LEF file being read	*/
     char *mname;		/* name of the macro 	*/
     float oscale;		/* scale factor to um, usually 1 */
 {
@@ -1693,10 +1915,12 @@ LefReadMacro(f, mname, oscale)
 		if (!strcmp(altMacro->gatetype, newname))
 		    break;
 	}
-	LefError("Cell \"%s\" was already defined in this file.  "
+	LefError(f, "Cell \"%s\" was already defined in this file.  "
 		"Renaming original cell \"%s\"\n", mname, newname);
 
+	HashDelete(mname, &MacroTable);
 	lefMacro->gatetype = strdup(newname);
+	HashInstall(newname, lefMacro, &MacroTable);
 	lefMacro = lefFindCell(mname);
     }
 
@@ -1710,8 +1934,7 @@ LefReadMacro(f, mname, oscale)
     lefMacro->height = 0.0;
     lefMacro->placedX = 0.0;
     lefMacro->placedY = 0.0;
-    lefMacro->next = GateInfo;
-    GateInfo = lefMacro;
+    lefAddCell(lefMacro);
 
     /* Initial values */
     pinNum = 0;
@@ -1724,7 +1947,8 @@ LefReadMacro(f, mname, oscale)
 	keyword = Lookup(token, macro_keys);
 	if (keyword < 0)
 	{
-	    LefError("Unknown keyword \"%s\" in LEF file; ignoring.\n", token);
+	    LefError(f, "Unknown keyword \"%s\" in LEF file; ignoring.\n",
+			token);
 	    LefEndStatement(f);
 	    continue;
 	}
@@ -1751,7 +1975,7 @@ LefReadMacro(f, mname, oscale)
 		LefEndStatement(f);
 		break;
 size_error:
-		LefError("Bad macro SIZE; requires values X BY Y.\n");
+		LefError(f, "Bad macro SIZE; requires values X BY Y.\n");
 		LefEndStatement(f);
 		break;
 	    case LEF_ORIGIN:
@@ -1770,7 +1994,7 @@ size_error:
 		LefEndStatement(f);
 		break;
 origin_error:
-		LefError("Bad macro ORIGIN; requires 2 values.\n");
+		LefError(f, "Bad macro ORIGIN; requires 2 values.\n");
 		LefEndStatement(f);
 		break;
 	    case LEF_SYMMETRY:
@@ -1825,8 +2049,8 @@ origin_error:
 	    case LEF_MACRO_END:
 		if (!LefParseEndStatement(f, mname))
 		{
-		    LefError("Macro END statement missing.\n");
-		    keyword = -1;
+		    LefError(f, "Macro END statement missing.\n");
+		keyword = -1;
 		}
 		break;
 	}
@@ -1847,7 +2071,8 @@ origin_error:
 	    lefMacro->placedY = lefBBox.y1;
 	}
 	else {
-	    LefError("Gate %s has no size information!\n", lefMacro->gatetype);
+	    LefError(f, "Gate %s has no size information!\n",
+			lefMacro->gatetype);
 	}
     }
 }
@@ -1875,7 +2100,7 @@ origin_error:
  */
 
 void
-LefAddViaGeometry(FILE *f, LefList lefl, int curlayer, float oscale)
+LefAddViaGeometry(LefFile *f, LefList lefl, int curlayer, float oscale)
 {
     DSEG currect;
     DSEG viarect;
@@ -1923,7 +2148,7 @@ enum lef_spacing_keys {LEF_SPACING_RANGE=0, LEF_END_LAYER_SPACING};
 
 void
 LefReadLayerSection(f, lname, mode, lefl)
-    FILE *f;			/* LEF file being read	  */
+    LefFile *f;			/* LEF file being read	  */
     char *lname;		/* name of the layer 	  */
     int mode;			/* layer, via, or viarule */
     LefList lefl;		/* pointer to layer info  */
@@ -1979,7 +2204,8 @@ LefReadLayerSection(f, lname, mode, lefl)
 	keyword = Lookup(token, layer_keys);
 	if (keyword < 0)
 	{
-	    LefError("Unknown keyword \"%s\" in LEF file; ignoring.\n", token);
+	    LefError(f, "Unknown keyword \"%s\" in LEF file; ignoring.\n",
+			token);
 	    LefEndStatement(f);
 	    continue;
 	}
@@ -1991,7 +2217,7 @@ LefReadLayerSection(f, lname, mode, lefl)
 		{
 		    typekey = Lookup(token, layer_type_keys);
 		    if (typekey < 0)
-			LefError("Unknown layer type \"%s\" in LEF file; "
+			LefError(f, "Unknown layer type \"%s\" in LEF file; "
 				"ignoring.\n", token);
 		}
 		if (lefl->lefClass == CLASS_IGNORE) {
@@ -2031,7 +2257,8 @@ LefReadLayerSection(f, lname, mode, lefl)
 		    }
 		}
 		else if (lefl->lefClass != typekey) {
-		    LefError("Attempt to reclassify layer %s from %s to %s\n",
+		    LefError(f, "Attempt to reclassify layer "
+				"%s from %s to %s\n",
 				lname, layer_type_keys[lefl->lefClass],
 				layer_type_keys[typekey]);
 		}
@@ -2120,8 +2347,8 @@ LefReadLayerSection(f, lname, mode, lefl)
 	    case LEF_LAYER_END:
 		if (!LefParseEndStatement(f, lname))
 		{
-		    LefError("Layer END statement missing.\n");
-		    keyword = -1;
+		    LefError(f, "Layer END statement missing.\n");
+		keyword = -1;
 		}
 		break;
 	}
@@ -2159,7 +2386,7 @@ void
 LefRead(inName)
     char *inName;
 {
-    FILE *f;
+    LefFile *f;
     char filename[256];
     char *token;
     char tsave[128];
@@ -2197,7 +2424,7 @@ LefRead(inName)
     else
 	strcpy(filename, inName);
 
-    f = fopen(filename, "r");
+    f = LefOpen(filename);
 
     if (f == NULL)
     {
@@ -2216,7 +2443,8 @@ LefRead(inName)
 	keyword = Lookup(token, sections);
 	if (keyword < 0)
 	{
-	    LefError("Unknown keyword \"%s\" in LEF file; ignoring.\n", token);
+	    LefError(f, "Unknown keyword \"%s\" in LEF file; ignoring.\n",
+			token);
 	    LefEndStatement(f);
 	    continue;
 	}
@@ -2268,7 +2496,8 @@ LefRead(inName)
 		    LefSkipSection(f, tsave);
 		else
 		{
-		    LefError("Warning:  Cut type \"%s\" redefined.\n", token);
+		    LefError(f, "Warning:  Cut type \"%s\" redefined.\n",
+				token);
 		    lefl = LefRedefined(lefl, token);
 		    LefReadLayerSection(f, tsave, keyword, lefl);
 		}
@@ -2293,7 +2522,7 @@ LefRead(inName)
 		{
 		    if (lefl && lefl->type < 0)
 		    {
-			LefError("Layer %s is only defined for obstructions!\n", token);
+			LefError(f, "Layer %s is only defined for obstructions!\n", token);
 			LefSkipSection(f, tsave);
 			break;
 		    }
@@ -2343,24 +2572,22 @@ LefRead(inName)
 	    case LEF_END:
 		if (!LefParseEndStatement(f, "LIBRARY"))
 		{
-		    LefError("END statement out of context.\n");
-		    keyword = -1;
+		    LefError(f, "END statement out of context.\n");
+		keyword = -1;
 		}
 		break;
 	}
 	if (keyword == LEF_END) break;
     }
-    printf("LEF read: Processed %d lines.\n", lefCurrentLine);
-    LefError(NULL);	/* print statement of errors, if any */
+    printf("LEF read: Processed %d lines.\n", f->line);
+    LefError(f, NULL);	/* print statement of errors, if any */
 
     /* Cleanup */
-    if (f != NULL) fclose(f);
+    if (f != NULL) LefClose(f);
 
     /* Make sure that the gate list has one entry called "pin" */
 
-    for (gateginfo = GateInfo; gateginfo; gateginfo = gateginfo->next)
-	if (!strcasecmp(gateginfo->gatetype, "pin"))
-	    break;
+    gateginfo = lefFindCell("pin");
 
     if (!gateginfo) {
 	/* Add a new GateInfo entry for pseudo-gate "pin" */
@@ -2381,8 +2608,7 @@ LefRead(inName)
 	grect->next = (DSEG)NULL;
 	gateginfo->taps[0] = grect;
 	gateginfo->obs = (DSEG)NULL;
-	gateginfo->next = GateInfo;
-	GateInfo = gateginfo;
+	lefAddCell(gateginfo);
     }
 
     /* Work through all of the defined layers, and copy the names into	*/
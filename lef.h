@@ -27,6 +27,22 @@ typedef struct
     u_char has_nets;
 } NetCount;
 
+/* A LEF or DEF file being parsed, held in memory (see LefOpen()) */
+
+typedef struct
+{
+    char *data;		/* Contents of the file (read only) */
+    char *end;		/* End of the contents */
+    char *pos;		/* Start of the next line to parse */
+    char *buf;		/* Copy of the current line, split into tokens */
+    size_t bufsize;	/* Allocated size of buf */
+    char *next;		/* Next token in buf */
+    int   line;		/* Number of the current line */
+    int   errors;	/* Number of errors reported (see LefError()) */
+    u_char mapped;	/* Contents are mapped, not allocated */
+    u_char midline;	/* Tokens remain on the current line */
+} LefFile;
+
 /* Various modes for writing nets. */
 #define DO_REGULAR  0
 #define DO_SPECIAL  1
@@ -105,22 +121,24 @@ typedef struct _lefLayer {
 } lefLayer;
 
 /* External declaration of global variables */
-extern int lefCurrentLine;
 extern LefList LefInfo;
 
 /* Forward declarations */
 
-u_char LefParseEndStatement(FILE *f, char *match);
-void  LefSkipSection(FILE *f, char *match);
-void  LefEndStatement(FILE *f);
+u_char LefParseEndStatement(LefFile *f, char *match);
+void  LefSkipSection(LefFile *f, char *match);
+void  LefEndStatement(LefFile *f);
 GATE  lefFindCell(char *name);
-char *LefNextToken(FILE *f, u_char ignore_eol);
+void  lefAddCell(GATE gateginfo);
+LefFile *LefOpen(char *filename);
+void  LefClose(LefFile *f);
+char *LefNextToken(LefFile *f, u_char ignore_eol);
 char *LefLower(char *token);
-DSEG  LefReadGeometry(GATE lefMacro, FILE *f, float oscale);
+DSEG  LefReadGeometry(GATE lefMacro, LefFile *f, float oscale);
 LefList LefRedefined(LefList lefl, char *redefname);
-void LefAddViaGeometry(FILE *f, LefList lefl, int curlayer, float oscale);
-DSEG LefReadRect(FILE *f, int curlayer, float oscale);
-int  LefReadLayer(FILE *f, u_char obstruct);
+void LefAddViaGeometry(LefFile *f, LefList lefl, int curlayer, float oscale);
+DSEG LefReadRect(LefFile *f, int curlayer, float oscale);
+int  LefReadLayer(LefFile *f, u_char obstruct);
 LefList LefFindLayer(char *token);
 LefList LefFindLayerByNum(int layer);
 int    LefFindLayerNum(char *token);
@@ -133,11 +151,12 @@ double LefGetRoutePitch(int layer);
 double LefGetRouteOffset(int layer);
 char  *LefGetRouteName(int layer);
 int    LefGetRouteOrientation(int layer);
+void   LefFreezeRules();
 
 void   LefRead(char *inName);
 float  DefRead(char *inName);
 
-void LefError(char *fmt, ...);	/* Variable argument procedure requires */
-				/* parameter list.			*/
+void LefError(LefFile *f, char *fmt, ...);	/* Variable argument procedure */
+						/* requires parameter list.	*/
 
 #endif /* _LEFINT_H */
@@ -12,6 +12,7 @@
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define  MAZE
 
@@ -20,9 +21,80 @@
 #include "node.h"
 #include "maze.h"
 #include "lef.h"
+#include "grid.h"
 
 extern int TotalRoutes;
 
+/*--------------------------------------------------------------*/
+/* reset_obs2() ---						*/
+/*								*/
+/* Invalidate the whole of Obs2[] at the start of a route for	*/
+/* net "netnum" by advancing the route generation.  Entries	*/
+/* are then refreshed from Obs[] one by one, as the search	*/
+/* reaches them, so the cost of the reset is independent of	*/
+/* the die area.						*/
+/*--------------------------------------------------------------*/
+
+void reset_obs2(int netnum)
+{
+   Obs2net = netnum;
+   Obs2epoch = __sync_add_and_fetch(&Obs2generation, 1);
+   if (Obs2epoch == 0) {
+      // Generation count wrapped around;  clear all stamps.  (When
+      // routing in parallel, route_parallel() prevents this.)
+      clear_obs2_stamps();
+      Obs2epoch = Obs2generation = 1;
+   }
+}
+
+/*--------------------------------------------------------------*/
+/* clear_obs2_stamps() ---					*/
+/*								*/
+/* Mark all of Obs2[] as untouched by any route and restart	*/
+/* the route generation count.  Not to be called while nets	*/
+/* are being routed in parallel.				*/
+/*--------------------------------------------------------------*/
+
+void clear_obs2_stamps()
+{
+   grid_clear((void **)Obs2stamp);
+   Obs2generation = 0;
+}
+
+/*--------------------------------------------------------------*/
+/* init_proute() ---						*/
+/*								*/
+/* Copy the Obs[] entry at grid offset idx on layer lay into	*/
+/* Obs2[] for the current route and stamp it with the route	*/
+/* generation.  Pin obstructions are converted to terminal	*/
+/* positions for the net being routed.  Returns a pointer to	*/
+/* the entry.  Called through the OBS2() macro.			*/
+/*--------------------------------------------------------------*/
+
+PROUTE *init_proute(int idx, int lay)
+{
+   u_int netnum, dir;
+   PROUTE *Pr;
+
+   Obs2stamp[lay][idx] = Obs2epoch;
+   Pr = &Obs2[lay][idx];
+
+   netnum = Obs[lay][idx] & (~BLOCKED_MASK);
+   if (netnum != 0) {
+      Pr->flags = 0;		// Clear all flags
+      Pr->prdata = PR_NETNUM(netnum);
+      dir = netnum & PINOBSTRUCTMASK;
+      if ((dir != 0) && ((dir & STUBROUTE_X) == STUBROUTE_X)) {
+	 if ((netnum & NETNUM_MASK) == Obs2net)
+	    Pr->prdata = 0;	// STUBROUTE_X not routable
+      }
+   } else {
+      Pr->flags = PR_COST;		// This location is routable
+      Pr->prdata = MAXRT;
+   }
+   return Pr;
+}
+
 /*--------------------------------------------------------------*/
 /* set_powerbus_to_net()					*/
 /* If we have a power or ground net, go through the entire Obs	*/
@@ -30,28 +102,46 @@ extern int TotalRoutes;
 /*								*/
 /* We do this after the call to PR_SOURCE, before the calls	*/
 /* to set PR_TARGET.						*/
+/*								*/
+/* Only the search area (RouteArea) is covered.  Obs is read	*/
+/* in storage order, a row of a tile at a time, and a row is	*/
+/* looked at position by position only if it holds the net	*/
+/* (see grid_match_row()).					*/
 /*--------------------------------------------------------------*/
 
 void
 set_powerbus_to_net(int netnum)
 {
-    int x, y, lay;
+    int x, y, lay, tx, ty, x1, y1, x2, y2;
+    u_int bits;
     PROUTE *Pr;
 
     if ((netnum == VDD_NET) || (netnum == GND_NET)) {
-       for (lay = 0; lay < Num_layers; lay++)
-          for (x = 0; x < NumChannelsX[lay]; x++)
-	     for (y = 0; y < NumChannelsY[lay]; y++)
-		if ((Obs[lay][OGRID(x, y, lay)] & NETNUM_MASK) == netnum) {
-		   Pr = &Obs2[lay][OGRID(x, y, lay)];
-		   // Skip locations that have been purposefully disabled
-		   if (!(Pr->flags & PR_COST) && (Pr->prdata.net == Numnets))
-		      continue;
-		   else if (!(Pr->flags & PR_SOURCE)) {
-		      Pr->flags |= (PR_TARGET | PR_COST);
-		      Pr->prdata.cost = MAXRT;
+       for (lay = 0; lay < Num_layers; lay++) {
+	  x1 = MAX(RouteArea.x1, 0);
+	  y1 = MAX(RouteArea.y1, 0);
+	  x2 = MIN(RouteArea.x2, NumChannelsX[lay] - 1);
+	  y2 = MIN(RouteArea.y2, NumChannelsY[lay] - 1);
+	  for (ty = y1 & ~GRID_TILE_MASK; ty <= y2; ty += GRID_TILE)
+	     for (tx = x1 & ~GRID_TILE_MASK; tx <= x2; tx += GRID_TILE)
+		for (y = MAX(ty, y1); y <= MIN(ty + GRID_TILE_MASK, y2); y++) {
+		   bits = grid_match_row(&Obs[lay][OGRID(tx, y, lay)],
+				NETNUM_MASK, (u_int)netnum);
+		   if (bits == 0) continue;
+		   for (x = MAX(tx, x1); x <= MIN(tx + GRID_TILE_MASK, x2);
+				x++) {
+		      if (!(bits & (1 << (x - tx)))) continue;
+		      Pr = OBS2(x, y, lay);
+		      // Skip locations that have been purposefully disabled
+		      if (!(Pr->flags & PR_COST) && (Pr->prdata == Numnets))
+			 continue;
+		      else if (!(Pr->flags & PR_SOURCE)) {
+			 Pr->flags |= (PR_TARGET | PR_COST);
+			 Pr->prdata = MAXRT;
+		      }
 		   }
 		}
+       }
     }
 }
 
@@ -113,9 +203,9 @@ int set_node_to_net(NODE node, int newflags, POINT *pushlist, SEG bbox, u_char s
        lay = ntap->layer;
        x = ntap->gridx;
        y = ntap->gridy;
-       Pr = &Obs2[lay][OGRID(x, y, lay)];
+       Pr = OBS2(x, y, lay);
        if ((Pr->flags & (newflags | PR_COST)) == PR_COST) {
-	  fprintf(stderr, "Error:  Tap position %d, %d layer %d not "
+	  fprintf(RTERR, "Error:  Tap position %d, %d layer %d not "
 			"marked as source!\n", x, y, lay);
 	  return -1;	// This should not happen.
        }
@@ -123,16 +213,16 @@ int set_node_to_net(NODE node, int newflags, POINT *pushlist, SEG bbox, u_char s
        if (Pr->flags & PR_SOURCE) {
 	  result = 1;				// Node is already connected!
        }
-       else if (((Pr->prdata.net == node->netnum) || (stage == (u_char)2))
+       else if (((Pr->prdata == node->netnum) || (stage == (u_char)2))
 			&& !(Pr->flags & newflags)) {
 
 	  // If we got here, we're on the rip-up stage, and there
 	  // is an existing route completely blocking the terminal.
 	  // So we will route over it and flag it as a collision.
 
-	  if (Pr->prdata.net != node->netnum) {
-	     if ((Pr->prdata.net == (NO_NET | OBSTRUCT_MASK)) ||
-			(Pr->prdata.net == NO_NET))
+	  if (Pr->prdata != node->netnum) {
+	     if ((Pr->prdata == PR_NETNUM(NO_NET | OBSTRUCT_MASK)) ||
+			(Pr->prdata == PR_NETNUM(NO_NET)))
 		continue;
 	     else
 	        Pr->flags |= PR_CONFLICT;
@@ -141,12 +231,12 @@ int set_node_to_net(NODE node, int newflags, POINT *pushlist, SEG bbox, u_char s
 	  // Do the source and dest nodes need to be marked routable?
 	  Pr->flags |= (newflags == PR_SOURCE) ? newflags : (newflags | PR_COST);
 
-	  Pr->prdata.cost = (newflags == PR_SOURCE) ? 0 : MAXRT;
+	  Pr->prdata = (newflags == PR_SOURCE) ? 0 : MAXRT;
 
 	  // push this point on the stack to process
 
 	  if (pushlist != NULL) {
-	     gpoint = (POINT)malloc(sizeof(struct point_));
+	     gpoint = alloc_point();
 	     gpoint->x1 = x;
 	     gpoint->y1 = y;
 	     gpoint->layer = lay;
@@ -163,7 +253,7 @@ int set_node_to_net(NODE node, int newflags, POINT *pushlist, SEG bbox, u_char s
 	     if (y > bbox->y2) bbox->y2 = y;
 	  }
        }
-       else if ((Pr->prdata.net < Numnets) && (Pr->prdata.net > 0)) obsnet++;
+       else if ((Pr->prdata < Numnets) && (Pr->prdata > 0)) obsnet++;
     }
 
     // Do the same for point in the halo around the tap, but only if
@@ -176,32 +266,32 @@ int set_node_to_net(NODE node, int newflags, POINT *pushlist, SEG bbox, u_char s
 
        // Don't process extended areas if they coincide with other nodes.
 
-       // if (Nodeloc[lay][OGRID(x, y, lay)] != (NODE)NULL &&
-       //	Nodeloc[lay][OGRID(x, y, lay)] != node)
+       // if (NODELOC(x, y, lay) != (NODE)NULL &&
+       //	NODELOC(x, y, lay) != node)
        // continue;
 
-       if (Nodeloc[lay][OGRID(x, y, lay)] == (NODE)NULL ||
-       	   Nodeloc[lay][OGRID(x, y, lay)] != node)
+       if (NODELOC(x, y, lay) == (NODE)NULL ||
+       	   NODELOC(x, y, lay) != node)
        continue;
 	
 
-       Pr = &Obs2[lay][OGRID(x, y, lay)];
+       Pr = OBS2(x, y, lay);
        if (Pr->flags & PR_SOURCE) {
 	  result = 1;				// Node is already connected!
        }
        else if ( !(Pr->flags & newflags) &&
-		((Pr->prdata.net == node->netnum) ||
-		(stage == (u_char)2 && Pr->prdata.net < Numnets) ||
+		((Pr->prdata == node->netnum) ||
+		(stage == (u_char)2 && Pr->prdata < Numnets) ||
 		(stage == (u_char)3))) {
 
-	  if (Pr->prdata.net != node->netnum) Pr->flags |= PR_CONFLICT;
+	  if (Pr->prdata != node->netnum) Pr->flags |= PR_CONFLICT;
 	  Pr->flags |= (newflags == PR_SOURCE) ? newflags : (newflags | PR_COST);
-	  Pr->prdata.cost = (newflags == PR_SOURCE) ? 0 : MAXRT;
+	  Pr->prdata = (newflags == PR_SOURCE) ? 0 : MAXRT;
 
 	  // push this point on the stack to process
 
 	  if (pushlist != NULL) {
-	     gpoint = (POINT)malloc(sizeof(struct point_));
+	     gpoint = alloc_point();
 	     gpoint->x1 = x;
 	     gpoint->y1 = y;
 	     gpoint->layer = lay;
@@ -218,7 +308,7 @@ int set_node_to_net(NODE node, int newflags, POINT *pushlist, SEG bbox, u_char s
 	     if (y > bbox->y2) bbox->y2 = y;
 	  }
        }
-       else if ((Pr->prdata.net < Numnets) && (Pr->prdata.net > 0)) obsnet++;
+       else if ((Pr->prdata < Numnets) && (Pr->prdata > 0)) obsnet++;
     }
 
     // In the case that no valid tap points were found,	if we're on the
@@ -263,12 +353,12 @@ int disable_node_nets(NODE node)
        lay = ntap->layer;
        x = ntap->gridx;
        y = ntap->gridy;
-       Pr = &Obs2[lay][OGRID(x, y, lay)];
+       Pr = OBS2(x, y, lay);
        if (Pr->flags & PR_SOURCE || Pr->flags & PR_TARGET || Pr->flags & PR_COST) {
 	  result = 1;
        }
-       else if (Pr->prdata.net == node->netnum) {
-	  Pr->prdata.net = Numnets;
+       else if (Pr->prdata == node->netnum) {
+	  Pr->prdata = Numnets;
        }
     }
 
@@ -279,12 +369,12 @@ int disable_node_nets(NODE node)
        lay = ntap->layer;
        x = ntap->gridx;
        y = ntap->gridy;
-       Pr = &Obs2[lay][OGRID(x, y, lay)];
+       Pr = OBS2(x, y, lay);
        if (Pr->flags & PR_SOURCE || Pr->flags & PR_TARGET || Pr->flags & PR_COST) {
 	  result = 1;
        }
-       else if (Pr->prdata.net == node->netnum) {
-	  Pr->prdata.net = Numnets;
+       else if (Pr->prdata == node->netnum) {
+	  Pr->prdata = Numnets;
        }
     }
     return result;
@@ -312,16 +402,16 @@ int set_routes_to_net(NET net, int newflags, POINT *pushlist, SEG bbox, u_char s
 	     x = seg->x1;
 	     y = seg->y1;
 	     while (1) {
-		Pr = &Obs2[lay][OGRID(x, y, lay)];
+		Pr = OBS2(x, y, lay);
 		Pr->flags |= (newflags == PR_SOURCE) ? newflags : (newflags | PR_COST);
 		// Conflicts should not happen (check for this?)
-		// if (Pr->prdata.net != node->netnum) Pr->flags |= PR_CONFLICT;
-		Pr->prdata.cost = (newflags == PR_SOURCE) ? 0 : MAXRT;
+		// if (Pr->prdata != node->netnum) Pr->flags |= PR_CONFLICT;
+		Pr->prdata = (newflags == PR_SOURCE) ? 0 : MAXRT;
 
 		// push this point on the stack to process
 
 		if (pushlist != NULL) {
-	  	   gpoint = (POINT)malloc(sizeof(struct point_));
+	  	   gpoint = alloc_point();
 	  	   gpoint->x1 = x;
 	  	   gpoint->y1 = y;
 	  	   gpoint->layer = lay;
@@ -340,7 +430,7 @@ int set_routes_to_net(NET net, int newflags, POINT *pushlist, SEG bbox, u_char s
 		// If we found another node connected to the route,
 		// then process it, too.
 
-		n2 = Nodeloc[lay][OGRID(x, y, lay)];
+		n2 = NODELOC(x, y, lay);
 		if ((n2 != (NODE)NULL) && (n2 != net->netnodes)) {
 		   result = set_node_to_net(n2, newflags, pushlist, bbox, stage);
 		   // On error, continue processing
@@ -366,6 +456,106 @@ int set_routes_to_net(NET net, int newflags, POINT *pushlist, SEG bbox, u_char s
     return result;
 }
 
+/*--------------------------------------------------------------*/
+/* make_source() ---						*/
+/*								*/
+/* Turn a position reached by the search into a source at zero	*/
+/* cost, and add it to "pushlist".				*/
+/*--------------------------------------------------------------*/
+
+static void make_source(int x, int y, int lay, POINT *pushlist)
+{
+   PROUTE *Pr;
+   POINT gpoint;
+
+   Pr = OBS2(x, y, lay);
+   if (Pr->flags & PR_SOURCE) return;
+
+   Pr->flags &= ~(PR_PRED_DMASK | PR_PROCESSED | PR_CONFLICT | PR_TARGET | PR_COST);
+   Pr->flags |= PR_SOURCE;
+   Pr->prdata = 0;
+
+   gpoint = alloc_point();
+   gpoint->x1 = x;
+   gpoint->y1 = y;
+   gpoint->layer = lay;
+   gpoint->next = *pushlist;
+   *pushlist = gpoint;
+}
+
+/*--------------------------------------------------------------*/
+/* set_route_to_source() ---					*/
+/*								*/
+/* After route "rt" of net "net" has been committed, make its	*/
+/* positions and the taps of the node it reached into sources,	*/
+/* and put them on "pushlist".  Used when the search for the	*/
+/* next leg of the net carries on from the current one, in	*/
+/* place of set_node_to_net() and set_routes_to_net().		*/
+/*--------------------------------------------------------------*/
+
+void set_route_to_source(NET net, ROUTE rt, POINT *pushlist)
+{
+   int x, y, lay;
+   SEG seg;
+   NODE n2;
+   DPOINT ntap;
+
+   for (seg = rt->segments; seg; seg = seg->next) {
+      lay = seg->layer;
+      x = seg->x1;
+      y = seg->y1;
+      while (1) {
+	 make_source(x, y, lay, pushlist);
+
+	 // The node reached by the route is no longer a target
+
+	 n2 = NODELOC(x, y, lay);
+	 if ((n2 != (NODE)NULL) && (n2->netnum == net->netnum)) {
+	    for (ntap = n2->taps; ntap; ntap = ntap->next)
+	       if (OBS2(ntap->gridx, ntap->gridy, ntap->layer)->flags & PR_TARGET)
+		  make_source(ntap->gridx, ntap->gridy, ntap->layer, pushlist);
+	    for (ntap = n2->extend; ntap; ntap = ntap->next)
+	       if (OBS2(ntap->gridx, ntap->gridy, ntap->layer)->flags & PR_TARGET)
+		  make_source(ntap->gridx, ntap->gridy, ntap->layer, pushlist);
+	 }
+
+	 // Process top part of via
+	 if (seg->segtype & ST_VIA) {
+	    if (lay != seg->layer) break;
+	    lay++;
+	    continue;
+	 }
+
+	 // Move to next grid position in segment
+	 if (x == seg->x2 && y == seg->y2) break;
+	 if (seg->x2 > seg->x1) x++;
+	 else if (seg->x2 < seg->x1) x--;
+	 if (seg->y2 > seg->y1) y++;
+	 else if (seg->y2 < seg->y1) y--;
+      }
+   }
+}
+
+/*--------------------------------------------------------------*/
+/* node_is_target() ---						*/
+/*								*/
+/* Return TRUE if any tap of "node" is still flagged as a	*/
+/* target of the current search.				*/
+/*--------------------------------------------------------------*/
+
+u_char node_is_target(NODE node)
+{
+   DPOINT ntap;
+
+   for (ntap = node->taps; ntap; ntap = ntap->next)
+      if (OBS2(ntap->gridx, ntap->gridy, ntap->layer)->flags & PR_TARGET)
+	 return TRUE;
+   for (ntap = node->extend; ntap; ntap = ntap->next)
+      if (OBS2(ntap->gridx, ntap->gridy, ntap->layer)->flags & PR_TARGET)
+	 return TRUE;
+   return FALSE;
+}
+
 /*--------------------------------------------------------------*/
 /* Find nets that are colliding with the given net "net", and	*/
 /* create and return a list of them.				*/
@@ -397,6 +587,12 @@ NETLIST find_colliding(NET net)
 
 	       if (orignet != net->netnum) {
 
+		  /* Record the collision in the congestion history */
+
+		  if ((Hist[0] != NULL) &&
+			(Hist[lay][OGRID(x, y, lay)] < (u_short)0xffff))
+		     Hist[lay][OGRID(x, y, lay)]++;
+
 	          /* Route collision.  Save this net if it is	*/
 	          /* not already in the list of colliding nets.	*/
 
@@ -405,14 +601,13 @@ NETLIST find_colliding(NET net)
 		        break;
 	          }
 	          if (cnl == NULL) {
-		     for (fnet = Nlnets; fnet; fnet = fnet->next) {
-		        if (fnet->netnum == orignet) {
-			   cnl = (NETLIST)malloc(sizeof(struct netlist_));
-		           cnl->net = fnet;
-		           cnl->next = nl;
-		           nl = cnl;
-			   break;
-			}
+		     fnet = ((orignet >= 0) && (orignet <= Numnets)) ?
+				Nettab[orignet] : NULL;
+		     if (fnet != NULL) {
+			cnl = (NETLIST)malloc(sizeof(struct netlist_));
+		        cnl->net = fnet;
+		        cnl->next = nl;
+		        nl = cnl;
 		     }
 		  }
 	       }
@@ -429,12 +624,12 @@ NETLIST find_colliding(NET net)
    /* Diagnostic */
 
    if (nl != NULL) {
-      fprintf(stderr, "Best route of %s collides with nets: ",
+      fprintf(RTERR, "Best route of %s collides with nets: ",
 		net->netname);
       for (cnl = nl; cnl; cnl = cnl->next) {
-         fprintf(stderr, "%s ", cnl->net->netname);
+         fprintf(RTERR, "%s ", cnl->net->netname);
       }
-      fprintf(stderr, "\n");
+      fprintf(RTERR, "\n");
    }
 
    return nl;
@@ -482,7 +677,7 @@ u_char ripup_net(NET net, u_char restore)
 	       oldnet = Obs[lay][OGRID(x, y, lay)] & NETNUM_MASK;
 	       if ((oldnet > 0) && (oldnet < Numnets)) {
 	          if (oldnet != thisnet) {
-		     fprintf(stderr, "Error: position %d %d layer %d has net "
+		     fprintf(RTERR, "Error: position %d %d layer %d has net "
 				"%d not %d!\n", x, y, lay, oldnet, thisnet);
 		     return FALSE;	// Something went wrong
 	          }
@@ -492,7 +687,7 @@ u_char ripup_net(NET net, u_char restore)
 		  // were routed over obstructions to reach off-grid
 		  // taps are returned to obstructions.
 
-	          if (Nodesav[lay][OGRID(x, y, lay)] == (NODE)NULL) {
+	          if (NODESAV(x, y, lay) == (NODE)NULL) {
 		     dir = Obs[lay][OGRID(x, y, lay)] & PINOBSTRUCTMASK;
 		     if (dir == 0)
 		        Obs[lay][OGRID(x, y, lay)] = 0;
@@ -548,7 +743,7 @@ u_char ripup_net(NET net, u_char restore)
 	    lay = ntap->layer;
 	    x = ntap->gridx;
 	    y = ntap->gridy;
-	    Nodeloc[lay][OGRID(x, y, lay)] = Nodesav[lay][OGRID(x, y, lay)];
+	    Nodeid[lay][OGRID(x, y, lay)] &= ~NODE_HIDDEN;
 	 }
       }
    }
@@ -569,11 +764,681 @@ u_char ripup_net(NET net, u_char restore)
    return TRUE;
 }
 
+/*--------------------------------------------------------------*/
+/* Pool of POINT records used by route_segs() for the search	*/
+/* frontier, the source list, and the route path built by	*/
+/* commit_proute().  None of these outlive a single route, so	*/
+/* records are carved out of large slabs and the whole pool is	*/
+/* reclaimed at once by reset_points() at the start of the next	*/
+/* route.  The slabs themselves are kept for reuse.  Each	*/
+/* routing thread has a pool of its own.			*/
+/*--------------------------------------------------------------*/
+
+#define POINT_SLAB 4096
+
+typedef struct pointslab_ *POINTSLAB;
+
+struct pointslab_ {
+   POINTSLAB next;
+   struct point_ pts[POINT_SLAB];
+};
+
+static THREAD_LOCAL POINTSLAB PointSlabs = NULL;  // All slabs allocated so far
+static THREAD_LOCAL POINTSLAB CurSlab = NULL;	  // Slab being carved up
+static THREAD_LOCAL int SlabUsed = 0;		  // Records used in CurSlab
+static THREAD_LOCAL POINT PointFree = NULL;	  // Records returned by free_point()
+
+/*--------------------------------------------------------------*/
+/* reset_points() ---						*/
+/*								*/
+/* Return every POINT record to the pool.  Any POINT obtained	*/
+/* from alloc_point() before this call is no longer valid.	*/
+/*--------------------------------------------------------------*/
+
+void reset_points()
+{
+   CurSlab = NULL;
+   SlabUsed = 0;
+   PointFree = NULL;
+}
+
+/*--------------------------------------------------------------*/
+/* alloc_point() ---						*/
+/*								*/
+/* Get a POINT record from the pool, reusing one released with	*/
+/* free_point() if available.  Fields are not initialized.	*/
+/*--------------------------------------------------------------*/
+
+POINT alloc_point()
+{
+   POINT gpoint;
+   POINTSLAB slab;
+
+   if (PointFree != NULL) {
+      gpoint = PointFree;
+      PointFree = gpoint->next;
+      return gpoint;
+   }
+
+   if ((CurSlab == NULL) || (SlabUsed == POINT_SLAB)) {
+      slab = (CurSlab == NULL) ? PointSlabs : CurSlab->next;
+      if (slab == NULL) {
+	 slab = (POINTSLAB)malloc(sizeof(struct pointslab_));
+	 slab->next = NULL;
+	 if (CurSlab == NULL)
+	    PointSlabs = slab;
+	 else
+	    CurSlab->next = slab;
+      }
+      CurSlab = slab;
+      SlabUsed = 0;
+   }
+   return &CurSlab->pts[SlabUsed++];
+}
+
+/*--------------------------------------------------------------*/
+/* free_point() ---						*/
+/*								*/
+/* Give a POINT record back to the pool for reuse within the	*/
+/* current route.						*/
+/*--------------------------------------------------------------*/
+
+void free_point(POINT gpoint)
+{
+   gpoint->next = PointFree;
+   PointFree = gpoint;
+}
+
+/*--------------------------------------------------------------*/
+/* pqueue_init() ---						*/
+/*								*/
+/* Initialize an empty search frontier (see PQUEUE in		*/
+/* qrouter.h).  The ring starts out large enough to span the	*/
+/* usual single-step costs and is grown on demand.		*/
+/*--------------------------------------------------------------*/
+
+#define PQ_INIT_BUCKETS 256
+
+void pqueue_init(PQUEUE *pq)
+{
+   pq->nbuckets = PQ_INIT_BUCKETS;
+   pq->bucket = (POINT *)calloc(pq->nbuckets, sizeof(POINT));
+   pq->mincost = 0;
+   pq->count = 0;
+}
+
+/*--------------------------------------------------------------*/
+/* pqueue_free() ---						*/
+/*								*/
+/* Release the bucket ring.  Any entries remaining on the	*/
+/* frontier belong to the POINT pool and are reclaimed by the	*/
+/* next reset_points().						*/
+/*--------------------------------------------------------------*/
+
+void pqueue_free(PQUEUE *pq)
+{
+   free(pq->bucket);
+   pq->bucket = NULL;
+   pq->nbuckets = 0;
+   pq->count = 0;
+}
+
+/*--------------------------------------------------------------*/
+/* pqueue_grow() ---						*/
+/*								*/
+/* Enlarge the bucket ring so that it spans at least "span"	*/
+/* cost values above the current minimum.  Every cost in the	*/
+/* queue lies in [mincost, mincost + nbuckets), so each bucket	*/
+/* list moves intact to its slot in the larger ring.		*/
+/*--------------------------------------------------------------*/
+
+static void pqueue_grow(PQUEUE *pq, u_int span)
+{
+   POINT *newbucket;
+   int newsize, i;
+   u_int cost;
+
+   newsize = pq->nbuckets;
+   while ((u_int)newsize <= span) newsize <<= 1;
+
+   newbucket = (POINT *)calloc(newsize, sizeof(POINT));
+   for (i = 0; i < pq->nbuckets; i++) {
+      cost = pq->mincost + i;
+      newbucket[cost & (newsize - 1)] = pq->bucket[cost & (pq->nbuckets - 1)];
+   }
+   free(pq->bucket);
+   pq->bucket = newbucket;
+   pq->nbuckets = newsize;
+}
+
+/*--------------------------------------------------------------*/
+/* pqueue_push() ---						*/
+/*								*/
+/* Add grid position (x, y, lay) to the frontier at the given	*/
+/* cost.  Within a bucket, entries are last-in, first-out, so	*/
+/* that among routes of equal cost the most recently pushed	*/
+/* direction (the preferred one) is tried first.		*/
+/*--------------------------------------------------------------*/
+
+void pqueue_push(PQUEUE *pq, int x, int y, int lay, u_int cost)
+{
+   POINT gpoint;
+   int idx;
+
+   // No cost may be pushed below the cost last popped.  (This would
+   // indicate a negative step cost;  keep the queue consistent anyway.)
+   if (cost < pq->mincost)
+      cost = pq->mincost;
+
+   if (cost - pq->mincost >= (u_int)pq->nbuckets)
+      pqueue_grow(pq, cost - pq->mincost);
+
+   gpoint = alloc_point();
+   gpoint->x1 = x;
+   gpoint->y1 = y;
+   gpoint->layer = lay;
+
+   idx = cost & (pq->nbuckets - 1);
+   gpoint->next = pq->bucket[idx];
+   pq->bucket[idx] = gpoint;
+   pq->count++;
+}
+
+/*--------------------------------------------------------------*/
+/* pqueue_pop() ---						*/
+/*								*/
+/* Remove and return the lowest-cost entry of the frontier,	*/
+/* with its cost placed in "cost".  If the queue is empty, or	*/
+/* if the lowest cost exceeds "maxcost", return NULL and leave	*/
+/* the queue intact, so that the search can be resumed with a	*/
+/* larger maxcost.  The caller releases the returned POINT	*/
+/* with free_point().						*/
+/*--------------------------------------------------------------*/
+
+POINT pqueue_pop(PQUEUE *pq, u_int maxcost, u_int *cost)
+{
+   POINT gpoint;
+   int idx;
+
+   if (pq->count == 0) return NULL;
+
+   while (pq->bucket[pq->mincost & (pq->nbuckets - 1)] == NULL)
+      pq->mincost++;
+
+   if (pq->mincost > maxcost) return NULL;
+
+   idx = pq->mincost & (pq->nbuckets - 1);
+   gpoint = pq->bucket[idx];
+   pq->bucket[idx] = gpoint->next;
+   pq->count--;
+
+   *cost = pq->mincost;
+   return gpoint;
+}
+
+/*--------------------------------------------------------------*/
+/* Bounding boxes of the target taps of each unrouted node of	*/
+/* the net being routed.  Used to compute the lower bound on	*/
+/* the remaining cost of a route for the A* search mode.	*/
+/*--------------------------------------------------------------*/
+
+struct tbox_ {
+   int x1, y1, x2, y2;
+   int lay1, lay2;
+};
+
+THREAD_LOCAL struct tbox_ *TargetBox = NULL;
+THREAD_LOCAL int NumTargetBoxes = 0;
+THREAD_LOCAL int MaxTargetBoxes = 0;
+
+/*--------------------------------------------------------------*/
+/* astar_bound_tap() ---					*/
+/*								*/
+/* Add tap position (x, y, lay) to the target box "tb" if it	*/
+/* has been marked as a target in Obs2[].  Return 1 if the	*/
+/* position was added, 0 if not.				*/
+/*--------------------------------------------------------------*/
+
+int astar_bound_tap(struct tbox_ *tb, int x, int y, int lay, u_char empty)
+{
+   if (!(OBS2(x, y, lay)->flags & PR_TARGET)) return 0;
+
+   if (empty) {
+      tb->x1 = tb->x2 = x;
+      tb->y1 = tb->y2 = y;
+      tb->lay1 = tb->lay2 = lay;
+   }
+   else {
+      if (x < tb->x1) tb->x1 = x;
+      if (x > tb->x2) tb->x2 = x;
+      if (y < tb->y1) tb->y1 = y;
+      if (y > tb->y2) tb->y2 = y;
+      if (lay < tb->lay1) tb->lay1 = lay;
+      if (lay > tb->lay2) tb->lay2 = lay;
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------*/
+/* astar_set_targets() ---					*/
+/*								*/
+/* After set_node_to_net() has flagged the taps of the		*/
+/* unrouted nodes of "net" as PR_TARGET, record one bounding	*/
+/* box per node enclosing its target taps.  Return the number	*/
+/* of target boxes recorded.					*/
+/*--------------------------------------------------------------*/
+
+int astar_set_targets(NET net)
+{
+   NODE node;
+   DPOINT ntap;
+   u_char empty;
+   struct tbox_ *tb;
+
+   NumTargetBoxes = 0;
+
+   for (node = net->netnodes; node; node = node->next) {
+      if (NumTargetBoxes == MaxTargetBoxes) {
+	 MaxTargetBoxes = (MaxTargetBoxes == 0) ? 16 : MaxTargetBoxes << 1;
+	 TargetBox = (struct tbox_ *)realloc(TargetBox,
+			MaxTargetBoxes * sizeof(struct tbox_));
+      }
+      tb = &TargetBox[NumTargetBoxes];
+      empty = (u_char)1;
+
+      for (ntap = node->taps; ntap; ntap = ntap->next)
+	 if (astar_bound_tap(tb, ntap->gridx, ntap->gridy, ntap->layer, empty))
+	    empty = (u_char)0;
+      for (ntap = node->extend; ntap; ntap = ntap->next)
+	 if (astar_bound_tap(tb, ntap->gridx, ntap->gridy, ntap->layer, empty))
+	    empty = (u_char)0;
+
+      if (!empty) NumTargetBoxes++;
+   }
+   return NumTargetBoxes;
+}
+
+/*--------------------------------------------------------------*/
+/* astar_cost() ---						*/
+/*								*/
+/* Return a lower bound on the cost of any route from grid	*/
+/* position (x, y, lay) to the nearest target.  Each grid step	*/
+/* costs at least the lesser of SegCost and JogCost, and each	*/
+/* layer change costs at least ViaCost, so the bound is		*/
+/* admissible.  It changes by no more than the cost of a single	*/
+/* step, so points still settle at their minimum cost.		*/
+/*--------------------------------------------------------------*/
+
+u_int astar_cost(int x, int y, int lay)
+{
+   int i, dx, dy, dl, stepcost;
+   u_int cost, mincost;
+   struct tbox_ *tb;
+
+   stepcost = MIN(SegCost, JogCost);
+   mincost = 0;
+
+   for (i = 0; i < NumTargetBoxes; i++) {
+      tb = &TargetBox[i];
+      dx = (x < tb->x1) ? tb->x1 - x : (x > tb->x2) ? x - tb->x2 : 0;
+      dy = (y < tb->y1) ? tb->y1 - y : (y > tb->y2) ? y - tb->y2 : 0;
+      dl = (lay < tb->lay1) ? tb->lay1 - lay : (lay > tb->lay2) ? lay - tb->lay2 : 0;
+      cost = (dx + dy) * stepcost + dl * ViaCost;
+      if (i == 0 || cost < mincost) mincost = cost;
+      if (mincost == 0) break;
+   }
+   return mincost;
+}
+
+/*--------------------------------------------------------------*/
+/* push_point() ---						*/
+/*								*/
+/* Place grid position (x, y, lay) on the search frontier,	*/
+/* keyed on its route cost in Obs2[].  If "astar" is set, add	*/
+/* the lower bound on the cost from there to a target, so that	*/
+/* positions leading toward a target are expanded first.	*/
+/*--------------------------------------------------------------*/
+
+void push_point(PQUEUE *pq, int x, int y, int lay, u_char astar)
+{
+   u_int cost;
+
+   cost = OBS2(x, y, lay)->prdata;
+   if (astar) cost += astar_cost(x, y, lay);
+   pqueue_push(pq, x, y, lay, cost);
+}
+
+/*--------------------------------------------------------------*/
+/* pqueue_reseed() ---						*/
+/*								*/
+/* Move the points on "list" onto the search frontier, keyed	*/
+/* as by push_point().  These are points that were set aside	*/
+/* earlier, so their cost may be below that of the last point	*/
+/* taken from the frontier.  The minimum cost of the frontier	*/
+/* is lowered to the lowest cost on the list, growing the ring	*/
+/* as needed to keep all entries of the frontier in range.	*/
+/*--------------------------------------------------------------*/
+
+void pqueue_reseed(PQUEUE *pq, POINT *list, u_char astar)
+{
+   POINT gpoint;
+   u_int cost, mincost;
+   int top;
+
+   mincost = pq->mincost;
+   for (gpoint = *list; gpoint; gpoint = gpoint->next) {
+      cost = OBS2(gpoint->x1, gpoint->y1, gpoint->layer)->prdata;
+      if (astar) cost += astar_cost(gpoint->x1, gpoint->y1, gpoint->layer);
+      if (cost < mincost) mincost = cost;
+   }
+
+   if (mincost < pq->mincost) {
+      if (pq->count > 0) {
+	 // Find the highest cost on the frontier, and make room for it
+	 // above the new minimum.
+	 for (top = pq->nbuckets - 1; top > 0; top--)
+	    if (pq->bucket[(pq->mincost + top) & (pq->nbuckets - 1)] != NULL)
+	       break;
+	 if (pq->mincost - mincost + top >= (u_int)pq->nbuckets)
+	    pqueue_grow(pq, pq->mincost - mincost + top);
+      }
+      pq->mincost = mincost;
+   }
+
+   while ((gpoint = *list) != NULL) {
+      *list = gpoint->next;
+      push_point(pq, gpoint->x1, gpoint->y1, gpoint->layer, astar);
+      free_point(gpoint);
+   }
+}
+
+/*--------------------------------------------------------------*/
+/* jump_length() ---						*/
+/*								*/
+/* Number of grid steps the search may take at once from	*/
+/* "ept" in the direction given by "flags" (as for		*/
+/* eval_pt()), the preferred direction of the layer:  the	*/
+/* free track run from there (see find_track_runs()), cut	*/
+/* short at the edge of the route area and at the first	*/
+/* column (or row) lined up with a target box, where the	*/
+/* route may have to turn.					*/
+/* Return 1 if "ept" is lined up with a target box already.	*/
+/*--------------------------------------------------------------*/
+
+static int jump_length(GRIDP *ept, u_char flags)
+{
+   int i, len, pos, lo, hi;
+   u_char horiz;
+   u_int run;
+   struct tbox_ *tb;
+
+   run = Runs[ept->lay][ept->idx];
+   horiz = ((flags == PR_PRED_W) || (flags == PR_PRED_E)) ? TRUE : FALSE;
+   pos = (horiz) ? ept->x : ept->y;
+
+   switch (flags) {
+      case PR_PRED_W:		// east
+	 len = MIN(RUN_AHEAD(run), MIN(RouteArea.x2,
+			NumChannelsX[ept->lay] - 1) - pos);
+	 break;
+      case PR_PRED_E:		// west
+	 len = MIN(RUN_BEHIND(run), pos - MAX(RouteArea.x1, 0));
+	 break;
+      case PR_PRED_S:		// north
+	 len = MIN(RUN_AHEAD(run), MIN(RouteArea.y2,
+			NumChannelsY[ept->lay] - 1) - pos);
+	 break;
+      case PR_PRED_N:		// south
+	 len = MIN(RUN_BEHIND(run), pos - MAX(RouteArea.y1, 0));
+	 break;
+      default:
+	 return 1;
+   }
+
+   for (i = 0; i < NumTargetBoxes; i++) {
+      tb = &TargetBox[i];
+      lo = (horiz) ? tb->x1 : tb->y1;
+      hi = (horiz) ? tb->x2 : tb->y2;
+      if ((pos >= lo) && (pos <= hi)) return 1;
+      if ((flags == PR_PRED_W) || (flags == PR_PRED_S)) {
+	 if ((lo > pos) && (lo - pos < len)) len = lo - pos;
+      }
+      else {
+	 if ((hi < pos) && (pos - hi < len)) len = pos - hi;
+      }
+   }
+   return len;
+}
+
+/*--------------------------------------------------------------*/
+/* jump_state() ---						*/
+/*								*/
+/* Record which of position "pt" and the positions above,	*/
+/* below and to either side of it (across the track, in the	*/
+/* direction given by "horiz") are free in Obs.  Runs[] is	*/
+/* found before routing (see find_track_runs()), and Nodeid	*/
+/* does not change after, so inside a run this is all that	*/
+/* the routes placed since can have changed.  Return 0 if	*/
+/* "pt" itself is not free.					*/
+/*--------------------------------------------------------------*/
+
+#define JUMP_FREE(lay, idx) ((Obs[lay][idx] & ~BLOCKED_MASK) == 0)
+
+static u_int jump_state(GRIDP *pt, u_char horiz)
+{
+   u_int state;
+   int lay = pt->lay;
+
+   if (!JUMP_FREE(lay, pt->idx)) return 0;
+
+   state = 0x01;
+   if ((lay > 0) && JUMP_FREE(lay - 1, pt->idx)) state |= 0x02;
+   if ((lay < Num_layers - 1) && JUMP_FREE(lay + 1, pt->idx)) state |= 0x04;
+   if (horiz) {
+      if ((pt->y > 0) && JUMP_FREE(lay, OGRID_SOUTH(pt->idx, pt->y)))
+	 state |= 0x08;
+      if ((pt->y < NumChannelsY[lay] - 1) &&
+		JUMP_FREE(lay, OGRID_NORTH(pt->idx, pt->y)))
+	 state |= 0x10;
+   }
+   else {
+      if ((pt->x > 0) && JUMP_FREE(lay, OGRID_WEST(pt->idx, pt->x)))
+	 state |= 0x08;
+      if ((pt->x < NumChannelsX[lay] - 1) &&
+		JUMP_FREE(lay, OGRID_EAST(pt->idx, pt->x)))
+	 state |= 0x10;
+   }
+   return state;
+}
+
+/*--------------------------------------------------------------*/
+/* jump_pt() ---						*/
+/*								*/
+/* Take as many grid steps at once from "ept" in the		*/
+/* direction given by "flags" as jump_length() allows, setting	*/
+/* the cost and predecessor of each position reached at a	*/
+/* lower cost, as eval_pt() would.  Stop at a position	*/
+/* that is not free, is a target, is outside "mask" (if not	*/
+/* NULL, the route mask of the layer), cannot be reached at	*/
+/* a lower cost, or where a route placed since Runs[] was	*/
+/* found has changed the track (see jump_state()).  The	*/
+/* positions passed over are not put on the frontier;  only	*/
+/* the last one reached, which is left in "end", needs to	*/
+/* be.  Return the number of steps taken, or 0 if there is	*/
+/* no run to jump along, in which case the step should be	*/
+/* made by eval_pt().						*/
+/*--------------------------------------------------------------*/
+
+int jump_pt(GRIDP *ept, u_char flags, u_char *mask, GRIDP *end)
+{
+   GRIDP cur, next;
+   PROUTE *Pr;
+   int n, len;
+   u_int cost, state;
+   u_char horiz;
+
+   len = jump_length(ept, flags);
+   if (len <= 1) return 0;
+
+   horiz = ((flags == PR_PRED_W) || (flags == PR_PRED_E)) ? TRUE : FALSE;
+   state = jump_state(ept, horiz);
+   if (state == 0) return 0;
+
+   cur = *ept;
+   for (n = 0; n < len; n++) {
+      next = cur;
+      switch (flags) {
+	 case PR_PRED_N:
+	    next.idx = OGRID_SOUTH(next.idx, next.y);
+	    next.y--;
+	    break;
+	 case PR_PRED_S:
+	    next.idx = OGRID_NORTH(next.idx, next.y);
+	    next.y++;
+	    break;
+	 case PR_PRED_E:
+	    next.idx = OGRID_WEST(next.idx, next.x);
+	    next.x--;
+	    break;
+	 case PR_PRED_W:
+	    next.idx = OGRID_EAST(next.idx, next.x);
+	    next.x++;
+	    break;
+      }
+
+      Pr = OBS2_AT(next.idx, next.lay);
+      if (Pr->flags & (PR_PROCESSED | PR_CONFLICT)) break;
+      if (!(Pr->flags & PR_COST)) break;
+      if ((mask != NULL) && (mask[next.idx] == (u_char)0)) break;
+      if (jump_state(&next, horiz) != state) break;
+
+      cost = cur.cost + step_cost(&cur, &next);
+      if (cost >= Pr->prdata) break;
+
+      Pr->flags &= ~PR_PRED_DMASK;
+      Pr->flags |= flags;
+      Pr->prdata = cost;
+      next.cost = cost;
+      cur = next;
+
+      if (Pr->flags & PR_TARGET) {
+	 n++;
+	 break;
+      }
+   }
+   *end = cur;
+   return n;
+}
+
+// Cost of a step along x and along y on each layer, from Vert[]
+
+static int StepCostX[MAX_LAYERS];
+static int StepCostY[MAX_LAYERS];
+
+/*--------------------------------------------------------------*/
+/* set_step_costs() ---						*/
+/*								*/
+/* Fill in the cost of a step along x and along y on each	*/
+/* layer.  Called once the route costs and the layer		*/
+/* directions are known, before routing.			*/
+/*--------------------------------------------------------------*/
+
+void set_step_costs()
+{
+    int i;
+
+    for (i = 0; i < Num_layers; i++) {
+       StepCostX[i] = Vert[i] * JogCost + (1 - Vert[i]) * SegCost;
+       StepCostY[i] = Vert[i] * SegCost + (1 - Vert[i]) * JogCost;
+    }
+}
+
+/*--------------------------------------------------------------*/
+/* cross_cost() ---						*/
+/*								*/
+/* Cost of routing over or under the nodes above and below	*/
+/* position "newpt", as flagged in "cross" (from Crossing[]).	*/
+/* Nodes of the net being routed cost nothing at its own	*/
+/* source and target positions, and nodes of finished nets	*/
+/* are hidden.							*/
+/*--------------------------------------------------------------*/
+
+static int cross_cost(GRIDP *newpt, u_char cross)
+{
+    int thiscost = 0;
+    NODE node;
+    PROUTE *Pt;
+
+    // "BlockCost" is used if the node has only one point to connect to,
+    // so that routing over it could block it entirely.
+
+    if (cross & CROSS_BELOW) {
+	if ((node = NODELOC_AT(newpt->idx, newpt->lay - 1)) != (NODE)NULL) {
+	    Pt = OBS2_AT(newpt->idx, newpt->lay - 1);
+	    if (!(Pt->flags & PR_TARGET) && !(Pt->flags & PR_SOURCE)) {
+		if (node->taps && (node->taps->next == NULL))
+		   thiscost += BlockCost;	// Cost to block out a tap
+		else
+	           thiscost += XverCost;	// Cross-under cost
+	    }
+	}
+    }
+    if (cross & CROSS_ABOVE) {
+	if ((node = NODELOC_AT(newpt->idx, newpt->lay + 1)) != (NODE)NULL) {
+	    Pt = OBS2_AT(newpt->idx, newpt->lay + 1);
+	    if (!(Pt->flags & PR_TARGET) && !(Pt->flags & PR_SOURCE)) {
+		if (node->taps && (node->taps->next == NULL))
+		   thiscost += BlockCost;	// Cost to block out a tap
+		else
+	           thiscost += XverCost;	// Cross-over cost
+	    }
+	}
+    }
+    return thiscost;
+}
+
+/*--------------------------------------------------------------*/
+/* step_cost() ---						*/
+/*								*/
+/* Cost to step from position "ept" to the neighboring		*/
+/* position "newpt" (whose idx must be set), not counting any	*/
+/* collision with another net.  Used by eval_pt() and by	*/
+/* the pattern router (see pattern.c).  The step itself costs a	*/
+/* table lookup;  the cost of crossing nodes is worked out	*/
+/* only where Crossing[] says there are any.			*/
+/*--------------------------------------------------------------*/
+
+int step_cost(GRIDP *ept, GRIDP *newpt)
+{
+    int thiscost;
+    u_char cross;
+
+    if (ept->lay != newpt->lay)
+       thiscost = ViaCost;
+    else if (ept->x != newpt->x)
+       thiscost = StepCostX[newpt->lay];
+    else
+       thiscost = StepCostY[newpt->lay];
+
+    cross = Crossing[newpt->lay][newpt->idx];
+    if (cross != 0) thiscost += cross_cost(newpt, cross);
+
+    // Negotiated congestion:  positions fought over before cost more
+
+    if (Hist[0] != NULL)
+       thiscost += HistCost * Hist[newpt->lay][newpt->idx];
+
+    return thiscost;
+}
+
 /*--------------------------------------------------------------*/
 /* eval_pt - evaluate cost to get from given point to		*/
-/*	current point.  Current point is passed in "ept", and	*/
-/* 	the direction from the new point to the current point	*/
-/*	is indicated by "flags".				*/
+/*	current point.  Current point is passed in "ept", the	*/
+/*	new point (its neighbor, found by expand_pt(), which	*/
+/*	knows the direction) in "newpt", and the direction	*/
+/*	from the new point to the current point is indicated	*/
+/*	by "flags".  Inlined into expand_pt(), where "flags"	*/
+/*	and "stage" are constants.				*/
 /*								*/
 /*	ONLY consider the cost of the single step itself.	*/
 /*								*/
@@ -585,54 +1450,48 @@ u_char ripup_net(NET net, u_char restore)
 /*	those nets, add them to the "failed" stack, and re-	*/
 /*	route this one.						*/
 /*								*/
+/*	Points are expanded from the frontier in order of	*/
+/*	cost, so a point already marked PR_PROCESSED has	*/
+/*	settled at its minimum cost and is not revisited.	*/
+/*								*/
 /*  ARGS: none							*/
-/*  RETURNS: 1 if node needs to be (re)processed, 0 if not.	*/
+/*  RETURNS: 1 if node needs to be processed, 0 if not.		*/
 /*  SIDE EFFECTS: none (get this right or else)			*/
 /*--------------------------------------------------------------*/
 
-int eval_pt(GRIDP *ept, u_char flags, u_char stage)
+static ALWAYS_INLINE int eval_pt(GRIDP *ept, GRIDP *newpt, u_char flags,
+		u_char stage)
 {
     int thiscost = 0;
-    NODE node;
     NETLIST nl;
-    PROUTE *Pr, *Pt;
-    GRIDP newpt;
-
-    newpt = *ept;
-
-    switch (flags) {
-       case PR_PRED_N:
-	  newpt.y--;
-	  break;
-       case PR_PRED_S:
-	  newpt.y++;
-	  break;
-       case PR_PRED_E:
-	  newpt.x--;
-	  break;
-       case PR_PRED_W:
-	  newpt.x++;
-	  break;
-       case PR_PRED_U:
-	  newpt.lay--;
-	  break;
-       case PR_PRED_D:
-	  newpt.lay++;
-	  break;
+    PROUTE *Pr;
+
+#ifdef GRID_DEBUG
+    if (newpt->idx != OGRID(newpt->x, newpt->y, newpt->lay)) {
+       fprintf(RTERR, "Bad grid step to (%d %d %d)!\n", newpt->x, newpt->y,
+		newpt->lay);
+       abort();
     }
+#endif
 
-    Pr = &Obs2[newpt.lay][OGRID(newpt.x, newpt.y, newpt.lay)];
+    Pr = OBS2_AT(newpt->idx, newpt->lay);
+
+    // Already at minimum cost, unless the search carries on from the
+    // last leg of the net, or the route mask has been widened, when new
+    // sources may lower the cost.
+
+    if ((Pr->flags & PR_PROCESSED) && !RouteReopen) return 0;
 
     if (!(Pr->flags & (PR_COST | PR_SOURCE))) {
        // 2nd stage allows routes to cross existing routes
-       if (stage && (Pr->prdata.net < Numnets)) {
-	  if (Nodesav[newpt.lay][OGRID(newpt.x, newpt.y, newpt.lay)] != NULL)
+       if (stage && (Pr->prdata < Numnets)) {
+	  if (NODESAV_AT(newpt->idx, newpt->lay) != NULL)
 	     return 0;			// But cannot route over terminals!
 
 	  // Is net k in the "noripup" list?  If so, don't route it */
 
 	  for (nl = CurNet->noripup; nl; nl = nl->next) {
-	     if (nl->net->netnum == Pr->prdata.net)
+	     if (nl->net->netnum == Pr->prdata)
 		return 0;
 	  }
 
@@ -642,64 +1501,31 @@ int eval_pt(GRIDP *ept, u_char flags, u_char stage)
 	  // the Obs[][] array.
 
 	  Pr->flags |= (PR_CONFLICT | PR_COST);
-	  Pr->prdata.cost = MAXRT;
-	  thiscost = ConflictCost;
+	  Pr->prdata = MAXRT;
+	  thiscost = ConflictCost * PresFactor;
        }
        else
           return 0;		// Position is not routeable
     }
 
-    // Compute the cost to step from the current point to the new point.
-    // "BlockCost" is used if the node has only one point to connect to,
-    // so that routing over it could block it entirely.
+    // Compute the cost to step from the current point to the new point,
+    // and add it to the cost of the original position
 
-    if (newpt.lay > 0) {
-	if ((node = Nodeloc[newpt.lay - 1][OGRID(newpt.x, newpt.y, newpt.lay - 1)])
-			!= (NODE)NULL) {
-	    Pt = &Obs2[newpt.lay - 1][OGRID(newpt.x, newpt.y, newpt.lay - 1)];
-	    if (!(Pt->flags & PR_TARGET) && !(Pt->flags & PR_SOURCE)) {
-		if (node->taps && (node->taps->next == NULL))
-		   thiscost += BlockCost;	// Cost to block out a tap
-		else
-	           thiscost += XverCost;	// Cross-under cost
-	    }
-	}
-    }
-    if (newpt.lay < Num_layers - 1) {
-	if ((node = Nodeloc[newpt.lay + 1][OGRID(newpt.x, newpt.y, newpt.lay + 1)])
-			!= (NODE)NULL) {
-	    Pt = &Obs2[newpt.lay + 1][OGRID(newpt.x, newpt.y, newpt.lay + 1)];
-	    if (!(Pt->flags & PR_TARGET) && !(Pt->flags & PR_SOURCE)) {
-		if (node->taps && (node->taps->next == NULL))
-		   thiscost += BlockCost;	// Cost to block out a tap
-		else
-	           thiscost += XverCost;	// Cross-over cost
-	    }
-	}
-    }
-    if (ept->lay != newpt.lay) thiscost += ViaCost;
-    if (ept->x != newpt.x) thiscost += (Vert[newpt.lay] * JogCost +
-			(1 - Vert[newpt.lay]) * SegCost);
-    if (ept->y != newpt.y) thiscost += (Vert[newpt.lay] * SegCost +
-			(1 - Vert[newpt.lay]) * JogCost);
-
-    // Add the cost to the cost of the original position
-    thiscost += ept->cost;
+    thiscost += step_cost(ept, newpt) + ept->cost;
    
     // Replace node information if cost is minimum
 
     if (Pr->flags & PR_CONFLICT)
-       thiscost += ConflictCost;	// For 2nd stage routes
+       thiscost += ConflictCost * PresFactor;	// For 2nd stage routes
 
-    if (thiscost < Pr->prdata.cost) {
-       Pr->flags &= ~PR_PRED_DMASK;
+    if (thiscost < Pr->prdata) {
+       Pr->flags &= ~(PR_PRED_DMASK | PR_PROCESSED);
        Pr->flags |= flags;
-       Pr->prdata.cost = thiscost;
-       Pr->flags &= ~PR_PROCESSED;	// Need to reprocess this node
+       Pr->prdata = thiscost;
 
        if (Verbose > 0) {
-	  fprintf(stdout, "New cost %d at (%d %d %d)\n", thiscost,
-		newpt.x, newpt.y, newpt.lay);
+	  fprintf(RTOUT, "New cost %d at (%d %d %d)\n", thiscost,
+		newpt->x, newpt->y, newpt->lay);
        }
        return 1;
     }
@@ -707,6 +1533,148 @@ int eval_pt(GRIDP *ept, u_char flags, u_char stage)
 
 } /* eval_pt() */
 
+/*--------------------------------------------------------------*/
+/* expand_pt() ---						*/
+/*								*/
+/* Evaluate the steps from "curpt", just taken from the		*/
+/* frontier, to each of its neighbors, and put each neighbor	*/
+/* whose cost is lowered onto "frontier" (or, if "jump" is	*/
+/* set, the end of a jump along the track;  see jump_pt()).	*/
+/* "mask" is the route mask of the layer of "curpt", or NULL.	*/
+/* The search calls it through expand_pt_stage0() or		*/
+/* expand_pt_stage1(), chosen by the routing stage, so that	*/
+/* "stage" is a constant in each inlined copy of eval_pt().	*/
+/*--------------------------------------------------------------*/
+
+static ALWAYS_INLINE void expand_pt(GRIDP *curpt, PQUEUE *frontier,
+		u_char *mask, u_char jump, u_char astar, u_char stage)
+{
+   GRIDP newpt, jumpt;
+   u_char check_order[6];
+   u_int forbid;
+   int i, o;
+
+   // check east/west/north/south, and bottom to top
+
+   // 1st optimization:  Direction of route on current layer is preferred.
+   o = LefGetRouteOrientation(curpt->lay);
+   forbid = Obs[curpt->lay][curpt->idx] & BLOCKED_MASK;
+
+   if (o == 1) {			// horizontal routes---check EAST and WEST first
+      check_order[0] = (forbid & BLOCKED_E) ? 0 : EAST;
+      check_order[1] = (forbid & BLOCKED_W) ? 0 : WEST;
+      check_order[2] = UP;
+      check_order[3] = DOWN;
+      check_order[4] = (forbid & BLOCKED_N) ? 0 : NORTH;
+      check_order[5] = (forbid & BLOCKED_S) ? 0 : SOUTH;
+   }
+   else {				// vertical routes---check NORTH and SOUTH first
+      check_order[0] = (forbid & BLOCKED_N) ? 0 : NORTH;
+      check_order[1] = (forbid & BLOCKED_S) ? 0 : SOUTH;
+      check_order[2] = UP;
+      check_order[3] = DOWN;
+      check_order[4] = (forbid & BLOCKED_E) ? 0 : EAST;
+      check_order[5] = (forbid & BLOCKED_W) ? 0 : WEST;
+   }
+
+   // Check order is from 0 (1st priority) to 5 (last priority).  Among
+   // positions of equal cost, the frontier returns the last one placed
+   // on it first.  Therefore we evaluate and drop positions to check
+   // on the frontier in reverse order (5 to 0).
+
+   for (i = 5; i >= 0; i--) {
+      switch (check_order[i]) {
+	 case EAST:
+	    if (((curpt->x + 1) < NumChannelsX[curpt->lay]) &&
+		     ((curpt->x + 1) <= RouteArea.x2)) {
+	       if (jump && (o == 1) && jump_pt(curpt, PR_PRED_W, mask, &jumpt))
+		  push_point(frontier, jumpt.x, jumpt.y, jumpt.lay, astar);
+	       else {
+		  newpt = *curpt;
+		  newpt.idx = OGRID_EAST(newpt.idx, newpt.x);
+		  newpt.x++;
+		  if (eval_pt(curpt, &newpt, PR_PRED_W, stage))
+		     push_point(frontier, newpt.x, newpt.y, newpt.lay, astar);
+	       }
+	    }
+	    break;
+
+	 case WEST:
+	    if (((curpt->x - 1) >= 0) && ((curpt->x - 1) >= RouteArea.x1)) {
+	       if (jump && (o == 1) && jump_pt(curpt, PR_PRED_E, mask, &jumpt))
+		  push_point(frontier, jumpt.x, jumpt.y, jumpt.lay, astar);
+	       else {
+		  newpt = *curpt;
+		  newpt.idx = OGRID_WEST(newpt.idx, newpt.x);
+		  newpt.x--;
+		  if (eval_pt(curpt, &newpt, PR_PRED_E, stage))
+		     push_point(frontier, newpt.x, newpt.y, newpt.lay, astar);
+	       }
+	    }
+	    break;
+
+	 case SOUTH:
+	    if (((curpt->y - 1) >= 0) && ((curpt->y - 1) >= RouteArea.y1)) {
+	       if (jump && (o != 1) && jump_pt(curpt, PR_PRED_N, mask, &jumpt))
+		  push_point(frontier, jumpt.x, jumpt.y, jumpt.lay, astar);
+	       else {
+		  newpt = *curpt;
+		  newpt.idx = OGRID_SOUTH(newpt.idx, newpt.y);
+		  newpt.y--;
+		  if (eval_pt(curpt, &newpt, PR_PRED_N, stage))
+		     push_point(frontier, newpt.x, newpt.y, newpt.lay, astar);
+	       }
+	    }
+	    break;
+
+	 case NORTH:
+	    if (((curpt->y + 1) < NumChannelsY[curpt->lay]) &&
+		     ((curpt->y + 1) <= RouteArea.y2)) {
+	       if (jump && (o != 1) && jump_pt(curpt, PR_PRED_S, mask, &jumpt))
+		  push_point(frontier, jumpt.x, jumpt.y, jumpt.lay, astar);
+	       else {
+		  newpt = *curpt;
+		  newpt.idx = OGRID_NORTH(newpt.idx, newpt.y);
+		  newpt.y++;
+		  if (eval_pt(curpt, &newpt, PR_PRED_S, stage))
+		     push_point(frontier, newpt.x, newpt.y, newpt.lay, astar);
+	       }
+	    }
+	    break;
+
+	 case DOWN:
+	    if (curpt->lay > 0) {
+	       newpt = *curpt;
+	       newpt.lay--;
+	       if (eval_pt(curpt, &newpt, PR_PRED_U, stage))
+		  push_point(frontier, newpt.x, newpt.y, newpt.lay, astar);
+	    }
+	    break;
+
+	 case UP:
+	    if (curpt->lay < (Num_layers - 1)) {
+	       newpt = *curpt;
+	       newpt.lay++;
+	       if (eval_pt(curpt, &newpt, PR_PRED_D, stage))
+		  push_point(frontier, newpt.x, newpt.y, newpt.lay, astar);
+	    }
+	    break;
+      }
+   }
+}
+
+void expand_pt_stage0(GRIDP *curpt, PQUEUE *frontier, u_char *mask,
+		u_char jump, u_char astar)
+{
+   expand_pt(curpt, frontier, mask, jump, astar, 0);
+}
+
+void expand_pt_stage1(GRIDP *curpt, PQUEUE *frontier, u_char *mask,
+		u_char jump, u_char astar)
+{
+   expand_pt(curpt, frontier, mask, jump, astar, 1);
+}
+
 /*------------------------------------------------------*/
 /* writeback_segment() ---				*/
 /*							*/
@@ -809,21 +1777,22 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
    POINT newlr, newlr2, lrtop, lrend, lrnext, lrcur, lrprev;
    double sreq;
 
-   fflush(stdout);
-   fprintf(stderr, "\nCommit: TotalRoutes = %d\n", TotalRoutes);
+   fflush(RTOUT);
+   fprintf(RTERR, "\nCommit: TotalRoutes = %d\n",
+		__sync_fetch_and_add(&TotalRoutes, 0));
 
    netnum = rt->netnum;
 
-   Pr = &Obs2[ept->lay][OGRID(ept->x, ept->y, ept->lay)];
+   Pr = OBS2(ept->x, ept->y, ept->lay);
    if (!(Pr->flags & PR_COST)) {
-      fprintf(stderr, "commit_proute(): impossible - terminal is not routable!\n");
+      fprintf(RTERR, "commit_proute(): impossible - terminal is not routable!\n");
       return -1;
    }
 
    // Generate an indexed route, recording the series of predecessors and their
    // positions.
 
-   lrtop = (POINT)malloc(sizeof(struct point_));
+   lrtop = alloc_point();
    lrtop->x1 = ept->x;
    lrtop->y1 = ept->y;
    lrtop->layer = ept->lay;
@@ -832,11 +1801,11 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 
    while (1) {
 
-      Pr = &Obs2[lrend->layer][OGRID(lrend->x1, lrend->y1, lrend->layer)];
+      Pr = OBS2(lrend->x1, lrend->y1, lrend->layer);
       dmask = Pr->flags & PR_PRED_DMASK;
       if (dmask == PR_PRED_NONE) break;
 
-      newlr = (POINT)malloc(sizeof(struct point_));
+      newlr = alloc_point();
       newlr->x1 = lrend->x1;
       newlr->y1 = lrend->y1;
       newlr->layer = lrend->layer;
@@ -911,132 +1880,140 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 	       // lowest cost, and make sure the position below that
 	       // is available.
 	       dx = cx + 1;	// Check to the right
-	       pri = &Obs2[cl][OGRID(dx, cy, cl)];
-	       pflags = pri->flags;
-	       cost = pri->prdata.cost;
-	       if (collide && !(pflags & (PR_COST | PR_SOURCE)) &&
-			(pri->prdata.net < Numnets)) {
-		  pflags = 0;
-		  cost = ConflictCost;
-	       }
-	       if (pflags & PR_COST) {
-		  pflags &= ~PR_COST;
-		  if ((pflags & PR_PRED_DMASK) != PR_PRED_NONE && cost < mincost) {
-	             pri2 = &Obs2[dl][OGRID(dx, cy, dl)];
-		     p2flags = pri2->flags;
-		     if (p2flags & PR_COST) {
-			p2flags &= ~PR_COST;
-		        if ((p2flags & PR_PRED_DMASK) != PR_PRED_NONE &&
-				pri2->prdata.cost < MAXRT) {
-		           mincost = cost;
-		           minx = dx;
-		           miny = cy;
+	       if (dx < NumChannelsX[cl]) {
+		  pri = OBS2(dx, cy, cl);
+		  pflags = pri->flags;
+		  cost = pri->prdata;
+		  if (collide && !(pflags & (PR_COST | PR_SOURCE)) &&
+			   (pri->prdata < Numnets)) {
+		     pflags = 0;
+		     cost = ConflictCost;
+		  }
+		  if (pflags & PR_COST) {
+		     pflags &= ~PR_COST;
+		     if ((pflags & PR_PRED_DMASK) != PR_PRED_NONE && cost < mincost) {
+			pri2 = OBS2(dx, cy, dl);
+			p2flags = pri2->flags;
+			if (p2flags & PR_COST) {
+			   p2flags &= ~PR_COST;
+			   if ((p2flags & PR_PRED_DMASK) != PR_PRED_NONE &&
+				   pri2->prdata < MAXRT) {
+			      mincost = cost;
+			      minx = dx;
+			      miny = cy;
+			   }
+			}
+			else if (collide && !(p2flags & (PR_COST | PR_SOURCE)) &&
+				   (pri2->prdata < Numnets) &&
+				   ((cost + ConflictCost) < mincost)) {
+			   mincost = cost + ConflictCost;
+			   minx = dx;
+			   miny = dy;
 			}
-		     }
-		     else if (collide && !(p2flags & (PR_COST | PR_SOURCE)) &&
-				(pri2->prdata.net < Numnets) &&
-				((cost + ConflictCost) < mincost)) {
-			mincost = cost + ConflictCost;
-			minx = dx;
-			miny = dy;
 		     }
 		  }
 	       }
 	       dx = cx - 1;	// Check to the left
-	       pri = &Obs2[cl][OGRID(dx, cy, cl)];
-	       pflags = pri->flags;
-	       cost = pri->prdata.cost;
-	       if (collide && !(pflags & (PR_COST | PR_SOURCE)) &&
-			(pri->prdata.net < Numnets)) {
-		  pflags = 0;
-		  cost = ConflictCost;
-	       }
-	       if (pflags & PR_COST) {
-		  pflags &= ~PR_COST;
-		  if ((pflags & PR_PRED_DMASK) != PR_PRED_NONE && cost < mincost) {
-	             pri2 = &Obs2[dl][OGRID(dx, cy, dl)];
-		     p2flags = pri2->flags;
-		     if (p2flags & PR_COST) {
-			p2flags &= ~PR_COST;
-		        if ((p2flags & PR_PRED_DMASK) != PR_PRED_NONE &&
-				pri2->prdata.cost < MAXRT) {
-		           mincost = cost;
-		           minx = dx;
-		           miny = cy;
+	       if (dx >= 0) {
+		  pri = OBS2(dx, cy, cl);
+		  pflags = pri->flags;
+		  cost = pri->prdata;
+		  if (collide && !(pflags & (PR_COST | PR_SOURCE)) &&
+			   (pri->prdata < Numnets)) {
+		     pflags = 0;
+		     cost = ConflictCost;
+		  }
+		  if (pflags & PR_COST) {
+		     pflags &= ~PR_COST;
+		     if ((pflags & PR_PRED_DMASK) != PR_PRED_NONE && cost < mincost) {
+			pri2 = OBS2(dx, cy, dl);
+			p2flags = pri2->flags;
+			if (p2flags & PR_COST) {
+			   p2flags &= ~PR_COST;
+			   if ((p2flags & PR_PRED_DMASK) != PR_PRED_NONE &&
+				   pri2->prdata < MAXRT) {
+			      mincost = cost;
+			      minx = dx;
+			      miny = cy;
+			   }
+			}
+			else if (collide && !(p2flags & (PR_COST | PR_SOURCE)) &&
+				   (pri2->prdata < Numnets) &&
+				   ((cost + ConflictCost) < mincost)) {
+			   mincost = cost + ConflictCost;
+			   minx = dx;
+			   miny = dy;
 			}
-		     }
-		     else if (collide && !(p2flags & (PR_COST | PR_SOURCE)) &&
-				(pri2->prdata.net < Numnets) &&
-				((cost + ConflictCost) < mincost)) {
-			mincost = cost + ConflictCost;
-			minx = dx;
-			miny = dy;
 		     }
 		  }
 	       }
 
 	       dy = cy + 1;	// Check north
-	       pri = &Obs2[cl][OGRID(cx, dy, cl)];
-	       pflags = pri->flags;
-	       cost = pri->prdata.cost;
-	       if (collide && !(pflags & (PR_COST | PR_SOURCE)) &&
-			(pri->prdata.net < Numnets)) {
-		  pflags = 0;
-		  cost = ConflictCost;
-	       }
-	       if (pflags & PR_COST) {
-		  pflags &= ~PR_COST;
-		  if ((pflags & PR_PRED_DMASK) != PR_PRED_NONE && cost < mincost) {
-	             pri2 = &Obs2[dl][OGRID(cx, dy, dl)];
-		     p2flags = pri2->flags;
-		     if (p2flags & PR_COST) {
-			p2flags &= ~PR_COST;
-		        if ((p2flags & PR_PRED_DMASK) != PR_PRED_NONE &&
-				pri2->prdata.cost < MAXRT) {
-		           mincost = cost;
-		           minx = cx;
-		           miny = dy;
+	       if (dy < NumChannelsY[cl]) {
+		  pri = OBS2(cx, dy, cl);
+		  pflags = pri->flags;
+		  cost = pri->prdata;
+		  if (collide && !(pflags & (PR_COST | PR_SOURCE)) &&
+			   (pri->prdata < Numnets)) {
+		     pflags = 0;
+		     cost = ConflictCost;
+		  }
+		  if (pflags & PR_COST) {
+		     pflags &= ~PR_COST;
+		     if ((pflags & PR_PRED_DMASK) != PR_PRED_NONE && cost < mincost) {
+			pri2 = OBS2(cx, dy, dl);
+			p2flags = pri2->flags;
+			if (p2flags & PR_COST) {
+			   p2flags &= ~PR_COST;
+			   if ((p2flags & PR_PRED_DMASK) != PR_PRED_NONE &&
+				   pri2->prdata < MAXRT) {
+			      mincost = cost;
+			      minx = cx;
+			      miny = dy;
+			   }
+			}
+			else if (collide && !(p2flags & (PR_COST | PR_SOURCE)) &&
+				   (pri2->prdata < Numnets) &&
+				   ((cost + ConflictCost) < mincost)) {
+			   mincost = cost + ConflictCost;
+			   minx = dx;
+			   miny = dy;
 			}
-		     }
-		     else if (collide && !(p2flags & (PR_COST | PR_SOURCE)) &&
-				(pri2->prdata.net < Numnets) &&
-				((cost + ConflictCost) < mincost)) {
-			mincost = cost + ConflictCost;
-			minx = dx;
-			miny = dy;
 		     }
 		  }
 	       }
 
 	       dy = cy - 1;	// Check south
-	       pri = &Obs2[cl][OGRID(cx, dy, cl)];
-	       pflags = pri->flags;
-	       cost = pri->prdata.cost;
-	       if (collide && !(pflags & (PR_COST | PR_SOURCE)) &&
-			(pri->prdata.net < Numnets)) {
-		  pflags = 0;
-		  cost = ConflictCost;
-	       }
-	       if (pflags & PR_COST) {
-		  pflags &= ~PR_COST;
-		  if (pflags & PR_PRED_DMASK != PR_PRED_NONE && cost < mincost) {
-	             pri2 = &Obs2[dl][OGRID(cx, dy, dl)];
-		     p2flags = pri2->flags;
-		     if (p2flags & PR_COST) {
-		        p2flags &= ~PR_COST;
-		        if ((p2flags & PR_PRED_DMASK) != PR_PRED_NONE &&
-				pri2->prdata.cost < MAXRT) {
-		           mincost = cost;
-		           minx = cx;
-		           miny = dy;
+	       if (dy >= 0) {
+		  pri = OBS2(cx, dy, cl);
+		  pflags = pri->flags;
+		  cost = pri->prdata;
+		  if (collide && !(pflags & (PR_COST | PR_SOURCE)) &&
+			   (pri->prdata < Numnets)) {
+		     pflags = 0;
+		     cost = ConflictCost;
+		  }
+		  if (pflags & PR_COST) {
+		     pflags &= ~PR_COST;
+		     if (pflags & PR_PRED_DMASK != PR_PRED_NONE && cost < mincost) {
+			pri2 = OBS2(cx, dy, dl);
+			p2flags = pri2->flags;
+			if (p2flags & PR_COST) {
+			   p2flags &= ~PR_COST;
+			   if ((p2flags & PR_PRED_DMASK) != PR_PRED_NONE &&
+				   pri2->prdata < MAXRT) {
+			      mincost = cost;
+			      minx = cx;
+			      miny = dy;
+			   }
+			}
+			else if (collide && !(p2flags & (PR_COST | PR_SOURCE)) &&
+				   (pri2->prdata < Numnets) &&
+				   ((cost + ConflictCost) < mincost)) {
+			   mincost = cost + ConflictCost;
+			   minx = dx;
+			   miny = dy;
 			}
-		     }
-		     else if (collide && !(p2flags & (PR_COST | PR_SOURCE)) &&
-				(pri2->prdata.net < Numnets) &&
-				((cost + ConflictCost) < mincost)) {
-			mincost = cost + ConflictCost;
-			minx = dx;
-			miny = dy;
 		     }
 		  }
 	       }
@@ -1046,16 +2023,16 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 	       // then try to move the first contact instead.
 
 	       if (mincost < MAXRT) {
-	          pri = &Obs2[cl][OGRID(minx, miny, cl)];
+	          pri = OBS2(minx, miny, cl);
 
-		  newlr = (POINT)malloc(sizeof(struct point_));
+		  newlr = alloc_point();
 		  newlr->x1 = minx;
 		  newlr->y1 = miny;
 		  newlr->layer = cl;
 
-	          pri2 = &Obs2[dl][OGRID(minx, miny, dl)];
+	          pri2 = OBS2(minx, miny, dl);
 
-		  newlr2 = (POINT)malloc(sizeof(struct point_));
+		  newlr2 = alloc_point();
 		  newlr2->x1 = minx;
 		  newlr2->y1 = miny;
 		  newlr2->layer = dl;
@@ -1070,8 +2047,8 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 		     if (lrnext->x1 == minx && lrnext->y1 == miny &&
 				lrnext->layer == dl) {
 			newlr->next = lrnext;
-			free(lrppre);
-			free(newlr2);
+			free_point(lrppre);
+			free_point(newlr2);
 			lrppre = lrnext;	// ?
 		     }
 		     else
@@ -1094,96 +2071,104 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 	          dl = lrprev->layer;
 
 	          dx = cx + 1;	// Check to the right
-	          pri = &Obs2[cl][OGRID(dx, cy, cl)];
-	          pflags = pri->flags;
-		  if (pflags & PR_COST) {
-		     pflags &= ~PR_COST;
-		     if ((pflags & PR_PRED_DMASK) != PR_PRED_NONE &&
-				pri->prdata.cost < mincost) {
-	                pri2 = &Obs2[dl][OGRID(dx, cy, dl)];
-		        p2flags = pri2->flags;
-			if (p2flags & PR_COST) {
-			   p2flags &= ~PR_COST;
-		           if ((p2flags & PR_PRED_DMASK) != PR_PRED_NONE &&
-					pri2->prdata.cost < MAXRT) {
-		              mincost = pri->prdata.cost;
-		              minx = dx;
-		              miny = cy;
+		  if (dx < NumChannelsX[cl]) {
+		     pri = OBS2(dx, cy, cl);
+		     pflags = pri->flags;
+		     if (pflags & PR_COST) {
+			pflags &= ~PR_COST;
+			if ((pflags & PR_PRED_DMASK) != PR_PRED_NONE &&
+				   pri->prdata < mincost) {
+			   pri2 = OBS2(dx, cy, dl);
+			   p2flags = pri2->flags;
+			   if (p2flags & PR_COST) {
+			      p2flags &= ~PR_COST;
+			      if ((p2flags & PR_PRED_DMASK) != PR_PRED_NONE &&
+					   pri2->prdata < MAXRT) {
+				 mincost = pri->prdata;
+				 minx = dx;
+				 miny = cy;
+			      }
 			   }
-		        }
+			}
 		     }
-	          }
+		  }
 
 	          dx = cx - 1;	// Check to the left
-	          pri = &Obs2[cl][OGRID(dx, cy, cl)];
-	          pflags = pri->flags;
-		  if (pflags & PR_COST) {
-		     pflags &= ~PR_COST;
-		     if ((pflags & PR_PRED_DMASK) != PR_PRED_NONE &&
-				pri->prdata.cost < mincost) {
-	                pri2 = &Obs2[dl][OGRID(dx, cy, dl)];
-		        p2flags = pri2->flags;
-			if (p2flags & PR_COST) {
-			   p2flags &= ~PR_COST;
-		           if ((p2flags & PR_PRED_DMASK) != PR_PRED_NONE &&
-					pri2->prdata.cost < MAXRT) {
-		              mincost = pri->prdata.cost;
-		              minx = dx;
-		              miny = cy;
+		  if (dx >= 0) {
+		     pri = OBS2(dx, cy, cl);
+		     pflags = pri->flags;
+		     if (pflags & PR_COST) {
+			pflags &= ~PR_COST;
+			if ((pflags & PR_PRED_DMASK) != PR_PRED_NONE &&
+				   pri->prdata < mincost) {
+			   pri2 = OBS2(dx, cy, dl);
+			   p2flags = pri2->flags;
+			   if (p2flags & PR_COST) {
+			      p2flags &= ~PR_COST;
+			      if ((p2flags & PR_PRED_DMASK) != PR_PRED_NONE &&
+					   pri2->prdata < MAXRT) {
+				 mincost = pri->prdata;
+				 minx = dx;
+				 miny = cy;
+			      }
 			   }
-		        }
+			}
 		     }
-	          }
+		  }
 
 	          dy = cy + 1;	// Check north
-	          pri = &Obs2[cl][OGRID(cx, dy, cl)];
-	          pflags = pri->flags;
-		  if (pflags & PR_COST) {
-		     pflags &= ~PR_COST;
-		     if ((pflags & PR_PRED_DMASK) != PR_PRED_NONE &&
-				pri->prdata.cost < mincost) {
-	                pri2 = &Obs2[dl][OGRID(cx, dy, dl)];
-		        p2flags = pri2->flags;
-			if (p2flags & PR_COST) {
-			   p2flags &= ~PR_COST;
-		           if ((p2flags & PR_PRED_DMASK) != PR_PRED_NONE &&
-					pri2->prdata.cost < MAXRT) {
-		              mincost = pri->prdata.cost;
-		              minx = cx;
-		              miny = dy;
+		  if (dy < NumChannelsY[cl]) {
+		     pri = OBS2(cx, dy, cl);
+		     pflags = pri->flags;
+		     if (pflags & PR_COST) {
+			pflags &= ~PR_COST;
+			if ((pflags & PR_PRED_DMASK) != PR_PRED_NONE &&
+				   pri->prdata < mincost) {
+			   pri2 = OBS2(cx, dy, dl);
+			   p2flags = pri2->flags;
+			   if (p2flags & PR_COST) {
+			      p2flags &= ~PR_COST;
+			      if ((p2flags & PR_PRED_DMASK) != PR_PRED_NONE &&
+					   pri2->prdata < MAXRT) {
+				 mincost = pri->prdata;
+				 minx = cx;
+				 miny = dy;
+			      }
 			   }
-		        }
+			}
 		     }
-	          }
+		  }
 
 	          dy = cy - 1;	// Check south
-	          pri = &Obs2[cl][OGRID(cx, dy, cl)];
-	          pflags = pri->flags;
-		  if (pflags & PR_COST) {
-		     pflags &= ~PR_COST;
-		     if ((pflags & PR_PRED_DMASK) != PR_PRED_NONE &&
-				pri->prdata.cost < mincost) {
-	                pri2 = &Obs2[dl][OGRID(cx, dy, dl)];
-		        p2flags = pri2->flags;
-			if (p2flags & PR_COST) {
-			   p2flags &= ~PR_COST;
-		           if ((p2flags & PR_PRED_DMASK) != PR_PRED_NONE &&
-					pri2->prdata.cost < MAXRT) {
-		              mincost = pri->prdata.cost;
-		              minx = cx;
-		              miny = dy;
+		  if (dy >= 0) {
+		     pri = OBS2(cx, dy, cl);
+		     pflags = pri->flags;
+		     if (pflags & PR_COST) {
+			pflags &= ~PR_COST;
+			if ((pflags & PR_PRED_DMASK) != PR_PRED_NONE &&
+				   pri->prdata < mincost) {
+			   pri2 = OBS2(cx, dy, dl);
+			   p2flags = pri2->flags;
+			   if (p2flags & PR_COST) {
+			      p2flags &= ~PR_COST;
+			      if ((p2flags & PR_PRED_DMASK) != PR_PRED_NONE &&
+					   pri2->prdata < MAXRT) {
+				 mincost = pri->prdata;
+				 minx = cx;
+				 miny = dy;
+			      }
 			   }
-		        }
+			}
 		     }
-	          }
+		  }
 
 		  if (mincost < MAXRT) {
-		     newlr = (POINT)malloc(sizeof(struct point_));
+		     newlr = alloc_point();
 		     newlr->x1 = minx;
 		     newlr->y1 = miny;
 		     newlr->layer = cl;
 
-		     newlr2 = (POINT)malloc(sizeof(struct point_));
+		     newlr2 = alloc_point();
 		     newlr2->x1 = minx;
 		     newlr2->y1 = miny;
 		     newlr2->layer = dl;
@@ -1193,15 +2178,14 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 		     // endpoint along the source or target, and the
 		     // original endpoint position is not needed.
 
-	             pri = &Obs2[cl][OGRID(minx, miny, cl)];
-	             pri2 = &Obs2[lrcur->layer][OGRID(lrcur->x1,
-					lrcur->y1, lrcur->layer)];
+	             pri = OBS2(minx, miny, cl);
+	             pri2 = OBS2(lrcur->x1, lrcur->y1, lrcur->layer);
 		     if (((pri->flags & PR_SOURCE) && (pri2->flags & PR_SOURCE)) ||
 			 	((pri->flags & PR_TARGET) &&
 				(pri2->flags & PR_TARGET)) && (lrcur == lrtop)) {
 			lrtop = newlr;
 			lrend = newlr;
-			free(lrcur);
+			free_point(lrcur);
 			lrcur = newlr;
 		     }
 		     else
@@ -1215,8 +2199,8 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 		     if (lrppre->x1 == minx && lrppre->y1 == miny &&
 				lrppre->layer == dl) {
 			newlr->next = lrppre;
-			free(lrprev);
-			free(newlr2);
+			free_point(lrprev);
+			free_point(newlr2);
 			lrprev = lrcur;
 		     }
 		     else
@@ -1230,7 +2214,7 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 		     // but it works because failing to remove a stacked
 		     // via is a rare occurrance.
 
-		     printf("Failed to remove stacked via at grid point "
+		     fprintf(RTOUT, "Failed to remove stacked via at grid point "
 				"%d %d.\n", lrcur->x1, lrcur->y1);
 		     stacks = 0;
 		     rval = 0;
@@ -1238,7 +2222,7 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 		  }
 		  else {
 		     if (collide == TRUE) {
-		        printf("Failed to remove stacked via at grid point "
+		        fprintf(RTOUT, "Failed to remove stacked via at grid point "
 				"%d %d;  position may not be routable.\n",
 				lrcur->x1, lrcur->y1);
 			stacks = 0;
@@ -1311,17 +2295,17 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
       }
 
       if (Verbose > 0) {
-         printf( "commit: index = %d, net = %d\n",
-		Pr->prdata.net, netnum);
+         fprintf(RTOUT, "commit: index = %d, net = %d\n",
+		Pr->prdata, netnum);
 
 	 if (seg->segtype == ST_WIRE) {
-            printf( "commit: wire layer %d, (%d,%d) to (%d,%d)\n",
+            fprintf(RTOUT, "commit: wire layer %d, (%d,%d) to (%d,%d)\n",
 		seg->layer, seg->x1, seg->y1, seg->x2, seg->y2);
 	 }
 	 else {
-            printf( "commit: via %d to %d\n", seg->layer, seg->layer + 1);
+            fprintf(RTOUT, "commit: via %d to %d\n", seg->layer, seg->layer + 1);
 	 }
-	 fflush(stdout);
+	 fflush(RTOUT);
       }
 
       // now fill in the Obs structure with this route....
@@ -1420,7 +2404,7 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 	 // Clean up allocated memory for the route. . .
 	 while (lrtop != NULL) {
 	    lrnext = lrtop->next;
-	    free(lrtop);
+	    free_point(lrtop);
 	    lrtop = lrnext;
 	 }
 	 return rval;	// Success
@@ -1432,7 +2416,7 @@ cleanup:
 
    while (lrtop != NULL) {
       lrnext = lrtop->next;
-      free(lrtop);
+      free_point(lrtop);
       lrtop = lrnext;
    }
    return 0;
@@ -7,12 +7,34 @@
 
 #ifndef MAZE_H
 
+void	reset_obs2(int netnum);
+void	clear_obs2_stamps();
+PROUTE *init_proute(int idx, int lay);
 void	set_powerbus_to_net(int netnum);
 int     set_node_to_net(NODE node, int newnet, POINT *pushlist, SEG bbox, u_char stage);
 int	disable_node_nets(NODE node);
 int     set_routes_to_net(NET net, int newnet, POINT *pushlist, SEG bbox, u_char stage);
+void	set_route_to_source(NET net, ROUTE rt, POINT *pushlist);
+u_char	node_is_target(NODE node);
 u_char  ripup_net(NET net, u_char restore);
-int     eval_pt(GRIDP *ept, u_char flags, u_char stage);
+int	jump_pt(GRIDP *ept, u_char flags, u_char *mask, GRIDP *end);
+void	set_step_costs();
+int	step_cost(GRIDP *ept, GRIDP *newpt);
+void	expand_pt_stage0(GRIDP *curpt, PQUEUE *frontier, u_char *mask,
+		u_char jump, u_char astar);
+void	expand_pt_stage1(GRIDP *curpt, PQUEUE *frontier, u_char *mask,
+		u_char jump, u_char astar);
+void	reset_points();
+POINT	alloc_point();
+void	free_point(POINT gpoint);
+void	pqueue_init(PQUEUE *pq);
+void	pqueue_free(PQUEUE *pq);
+void	pqueue_push(PQUEUE *pq, int x, int y, int lay, u_int cost);
+POINT	pqueue_pop(PQUEUE *pq, u_int maxcost, u_int *cost);
+int	astar_set_targets(NET net);
+u_int	astar_cost(int x, int y, int lay);
+void	push_point(PQUEUE *pq, int x, int y, int lay, u_char astar);
+void	pqueue_reseed(PQUEUE *pq, POINT *list, u_char astar);
 int     commit_proute(ROUTE rt, GRIDP *ept, u_char stage);
 void	writeback_segment(SEG seg, int netnum);
 int     writeback_route(ROUTE rt);
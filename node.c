@@ -17,55 +17,55 @@
 #include "node.h"
 #include "config.h"
 #include "lef.h"
+#include "grid.h"
+#include "hash.h"
+
+/* Nets of Nlnets by name (see find_net()), matched with case */
+static HASHTABLE NetTable = {NULL, 0, 0, TRUE};
 
 /*--------------------------------------------------------------*/
-/* create_netorder --- assign indexes to net->netorder    	*/
-/*								*/
-/* 	Nets are ordered simply from those with the most nodes	*/
-/*	to those with the fewest.  However, any nets marked	*/
-/* 	critical in the configuration or critical net files	*/
-/*	will be given precedence.				*/
+/* create_nettab --- index the nets by net number and by	*/
+/*	name, so that routing need not search Nlnets.  Where	*/
+/*	nets share a number or a name, the first one on Nlnets	*/
+/*	is the one indexed, as a search of the list would	*/
+/*	find.  Must be called after the nets are read.		*/
 /*								*/
 /*  ARGS: none							*/
 /*  RETURNS: nothing						*/
-/*  SIDE EFFECTS: Nlnets -> netorder is assigned		*/
+/*  SIDE EFFECTS: Nettab and the name table are allocated	*/
+/*	and filled						*/
 /*--------------------------------------------------------------*/
 
-void create_netorder()
+void create_nettab()
 {
-  int i, max;
-  NET  net;
-  STRING cn;
-
-  i = 1;
-  for (cn = CriticalNet; cn; cn = cn->next) {
-     fprintf(stdout, "critical net %s\n", cn->name);
-     for (net = Nlnets; net; net = net->next) {
-	if (!strcmp(net->netname, (char *)cn->name)) {
-           net->netorder = i++;
-	}
-     }
-  }
+  NET net;
 
-  for (; i <= Numnets; i++) {
-     max = 0;
+  Nettab = (NET *)calloc(Numnets + 1, sizeof(NET));
 
-     for (net = Nlnets; net; net = net->next) {
-	if (!net->netorder) {
-	   if (net->numnodes > max) max = net->numnodes;
-	}
-     }
-
-     for (net = Nlnets; net; net = net->next) {
-	if (!net->netorder) {
-	   if (net->numnodes == max) {
-	      net->netorder = i;
-	      break;
-	   }
-        }
-     }
+  for (net = Nlnets; net; net = net->next) {
+     if ((net->netnum >= 0) && (net->netnum <= Numnets) &&
+		(Nettab[net->netnum] == NULL))
+	Nettab[net->netnum] = net;
   }
-} /* create_netorder() */
+
+  HashKill(&NetTable);
+  for (net = Nlnets; net; net = net->next)
+     if (HashLookup(net->netname, &NetTable) == NULL)
+	HashInstall(net->netname, net, &NetTable);
+} /* create_nettab() */
+
+/*--------------------------------------------------------------*/
+/* find_net --- find the net named "netname"			*/
+/*								*/
+/*  ARGS: net name						*/
+/*  RETURNS: the net, or NULL if there is none by that name	*/
+/*  SIDE EFFECTS: none						*/
+/*--------------------------------------------------------------*/
+
+NET find_net(char *netname)
+{
+  return (NET)HashLookup(netname, &NetTable);
+} /* find_net() */
 
 /*--------------------------------------------------------------*/
 /* print_nodes - show the nodes list				*/
@@ -218,9 +218,77 @@ disable_gridpos(int x, int y, int lay)
    int apos = OGRID(x, y, lay);
 
    Obs[lay][apos] = (u_int)(NO_NET | OBSTRUCT_MASK);
-   Nodeloc[lay][apos] = NULL;
-   Nodesav[lay][apos] = NULL;
-   Stub[lay][apos] = 0.0;
+   set_nodeloc(x, y, lay, (NODE)NULL);
+   sgrid_set(&Stub, x, y, lay, 0.0);
+}
+
+/*--------------------------------------------------------------*/
+/* create_nodetab() ---						*/
+/*	Number all nodes of nets and gates, and fill in the	*/
+/*	table Nodetab[] of nodes by number.  The number is what	*/
+/*	is stored in the Nodeid[] grid.  Number 0 (no node) is	*/
+/*	left NULL.  Must be called before set_nodeloc().	*/
+/*--------------------------------------------------------------*/
+
+void
+create_nodetab()
+{
+   NET net;
+   NODE node;
+   GATE g;
+   int i, numnodes;
+
+   // Count the nodes.  Gates may hold nodes that are on no net
+   // (e.g., power and ground), so look at those as well.
+
+   numnodes = 1;
+   for (net = Nlnets; net; net = net->next)
+      for (node = net->netnodes; node; node = node->next)
+	 numnodes++;
+   for (g = Nlgates; g; g = g->next)
+      for (i = 0; i < g->nodes; i++)
+	 if (g->netnum[i] != 0)
+	    numnodes++;
+
+   Nodetab = (NODE *)malloc(numnodes * sizeof(NODE));
+   Nodetab[0] = (NODE)NULL;
+   numnodes = 1;
+
+   for (net = Nlnets; net; net = net->next)
+      for (node = net->netnodes; node; node = node->next) {
+	 node->gridid = numnodes;
+	 Nodetab[numnodes++] = node;
+      }
+   for (g = Nlgates; g; g = g->next)
+      for (i = 0; i < g->nodes; i++) {
+	 if (g->netnum[i] == 0) continue;	// pin not connected
+	 node = g->noderec[i];
+	 if (node->gridid == 0) {
+	    node->gridid = numnodes;
+	    Nodetab[numnodes++] = node;
+	 }
+      }
+}
+
+/*--------------------------------------------------------------*/
+/* set_nodeloc() ---						*/
+/*	Attach node to position (x, y, lay), or detach any	*/
+/*	node if node is NULL, in both Nodeloc and Nodesav.	*/
+/*	The positions above and below are flagged in Crossing	*/
+/*	(and left flagged if the node is detached).		*/
+/*--------------------------------------------------------------*/
+
+void
+set_nodeloc(int x, int y, int lay, NODE node)
+{
+   Nodeid[lay][OGRID(x, y, lay)] = (node == NULL) ? 0 : node->gridid;
+
+   if (node != NULL) {
+      if (lay > 0)
+	 Crossing[lay - 1][OGRID(x, y, lay - 1)] |= CROSS_ABOVE;
+      if (lay < Num_layers - 1)
+	 Crossing[lay + 1][OGRID(x, y, lay + 1)] |= CROSS_BELOW;
+   }
 }
 
 /*--------------------------------------------------------------*/
@@ -240,7 +308,7 @@ check_obstruct(int gridx, int gridy, DSEG ds, double dx, double dy)
     float dist;
 
     obsptr = &(Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]);
-    dist = Obsinfo[ds->layer][OGRID(gridx, gridy, ds->layer)];
+    dist = OBSINFO(gridx, gridy, ds->layer);
 
     // Grid point is inside obstruction + halo.
     *obsptr |= NO_NET;
@@ -256,7 +324,7 @@ check_obstruct(int gridx, int gridy, DSEG ds, double dx, double dy)
        if (dy < ds->y1) {
 	  if ((*obsptr & (OBSTRUCT_MASK & ~OBSTRUCT_N)) == 0) {
 	     if ((dist == 0) || ((ds->y1 - dy) < dist))
-		Obsinfo[ds->layer][OGRID(gridx, gridy, ds->layer)] = ds->y1 - dy;
+		sgrid_set(&Obsinfo, gridx, gridy, ds->layer, ds->y1 - dy);
 	     *obsptr |= OBSTRUCT_N;
 	  }
 	  else *obsptr |= OBSTRUCT_MASK;
@@ -264,7 +332,7 @@ check_obstruct(int gridx, int gridy, DSEG ds, double dx, double dy)
        else if (dy > ds->y2) {
 	  if ((*obsptr & (OBSTRUCT_MASK & ~OBSTRUCT_S)) == 0) {
 	     if ((dist == 0) || ((dy - ds->y2) < dist))
-		Obsinfo[ds->layer][OGRID(gridx, gridy, ds->layer)] = dy - ds->y2;
+		sgrid_set(&Obsinfo, gridx, gridy, ds->layer, dy - ds->y2);
 	     *obsptr |= OBSTRUCT_S;
 	  }
 	  else *obsptr |= OBSTRUCT_MASK;
@@ -272,7 +340,7 @@ check_obstruct(int gridx, int gridy, DSEG ds, double dx, double dy)
        if (dx < ds->x1) {
 	  if ((*obsptr & (OBSTRUCT_MASK & ~OBSTRUCT_E)) == 0) {
 	     if ((dist == 0) || ((ds->x1 - dx) < dist))
-		Obsinfo[ds->layer][OGRID(gridx, gridy, ds->layer)] = ds->x1 - dx;
+		sgrid_set(&Obsinfo, gridx, gridy, ds->layer, ds->x1 - dx);
              *obsptr |= OBSTRUCT_E;
 	  }
 	  else *obsptr |= OBSTRUCT_MASK;
@@ -280,7 +348,7 @@ check_obstruct(int gridx, int gridy, DSEG ds, double dx, double dy)
        else if (dx > ds->x2) {
 	  if ((*obsptr & (OBSTRUCT_MASK & ~OBSTRUCT_W)) == 0) {
 	     if ((dist == 0) || ((dx - ds->x2) < dist))
-		Obsinfo[ds->layer][OGRID(gridx, gridy, ds->layer)] = dx - ds->x2;
+		sgrid_set(&Obsinfo, gridx, gridy, ds->layer, dx - ds->x2);
 	     *obsptr |= OBSTRUCT_W;
 	  }
 	  else *obsptr |= OBSTRUCT_MASK;
@@ -528,7 +596,7 @@ void create_obstructions_from_gates()
 /*  (net terminal), which may have multiple unconnected		*/
 /*  positions.							*/
 /*								*/
-/*  Also fills in the Nodeloc[] grid with the node number,	*/
+/*  Also fills in the Nodeloc grid with the node number,	*/
 /*  which causes the router to put a premium on			*/
 /*  routing other nets over or under this position, to		*/
 /*  discourage boxing in a pin position and making it 		*/
@@ -704,12 +772,9 @@ void create_obstructions_from_nodes()
 
 			        Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 					= (u_int)node->netnum | dir;
-			        Nodeloc[ds->layer][OGRID(gridx, gridy, ds->layer)]
-					= node;
-			        Nodesav[ds->layer][OGRID(gridx, gridy, ds->layer)]
-					= node;
-			        Stub[ds->layer][OGRID(gridx, gridy, ds->layer)]
-					= dist;
+			        set_nodeloc(gridx, gridy, ds->layer, node);
+			        sgrid_set(&Stub, gridx, gridy, ds->layer,
+					dist);
 
 			     }
 			     else if ((orignet & NO_NET) && ((orignet & OBSTRUCT_MASK)
@@ -737,52 +802,45 @@ void create_obstructions_from_nodes()
 				// obstruction to resolve the DRC error.
 
 				// Make sure we have marked this as a node.
-			        Nodeloc[ds->layer][OGRID(gridx, gridy, ds->layer)]
-					= node;
-			        Nodesav[ds->layer][OGRID(gridx, gridy, ds->layer)]
-					= node;
+			        set_nodeloc(gridx, gridy, ds->layer, node);
 			        Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 					= (u_int)node->netnum;
 
 				if (orignet & OBSTRUCT_N) {
-			           offd = -(sdisty - Obsinfo[ds->layer]
-					[OGRID(gridx, gridy, ds->layer)]);
+			           offd = -(sdisty - OBSINFO(gridx, gridy, ds->layer));
 				   if (offd >= -offmaxy[ds->layer]) {
-			              Stub[ds->layer][OGRID(gridx, gridy, ds->layer)]
-						= offd;
+			              sgrid_set(&Stub, gridx, gridy, ds->layer,
+						offd);
 			              Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 						|= (STUBROUTE_NS | OFFSET_TAP);
 				   }
 				   else maxerr = 1;
 				}
 				else if (orignet & OBSTRUCT_S) {
-				   offd = sdisty - Obsinfo[ds->layer]
-					[OGRID(gridx, gridy, ds->layer)];
+				   offd = sdisty - OBSINFO(gridx, gridy, ds->layer);
 				   if (offd <= offmaxy[ds->layer]) {
-			              Stub[ds->layer][OGRID(gridx, gridy, ds->layer)]
-						= offd;
+			              sgrid_set(&Stub, gridx, gridy, ds->layer,
+						offd);
 			              Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 						|= (STUBROUTE_NS | OFFSET_TAP);
 				   }
 				   else maxerr = 1;
 				}
 				else if (orignet & OBSTRUCT_E) {
-				   offd = -(sdistx - Obsinfo[ds->layer]
-					[OGRID(gridx, gridy, ds->layer)]);
+				   offd = -(sdistx - OBSINFO(gridx, gridy, ds->layer));
 				   if (offd >= -offmaxx[ds->layer]) {
-			              Stub[ds->layer][OGRID(gridx, gridy, ds->layer)]
-						= offd;
+			              sgrid_set(&Stub, gridx, gridy, ds->layer,
+						offd);
 			              Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 						|= (STUBROUTE_EW | OFFSET_TAP);
 				   }
 				   else maxerr = 1;
 				}
 				else if (orignet & OBSTRUCT_W) {
-				   offd = sdistx - Obsinfo[ds->layer]
-					[OGRID(gridx, gridy, ds->layer)];
+				   offd = sdistx - OBSINFO(gridx, gridy, ds->layer);
 				   if (offd <= offmaxx[ds->layer]) {
-			              Stub[ds->layer][OGRID(gridx, gridy, ds->layer)]
-						= offd;
+			              sgrid_set(&Stub, gridx, gridy, ds->layer,
+						offd);
 			              Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 						|= (STUBROUTE_EW | OFFSET_TAP);
 				   }
@@ -808,12 +866,10 @@ void create_obstructions_from_nodes()
 			           if ((k & ~PINOBSTRUCTMASK) != (u_int)node->netnum) {
 				       Obs[ds->layer + 1][OGRID(gridx, gridy,
 						ds->layer + 1)] = NO_NET;
-				       Nodeloc[ds->layer + 1][OGRID(gridx, gridy,
-						ds->layer + 1)] = (NODE)NULL;
-				       Nodesav[ds->layer + 1][OGRID(gridx, gridy,
-						ds->layer + 1)] = (NODE)NULL;
-				       Stub[ds->layer + 1][OGRID(gridx, gridy,
-						ds->layer + 1)] = (float)0.0;
+				       set_nodeloc(gridx, gridy, ds->layer + 1,
+						(NODE)NULL);
+				       sgrid_set(&Stub, gridx, gridy, ds->layer + 1,
+						(float)0.0);
 				   }
 				}
 			     }
@@ -866,10 +922,9 @@ void create_obstructions_from_nodes()
 
 			    n2 = NULL;
 			    if (ds->layer > 0)
-			       n2 = Nodeloc[ds->layer - 1][OGRID(gridx, gridy,
-					ds->layer - 1)];
+			       n2 = NODELOC(gridx, gridy, ds->layer - 1);
 			    if (n2 == NULL)
-			       n2 = Nodeloc[ds->layer][OGRID(gridx, gridy, ds->layer)];
+			       n2 = NODELOC(gridx, gridy, ds->layer);
 
 			    // Ignore my own node.
 			    if (n2 == node) n2 = NULL;
@@ -888,8 +943,7 @@ void create_obstructions_from_nodes()
 					(n2 == NULL)) {
 
 				if ((k & OBSTRUCT_MASK) != 0) {
-				   float sdist = Obsinfo[ds->layer][OGRID(gridx,
-						gridy, ds->layer)];
+				   float sdist = OBSINFO(gridx, gridy, ds->layer);
 
 				   // If the point is marked as close to an
 				   // obstruction, we can declare this an
@@ -1050,10 +1104,7 @@ void create_obstructions_from_nodes()
 				if ((k < Numnets) && (dir != STUBROUTE_X)) {
 				   Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 					= (u_int)g->netnum[i] | dir; 
-				   Nodeloc[ds->layer][OGRID(gridx, gridy, ds->layer)]
-					= node;
-				   Nodesav[ds->layer][OGRID(gridx, gridy, ds->layer)]
-					= node;
+				   set_nodeloc(gridx, gridy, ds->layer, node);
 				}
 				else {
 				   // Keep showing an obstruction, but add the
@@ -1061,8 +1112,8 @@ void create_obstructions_from_nodes()
 				   Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 					|= dir;
 				}
-				Stub[ds->layer][OGRID(gridx, gridy, ds->layer)]
-					= dist;
+				sgrid_set(&Stub, gridx, gridy, ds->layer,
+					dist);
 			    }
 			    else {
 			       int othernet = (k & ~PINOBSTRUCTMASK);
@@ -1090,20 +1141,18 @@ void create_obstructions_from_nodes()
 				  xdist = 0.5 * LefGetViaWidth(ds->layer, ds->layer, 0);
 				  if ((dy + xdist + LefGetRouteSpacing(ds->layer) >
 					ds->y1) && (dy + xdist < ds->y1)) {
-				     if (Stub[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] == 0.0) {
-					Stub[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] = ds->y1 - dy;
+				     if (STUB(gridx, gridy, ds->layer) == 0.0) {
+					sgrid_set(&Stub, gridx, gridy, ds->layer,
+							ds->y1 - dy);
 					Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 						|= STUBROUTE_NS;
 				     }
 				  }
 				  if ((dy - xdist - LefGetRouteSpacing(ds->layer) <
 					ds->y2) && (dy - xdist > ds->y2)) {
-				     if (Stub[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] == 0.0) {
-					Stub[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] = ds->y2 - dy;
+				     if (STUB(gridx, gridy, ds->layer) == 0.0) {
+					sgrid_set(&Stub, gridx, gridy, ds->layer,
+							ds->y2 - dy);
 					Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 						|= STUBROUTE_NS;
 				     }
@@ -1112,20 +1161,18 @@ void create_obstructions_from_nodes()
 				  xdist = 0.5 * LefGetViaWidth(ds->layer, ds->layer, 1);
 				  if ((dx + xdist + LefGetRouteSpacing(ds->layer) >
 					ds->x1) && (dx + xdist < ds->x1)) {
-				     if (Stub[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] == 0.0) {
-					Stub[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] = ds->x1 - dx;
+				     if (STUB(gridx, gridy, ds->layer) == 0.0) {
+					sgrid_set(&Stub, gridx, gridy, ds->layer,
+							ds->x1 - dx);
 					Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 						|= STUBROUTE_EW;
 				     }
 				  }
 				  if ((dx - xdist - LefGetRouteSpacing(ds->layer) <
 					ds->x2) && (dx - xdist > ds->x2)) {
-				     if (Stub[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] == 0.0) {
-					Stub[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] = ds->x2 - dx;
+				     if (STUB(gridx, gridy, ds->layer) == 0.0) {
+					sgrid_set(&Stub, gridx, gridy, ds->layer,
+							ds->x2 - dx);
 					Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 						|= STUBROUTE_EW;
 				     }
@@ -1149,32 +1196,24 @@ void create_obstructions_from_nodes()
 					ds->y1) && (dy + xdist < ds->y1)) {
 				     if ((dx - xdist < ds->x2) &&
 						(dx + xdist > ds->x1) &&
-						(Stub[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] == 0.0)) {
-					Stub[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] = ds->y1 - dy;
+						(STUB(gridx, gridy, ds->layer) == 0.0)) {
+					sgrid_set(&Stub, gridx, gridy, ds->layer,
+							ds->y1 - dy);
 					Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 						= node->netnum | STUBROUTE_NS;
-					Nodeloc[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] = node;
-					Nodesav[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] = node;
+					set_nodeloc(gridx, gridy, ds->layer, node);
 				     }
 				  }
 				  if ((dy - xdist - LefGetRouteSpacing(ds->layer) <
 					ds->y2) && (dy - xdist > ds->y2)) {
 				     if ((dx - xdist < ds->x2) &&
 						(dx + xdist > ds->x1) &&
-						(Stub[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] == 0.0)) {
-					Stub[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] = ds->y2 - dy;
+						(STUB(gridx, gridy, ds->layer) == 0.0)) {
+					sgrid_set(&Stub, gridx, gridy, ds->layer,
+							ds->y2 - dy);
 					Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 						= node->netnum | STUBROUTE_NS;
-					Nodeloc[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] = node;
-					Nodesav[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] = node;
+					set_nodeloc(gridx, gridy, ds->layer, node);
 				     }
 				  }
 
@@ -1183,32 +1222,24 @@ void create_obstructions_from_nodes()
 					ds->x1) && (dx + xdist < ds->x1)) {
 				     if ((dy - xdist < ds->y2) &&
 						(dy + xdist > ds->y1) &&
-						(Stub[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] == 0.0)) {
-					Stub[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] = ds->x1 - dx;
+						(STUB(gridx, gridy, ds->layer) == 0.0)) {
+					sgrid_set(&Stub, gridx, gridy, ds->layer,
+							ds->x1 - dx);
 					Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 						= node->netnum | STUBROUTE_EW;
-					Nodeloc[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] = node;
-					Nodesav[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] = node;
+					set_nodeloc(gridx, gridy, ds->layer, node);
 				     }
 				  }
 				  if ((dx - xdist - LefGetRouteSpacing(ds->layer) <
 					ds->x2) && (dx - xdist > ds->x2)) {
 				     if ((dy - xdist < ds->y2) &&
 						(dy + xdist > ds->y1) &&
-						(Stub[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] == 0.0)) {
-					Stub[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] = ds->x2 - dx;
+						(STUB(gridx, gridy, ds->layer) == 0.0)) {
+					sgrid_set(&Stub, gridx, gridy, ds->layer,
+							ds->x2 - dx);
 					Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 						= node->netnum | STUBROUTE_EW;
-					Nodeloc[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] = node;
-					Nodesav[ds->layer][OGRID(gridx, gridy,
-						ds->layer)] = node;
+					set_nodeloc(gridx, gridy, ds->layer, node);
 				     }
 				  }
 			       }
@@ -1295,7 +1326,7 @@ void tap_to_tap_interactions()
 		            dx = (gridx * PitchX[ds->layer]) + Xlowerbound;
 		            dy = (gridy * PitchY[ds->layer]) + Ylowerbound;
 
-			    dist = Stub[ds->layer][OGRID(gridx, gridy, ds->layer)];
+			    dist = STUB(gridx, gridy, ds->layer);
 
 			    /* "de" is the bounding box of a via placed	  */
 			    /* at (gridx, gridy) and offset as specified. */
@@ -1379,10 +1410,11 @@ make_routable(NODE node)
 			    if (orignet & NO_NET) {
 				Obs[ds->layer][OGRID(gridx, gridy, ds->layer)] =
 					g->netnum[i];
-				Nodeloc[ds->layer][OGRID(gridx, gridy, ds->layer)] =
-					node;
-				Nodesav[ds->layer][OGRID(gridx, gridy, ds->layer)] =
-					node;
+				set_nodeloc(gridx, gridy, ds->layer, node);
+				if (gridx < node->xmin) node->xmin = gridx;
+				if (gridy < node->ymin) node->ymin = gridy;
+				if (gridx > node->xmax) node->xmax = gridx;
+				if (gridy > node->ymax) node->ymax = gridy;
 				return;
 			    }
 			 }
@@ -1397,6 +1429,161 @@ make_routable(NODE node)
     }
 }
 
+/*--------------------------------------------------------------*/
+/* find_node_extents() ---					*/
+/*	Record for each node the bounding box of the grid	*/
+/*	positions that it occupies in Nodesav.  Nodeloc never	*/
+/*	has a node where Nodesav has none, so the positions of	*/
+/*	a net can be found without scanning the whole grid.	*/
+/*	Nodes with no positions get an empty box.		*/
+/*--------------------------------------------------------------*/
+
+void
+find_node_extents()
+{
+    NET net;
+    NODE node;
+    int i, x, y;
+
+    for (net = Nlnets; net; net = net->next) {
+       for (node = net->netnodes; node; node = node->next) {
+	  node->xmin = node->ymin = MAXRT;
+	  node->xmax = node->ymax = -1;
+       }
+    }
+
+    for (i = 0; i < Num_layers; i++) {
+       for (y = 0; y < NumChannelsY[i]; y++) {
+	  for (x = 0; x < NumChannelsX[i]; x++) {
+	     node = NODESAV(x, y, i);
+	     if (node == (NODE)NULL) continue;
+	     if (x < node->xmin) node->xmin = x;
+	     if (y < node->ymin) node->ymin = y;
+	     if (x > node->xmax) node->xmax = x;
+	     if (y > node->ymax) node->ymax = y;
+	  }
+       }
+    }
+}
+
+/*--------------------------------------------------------------*/
+/* track_state() ---						*/
+/*	Return zero if position (x, y) of layer "lay" is not	*/
+/*	plain free track:  free, and with no node on it or on	*/
+/*	the positions above and below, so that stepping onto	*/
+/*	it costs the segment cost alone.  Otherwise return a	*/
+/*	nonzero value that also records which of the positions	*/
+/*	above, below and to either side are free.		*/
+/*--------------------------------------------------------------*/
+
+static u_char track_free(int x, int y, int lay)
+{
+    if ((lay < 0) || (lay >= Num_layers)) return FALSE;
+    if ((x < 0) || (x >= NumChannelsX[lay])) return FALSE;
+    if ((y < 0) || (y >= NumChannelsY[lay])) return FALSE;
+    return ((Obs[lay][OGRID(x, y, lay)] & ~BLOCKED_MASK) == 0) ? TRUE : FALSE;
+}
+
+static u_int track_state(int x, int y, int lay, u_char horiz)
+{
+    u_int state;
+
+    if (!track_free(x, y, lay)) return 0;
+    if (Nodeid[lay][OGRID(x, y, lay)] != 0) return 0;
+    if ((lay > 0) && (Nodeid[lay - 1][OGRID(x, y, lay - 1)] != 0)) return 0;
+    if ((lay < Num_layers - 1) && (Nodeid[lay + 1][OGRID(x, y, lay + 1)] != 0))
+       return 0;
+
+    state = 0x01;
+    if (track_free(x, y, lay - 1)) state |= 0x02;
+    if (track_free(x, y, lay + 1)) state |= 0x04;
+    if (horiz) {
+       if (track_free(x, y - 1, lay)) state |= 0x08;
+       if (track_free(x, y + 1, lay)) state |= 0x10;
+    }
+    else {
+       if (track_free(x - 1, y, lay)) state |= 0x08;
+       if (track_free(x + 1, y, lay)) state |= 0x10;
+    }
+    return state;
+}
+
+/*--------------------------------------------------------------*/
+/* find_track_runs() ---					*/
+/*	Fill in Runs[] (see RUN_AHEAD()) from Obs and Nodeid.	*/
+/*	Neighboring positions along the preferred direction	*/
+/*	of a layer are in the same run if both are plain free	*/
+/*	track (see track_state()), with the same positions	*/
+/*	free around them, and the route between them is not	*/
+/*	blocked.  The search crosses a run in one step, so a	*/
+/*	route leaves it only at an end, where something		*/
+/*	changes, or where a target comes into line (see		*/
+/*	jump_pt()).  Runs[] is found once, before routing;	*/
+/*	jump_pt() checks the track as it goes for routes	*/
+/*	placed since.						*/
+/*--------------------------------------------------------------*/
+
+void
+find_track_runs()
+{
+    int i, j, k, n, horiz;
+    u_int *state, ahead, behind;
+    u_char *link;
+
+    n = 0;
+    for (i = 0; i < Num_layers; i++) {
+       if (NumChannelsX[i] > n) n = NumChannelsX[i];
+       if (NumChannelsY[i] > n) n = NumChannelsY[i];
+    }
+    state = (u_int *)malloc(n * sizeof(u_int));
+    link = (u_char *)malloc(n * sizeof(u_char));
+
+    for (i = 0; i < Num_layers; i++) {
+       horiz = (LefGetRouteOrientation(i) == 1) ? TRUE : FALSE;
+
+       // "j" counts tracks across the preferred direction, and "k"
+       // positions along it.
+
+       for (j = 0; j < (horiz ? NumChannelsY[i] : NumChannelsX[i]); j++) {
+	  n = horiz ? NumChannelsX[i] : NumChannelsY[i];
+	  for (k = 0; k < n; k++)
+	     state[k] = horiz ? track_state(k, j, i, horiz) :
+			track_state(j, k, i, horiz);
+	  for (k = 0; k < n - 1; k++) {
+	     link[k] = ((state[k] != 0) && (state[k] == state[k + 1])) ?
+			TRUE : FALSE;
+	     if (link[k] && horiz)
+		link[k] = ((Obs[i][OGRID(k, j, i)] & BLOCKED_E) ||
+			(Obs[i][OGRID(k + 1, j, i)] & BLOCKED_W)) ?
+			FALSE : TRUE;
+	     else if (link[k])
+		link[k] = ((Obs[i][OGRID(j, k, i)] & BLOCKED_N) ||
+			(Obs[i][OGRID(j, k + 1, i)] & BLOCKED_S)) ?
+			FALSE : TRUE;
+	  }
+
+	  // Run lengths ahead, counted back from the far end, and
+	  // behind, counted from the near end
+
+	  ahead = 0;
+	  for (k = n - 1; k >= 0; k--) {
+	     ahead = ((k < n - 1) && link[k]) ? MIN(ahead + 1, RUN_MAX) : 0;
+	     state[k] = ahead;
+	  }
+	  behind = 0;
+	  for (k = 0; k < n; k++) {
+	     behind = ((k > 0) && link[k - 1]) ? MIN(behind + 1, RUN_MAX) : 0;
+	     if (horiz)
+		Runs[i][OGRID(k, j, i)] = state[k] | (behind << 16);
+	     else
+		Runs[i][OGRID(j, k, i)] = state[k] | (behind << 16);
+	  }
+       }
+    }
+    free(state);
+    free(link);
+}
+
 /*--------------------------------------------------------------*/
 /* adjust_stub_lengths()					*/
 /*								*/
@@ -1488,7 +1675,7 @@ void adjust_stub_lengths()
 			     dt.y1 = dy - w;
 			     dt.y2 = dy + w;
 
-			     dist = Stub[ds->layer][OGRID(gridx, gridy, ds->layer)];
+			     dist = STUB(gridx, gridy, ds->layer);
 
 			     // adjust the route box according to the stub
 			     // or offset geometry
@@ -1621,14 +1808,14 @@ void adjust_stub_lengths()
 				   if ((orignet & PINOBSTRUCTMASK) == 0) {
 			              Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 						|= STUBROUTE_EW;
-			              Stub[ds->layer][OGRID(gridx, gridy, ds->layer)]
-						= de.x2 - dx;
+			              sgrid_set(&Stub, gridx, gridy, ds->layer,
+						de.x2 - dx);
 				      errbox = FALSE;
 				   }
 				   else if ((orignet & PINOBSTRUCTMASK) == STUBROUTE_EW
 						&& (dist > 0)) {
-			              Stub[ds->layer][OGRID(gridx, gridy, ds->layer)]
-						= de.x2 - dx;
+			              sgrid_set(&Stub, gridx, gridy, ds->layer,
+						de.x2 - dx);
 				      errbox = FALSE;
 				   }
 				   else if ((orignet & PINOBSTRUCTMASK) ==
@@ -1637,8 +1824,8 @@ void adjust_stub_lengths()
 						&= ~STUBROUTE_NS;
 			              Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 						|= STUBROUTE_EW;
-			              Stub[ds->layer][OGRID(gridx, gridy, ds->layer)]
-						= de.x2 - dx;
+			              sgrid_set(&Stub, gridx, gridy, ds->layer,
+						de.x2 - dx);
 				      errbox = FALSE;
 				   }
 				}
@@ -1646,14 +1833,14 @@ void adjust_stub_lengths()
 				   if ((orignet & PINOBSTRUCTMASK) == 0) {
 			              Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 						|= STUBROUTE_EW;
-			              Stub[ds->layer][OGRID(gridx, gridy, ds->layer)]
-						= de.x1 - dx;
+			              sgrid_set(&Stub, gridx, gridy, ds->layer,
+						de.x1 - dx);
 				      errbox = FALSE;
 				   }
 				   else if ((orignet & PINOBSTRUCTMASK) == STUBROUTE_EW
 						&& (dist < 0)) {
-			              Stub[ds->layer][OGRID(gridx, gridy, ds->layer)]
-						= de.x1 - dx;
+			              sgrid_set(&Stub, gridx, gridy, ds->layer,
+						de.x1 - dx);
 				      errbox = FALSE;
 				   }
 				   else if ((orignet & PINOBSTRUCTMASK) ==
@@ -1662,8 +1849,8 @@ void adjust_stub_lengths()
 						&= ~STUBROUTE_NS;
 			              Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 						|= STUBROUTE_EW;
-			              Stub[ds->layer][OGRID(gridx, gridy, ds->layer)]
-						= de.x1 - dx;
+			              sgrid_set(&Stub, gridx, gridy, ds->layer,
+						de.x1 - dx);
 				      errbox = FALSE;
 				   }
 				}
@@ -1671,14 +1858,14 @@ void adjust_stub_lengths()
 				   if ((orignet & PINOBSTRUCTMASK) == 0) {
 			              Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 						|= STUBROUTE_NS;
-			              Stub[ds->layer][OGRID(gridx, gridy, ds->layer)]
-						= de.y2 - dy;
+			              sgrid_set(&Stub, gridx, gridy, ds->layer,
+						de.y2 - dy);
 				      errbox = FALSE;
 				   }
 				   else if ((orignet & PINOBSTRUCTMASK) == STUBROUTE_NS
 						&& (dist > 0)) {
-			              Stub[ds->layer][OGRID(gridx, gridy, ds->layer)]
-						= de.y2 - dy;
+			              sgrid_set(&Stub, gridx, gridy, ds->layer,
+						de.y2 - dy);
 				      errbox = FALSE;
 				   }
 				   else if ((orignet & PINOBSTRUCTMASK) ==
@@ -1687,8 +1874,8 @@ void adjust_stub_lengths()
 						&= ~STUBROUTE_EW;
 			              Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 						|= STUBROUTE_NS;
-			              Stub[ds->layer][OGRID(gridx, gridy, ds->layer)]
-						= de.y2 - dy;
+			              sgrid_set(&Stub, gridx, gridy, ds->layer,
+						de.y2 - dy);
 				      errbox = FALSE;
 				   }
 				}
@@ -1696,14 +1883,14 @@ void adjust_stub_lengths()
 				   if ((orignet & PINOBSTRUCTMASK) == 0) {
 			              Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 						|= STUBROUTE_NS;
-			              Stub[ds->layer][OGRID(gridx, gridy, ds->layer)]
-						= de.y1 - dy;
+			              sgrid_set(&Stub, gridx, gridy, ds->layer,
+						de.y1 - dy);
 				      errbox = FALSE;
 				   }
 				   else if ((orignet & PINOBSTRUCTMASK) == STUBROUTE_NS
 						&& (dist < 0)) {
-			              Stub[ds->layer][OGRID(gridx, gridy, ds->layer)]
-						= de.y1 - dy;
+			              sgrid_set(&Stub, gridx, gridy, ds->layer,
+						de.y1 - dy);
 				      errbox = FALSE;
 				   }
 				   else if ((orignet & PINOBSTRUCTMASK) ==
@@ -1712,8 +1899,8 @@ void adjust_stub_lengths()
 						&= ~STUBROUTE_EW;
 			              Obs[ds->layer][OGRID(gridx, gridy, ds->layer)]
 						|= STUBROUTE_NS;
-			              Stub[ds->layer][OGRID(gridx, gridy, ds->layer)]
-						= de.y1 - dy;
+			              sgrid_set(&Stub, gridx, gridy, ds->layer,
+						de.y1 - dy);
 				      errbox = FALSE;
 				   }
 				}
@@ -1859,12 +2046,14 @@ find_route_blocks()
 		     gridy++;
 		  }
 		  while (dy < ds->y2 + s) {
-		     u = ((Obs[ds->layer][OGRID(gridx, gridy, ds->layer)] &
+		     if ((gridy >= 0) && (gridy < NumChannelsY[ds->layer])) {
+			u = ((Obs[ds->layer][OGRID(gridx, gridy, ds->layer)] &
 				PINOBSTRUCTMASK) == STUBROUTE_EW) ? v : w;
-		     if (dy + EPS < ds->y2 - u)
-			block_route(gridx, gridy, ds->layer, NORTH);
-		     if (dy - EPS > ds->y1 + u)
-			block_route(gridx, gridy, ds->layer, SOUTH);
+			if (dy + EPS < ds->y2 - u)
+			   block_route(gridx, gridy, ds->layer, NORTH);
+			if (dy - EPS > ds->y1 + u)
+			   block_route(gridx, gridy, ds->layer, SOUTH);
+		     }
 		     dy += PitchY[ds->layer];
 		     gridy++;
 		  }
@@ -1892,12 +2081,14 @@ find_route_blocks()
 		     gridy++;
 		  }
 		  while (dy < ds->y2 + s) {
-		     u = ((Obs[ds->layer][OGRID(gridx, gridy, ds->layer)] &
+		     if ((gridy >= 0) && (gridy < NumChannelsY[ds->layer])) {
+			u = ((Obs[ds->layer][OGRID(gridx, gridy, ds->layer)] &
 				PINOBSTRUCTMASK) == STUBROUTE_EW) ? v : w;
-		     if (dy + EPS < ds->y2 - u)
-			block_route(gridx, gridy, ds->layer, NORTH);
-		     if (dy - EPS > ds->y1 + u)
-			block_route(gridx, gridy, ds->layer, SOUTH);
+			if (dy + EPS < ds->y2 - u)
+			   block_route(gridx, gridy, ds->layer, NORTH);
+			if (dy - EPS > ds->y1 + u)
+			   block_route(gridx, gridy, ds->layer, SOUTH);
+		     }
 		     dy += PitchY[ds->layer];
 		     gridy++;
 		  }
@@ -1925,12 +2116,14 @@ find_route_blocks()
 		     gridx++;
 		  }
 		  while (dx < ds->x2 + s) {
-		     u = ((Obs[ds->layer][OGRID(gridx, gridy, ds->layer)] &
+		     if ((gridx >= 0) && (gridx < NumChannelsX[ds->layer])) {
+			u = ((Obs[ds->layer][OGRID(gridx, gridy, ds->layer)] &
 				PINOBSTRUCTMASK) == STUBROUTE_NS) ? v : w;
-		     if (dx + EPS < ds->x2 - u)
-			block_route(gridx, gridy, ds->layer, EAST);
-		     if (dx - EPS > ds->x1 + u)
-			block_route(gridx, gridy, ds->layer, WEST);
+			if (dx + EPS < ds->x2 - u)
+			   block_route(gridx, gridy, ds->layer, EAST);
+			if (dx - EPS > ds->x1 + u)
+			   block_route(gridx, gridy, ds->layer, WEST);
+		     }
 		     dx += PitchX[ds->layer];
 		     gridx++;
 		  }
@@ -1958,12 +2151,14 @@ find_route_blocks()
 		     gridx++;
 		  }
 		  while (dx < ds->x2 + s) {
-		     u = ((Obs[ds->layer][OGRID(gridx, gridy, ds->layer)] &
+		     if ((gridx >= 0) && (gridx < NumChannelsX[ds->layer])) {
+			u = ((Obs[ds->layer][OGRID(gridx, gridy, ds->layer)] &
 				PINOBSTRUCTMASK) == STUBROUTE_NS) ? v : w;
-		     if (dx + EPS < ds->x2 - u)
-			block_route(gridx, gridy, ds->layer, EAST);
-		     if (dx - EPS > ds->x1 + u)
-			block_route(gridx, gridy, ds->layer, WEST);
+			if (dx + EPS < ds->x2 - u)
+			   block_route(gridx, gridy, ds->layer, EAST);
+			if (dx - EPS > ds->x1 + u)
+			   block_route(gridx, gridy, ds->layer, WEST);
+		     }
 		     dx += PitchX[ds->layer];
 		     gridx++;
 		  }
@@ -11,7 +11,8 @@
 #define VDD_NET		 2
 #define MIN_NET_NUMBER   3
 
-void create_netorder( void );
+void create_nettab( void );
+NET  find_net( char *netname );
 void create_netlist( void );
 void print_nodes( char *filename );
 void print_nlnets( char *filename );
@@ -21,6 +22,10 @@ void create_obstructions_from_variable_pitch( void );
 void tap_to_tap_interactions( void );
 void make_routable( NODE node );
 void adjust_stub_lengths( void );
+void find_node_extents( void );
+void find_track_runs( void );
+void create_nodetab( void );
+void set_nodeloc( int x, int y, int lay, NODE node );
 int isconnected( NODE node1, NODE node2 );
 int isconnectedrecurse( NODE node1, NODE node2 );
 
@@ -0,0 +1,289 @@
+/*--------------------------------------------------------------*/
+/* order.c -- order in which the nets are routed.		*/
+/*								*/
+/* Nets marked critical in the configuration file are routed	*/
+/* first, in the order listed.  The rest are sorted once by	*/
+/* the strategy chosen with "route order" or "-o":		*/
+/*								*/
+/*   fanout	most nodes first (the default)			*/
+/*   area	smallest bounding box first			*/
+/*   hpwl	shortest half-perimeter wirelength first	*/
+/*   density	most pins per unit area of the bounding box	*/
+/*		first (nets in crowded regions)			*/
+/*   critical	critical nets only;  the rest as read		*/
+/*								*/
+/* Nets that tie keep the order of Nlnets.  The order chosen	*/
+/* can be written out with "route order file" as "route	*/
+/* priority" lines, to put in the configuration file of a	*/
+/* later run.							*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "qrouter.h"
+#include "config.h"
+#include "node.h"
+#include "order.h"
+
+#define ORDER_BIN	8	// Tracks per bin, for pin density
+
+static char *OrderNames[] = {
+   "fanout", "area", "hpwl", "density", "critical", NULL
+};
+
+// A net and its sort key
+
+typedef struct {
+   NET net;
+   double key;
+   int index;		// position in Nlnets, to break ties
+} ONET;
+
+/*--------------------------------------------------------------*/
+/* netorder_lookup() ---					*/
+/*								*/
+/* Return the ORDER_* strategy named "name", or -1 if there is	*/
+/* none by that name.						*/
+/*--------------------------------------------------------------*/
+
+int netorder_lookup(char *name)
+{
+   int i;
+
+   for (i = 0; OrderNames[i] != NULL; i++)
+      if (!strcasecmp(name, OrderNames[i]))
+	 return i;
+   return -1;
+}
+
+/*--------------------------------------------------------------*/
+/* Bounding box of the grid positions of the nodes of "net",	*/
+/* from their taps (or from the extended taps of nodes that	*/
+/* have none).  Return 0 if the net has no positions.		*/
+/*--------------------------------------------------------------*/
+
+static int net_bbox(NET net, int *x1, int *y1, int *x2, int *y2)
+{
+   NODE node;
+   DPOINT dp;
+   int found = 0;
+
+   *x1 = *y1 = MAXRT;
+   *x2 = *y2 = -1;
+   for (node = net->netnodes; node; node = node->next) {
+      dp = (node->taps != NULL) ? node->taps : node->extend;
+      for (; dp; dp = dp->next) {
+	 if (dp->gridx < *x1) *x1 = dp->gridx;
+	 if (dp->gridx > *x2) *x2 = dp->gridx;
+	 if (dp->gridy < *y1) *y1 = dp->gridy;
+	 if (dp->gridy > *y2) *y2 = dp->gridy;
+	 found = 1;
+      }
+   }
+   return found;
+}
+
+/*--------------------------------------------------------------*/
+/* Bin of the first grid position of "node", for pin density.	*/
+/* Return 0 if the node has no positions.			*/
+/*--------------------------------------------------------------*/
+
+static int node_bin(NODE node, int *bx, int *by)
+{
+   DPOINT dp;
+
+   dp = (node->taps != NULL) ? node->taps : node->extend;
+   if (dp == NULL) return 0;
+   *bx = (dp->gridx > 0) ? dp->gridx / ORDER_BIN : 0;
+   *by = (dp->gridy > 0) ? dp->gridy / ORDER_BIN : 0;
+   return 1;
+}
+
+/*--------------------------------------------------------------*/
+/* Pin density of the bounding box of each net in "onets",	*/
+/* into its key.  The pins of all nets are counted into bins	*/
+/* of ORDER_BIN tracks square, and summed over the area so	*/
+/* that each net is counted in constant time.			*/
+/*--------------------------------------------------------------*/
+
+static void order_density(ONET *onets, int numnets)
+{
+   NET net;
+   NODE node;
+   int *sum;
+   int nbinx, nbiny, bx, by, x1, y1, x2, y2, i;
+
+   nbinx = nbiny = 1;
+   for (net = Nlnets; net; net = net->next)
+      for (node = net->netnodes; node; node = node->next)
+	 if (node_bin(node, &bx, &by)) {
+	    if (bx >= nbinx) nbinx = bx + 1;
+	    if (by >= nbiny) nbiny = by + 1;
+	 }
+
+   // sum[] holds the pins of bins (0, 0) to (x - 1, y - 1) at
+   // (x, y), with a row and column of zeros ahead of the bins.
+
+   sum = (int *)calloc((nbinx + 1) * (nbiny + 1), sizeof(int));
+   for (net = Nlnets; net; net = net->next)
+      for (node = net->netnodes; node; node = node->next)
+	 if (node_bin(node, &bx, &by))
+	    sum[(by + 1) * (nbinx + 1) + bx + 1]++;
+
+   for (by = 1; by <= nbiny; by++)
+      for (bx = 1; bx <= nbinx; bx++)
+	 sum[by * (nbinx + 1) + bx] += sum[(by - 1) * (nbinx + 1) + bx]
+		+ sum[by * (nbinx + 1) + bx - 1]
+		- sum[(by - 1) * (nbinx + 1) + bx - 1];
+
+   for (i = 0; i < numnets; i++) {
+      if (!net_bbox(onets[i].net, &x1, &y1, &x2, &y2)) {
+	 onets[i].key = 0.0;
+	 continue;
+      }
+      x1 = (x1 > 0) ? x1 / ORDER_BIN : 0;
+      y1 = (y1 > 0) ? y1 / ORDER_BIN : 0;
+      x2 = (x2 > 0) ? x2 / ORDER_BIN + 1 : 1;
+      y2 = (y2 > 0) ? y2 / ORDER_BIN + 1 : 1;
+      onets[i].key = -(double)(sum[y2 * (nbinx + 1) + x2]
+		- sum[y1 * (nbinx + 1) + x2] - sum[y2 * (nbinx + 1) + x1]
+		+ sum[y1 * (nbinx + 1) + x1]) / ((x2 - x1) * (y2 - y1));
+   }
+   free(sum);
+}
+
+/*--------------------------------------------------------------*/
+/* Sort by key, ascending, then by position in Nlnets.		*/
+/*--------------------------------------------------------------*/
+
+static int order_compare(const void *a, const void *b)
+{
+   const ONET *oa = (const ONET *)a;
+   const ONET *ob = (const ONET *)b;
+
+   if (oa->key < ob->key) return -1;
+   if (oa->key > ob->key) return 1;
+   return oa->index - ob->index;
+}
+
+/*--------------------------------------------------------------*/
+/* create_netorder --- assign indexes to net->netorder    	*/
+/*								*/
+/* 	Any nets marked critical in the configuration or	*/
+/*	critical net files are given precedence.  The rest are	*/
+/*	ordered by the strategy in NetOrder (see above).  The	*/
+/*	nets are found by name with find_net(), so this must	*/
+/*	be called after create_nettab().			*/
+/*								*/
+/*  ARGS: none							*/
+/*  RETURNS: nothing						*/
+/*  SIDE EFFECTS: Nlnets -> netorder is assigned, and the	*/
+/*	nets that can be routed are indexed by order in		*/
+/*	Netorder[]						*/
+/*--------------------------------------------------------------*/
+
+void create_netorder()
+{
+  int i, j, numnets, x1, y1, x2, y2;
+  NET  net;
+  STRING cn;
+  ONET *onets;
+
+  i = 1;
+  for (cn = CriticalNet; cn; cn = cn->next) {
+     fprintf(stdout, "critical net %s\n", cn->name);
+     net = find_net((char *)cn->name);
+     if (net != NULL) net->netorder = i++;
+  }
+
+  numnets = 0;
+  for (net = Nlnets; net; net = net->next) numnets++;
+  onets = (ONET *)malloc((numnets + 1) * sizeof(ONET));
+
+  numnets = 0;
+  for (net = Nlnets; net; net = net->next) {
+     if (net->netorder) continue;
+     onets[numnets].net = net;
+     onets[numnets].index = numnets;
+     switch (NetOrder) {
+	case ORDER_FANOUT:
+	   onets[numnets].key = -(double)net->numnodes;
+	   break;
+	case ORDER_AREA:
+	   onets[numnets].key = (net_bbox(net, &x1, &y1, &x2, &y2)) ?
+			(double)(x2 - x1 + 1) * (double)(y2 - y1 + 1) : 0.0;
+	   break;
+	case ORDER_HPWL:
+	   onets[numnets].key = (net_bbox(net, &x1, &y1, &x2, &y2)) ?
+			(double)((x2 - x1) + (y2 - y1)) : 0.0;
+	   break;
+	default:
+	   onets[numnets].key = 0.0;
+	   break;
+     }
+     numnets++;
+  }
+
+  if (NetOrder == ORDER_DENSITY) order_density(onets, numnets);
+  if (NetOrder != ORDER_CRITICAL)
+     qsort(onets, numnets, sizeof(ONET), order_compare);
+
+  for (j = 0; (j < numnets) && (i <= Numnets); j++)
+     onets[j].net->netorder = i++;
+
+  free(onets);
+
+  // Index the nets to route by order.  Qrouter will route power and
+  // ground nets even if the standard cell power and ground pins are
+  // not listed in the nets section.  Because of this, it is okay to
+  // have only one node.
+
+  Netorder = (NET *)calloc(Numnets + 1, sizeof(NET));
+  for (net = Nlnets; net; net = net->next) {
+     if ((net->netorder >= 0) && (net->netorder <= Numnets) &&
+		(Netorder[net->netorder] == NULL) &&
+		((net->numnodes >= 2) || ((net->numnodes == 1) &&
+		((net->netnum == VDD_NET) || (net->netnum == GND_NET)))))
+	Netorder[net->netorder] = net;
+  }
+
+  if (NetOrderFile != NULL) save_netorder(NetOrderFile);
+
+} /* create_netorder() */
+
+/*--------------------------------------------------------------*/
+/* save_netorder() ---						*/
+/*								*/
+/* Write the nets in routing order to "filename", as "route	*/
+/* priority" lines for the configuration file.			*/
+/*--------------------------------------------------------------*/
+
+void save_netorder(char *filename)
+{
+   FILE *f;
+   NET net, *byorder;
+   int i;
+
+   f = fopen(filename, "w");
+   if (f == NULL) {
+      fprintf(stderr, "Warning: Could not open file \"%s\"\n", filename);
+      return;
+   }
+
+   byorder = (NET *)calloc(Numnets + 1, sizeof(NET));
+   for (net = Nlnets; net; net = net->next)
+      if ((net->netorder > 0) && (net->netorder <= Numnets))
+	 byorder[net->netorder] = net;
+
+   fprintf(f, "# Net order (%s)\n", OrderNames[NetOrder]);
+   for (i = 1; i <= Numnets; i++)
+      if (byorder[i] != NULL)
+	 fprintf(f, "Route Priority\t%s\n", byorder[i]->netname);
+
+   free(byorder);
+   fclose(f);
+}
+
+/* end of order.c */
@@ -0,0 +1,14 @@
+/*--------------------------------------------------------------*/
+/* order.h -- order in which the nets are routed		*/
+/*--------------------------------------------------------------*/
+
+#ifndef ORDER_H
+
+int	netorder_lookup(char *name);
+void	create_netorder();
+void	save_netorder(char *filename);
+
+#define ORDER_H
+#endif
+
+/* end of order.h */
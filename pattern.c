@@ -0,0 +1,301 @@
+/*--------------------------------------------------------------*/
+/* pattern.c -- pattern routes of two-node nets.		*/
+/*								*/
+/* Most two-node nets are short, and their best route is one	*/
+/* of the L-shaped routes between the terminals, or a Z-shaped	*/
+/* route with one jog, on one horizontal and one vertical	*/
+/* layer.  These are few enough to cost out one by one, so	*/
+/* route_segs() tries them before searching the grid.  The	*/
+/* cheapest one is written into Obs2[] the way the search	*/
+/* would have left it, and committed with commit_proute().	*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "qrouter.h"
+#include "config.h"
+#include "node.h"
+#include "maze.h"
+#include "lef.h"
+#include "pattern.h"
+
+#define PATTERN_MAXWAY	8	// Waypoints of the longest pattern (Z-route)
+
+/*--------------------------------------------------------------*/
+/* Append waypoint (x, y, lay) to the pattern "way".		*/
+/*--------------------------------------------------------------*/
+
+static void pattern_add(GRIDP *way, int *nway, int x, int y, int lay)
+{
+   way[*nway].x = x;
+   way[*nway].y = y;
+   way[*nway].lay = lay;
+   (*nway)++;
+}
+
+/*--------------------------------------------------------------*/
+/* pattern_walk() ---						*/
+/*								*/
+/* Walk the pattern "way" one grid step at a time from its	*/
+/* first waypoint (a source tap), and return the cost of the	*/
+/* route to the first target position it reaches, which is	*/
+/* left in "end".  Return -1 if the pattern runs into anything	*/
+/* the search could not route through, stacks more vias than	*/
+/* allowed, or doubles back on itself.  Crossing a source	*/
+/* position starts the route over from there at no cost, as	*/
+/* in the search.						*/
+/*								*/
+/* If "commit" is TRUE, the predecessor and cost of each	*/
+/* position are written into Obs2[], for commit_proute().	*/
+/* Obs2[] must have no predecessors set yet, so a position	*/
+/* that has one is a loop back onto the route, which is cut	*/
+/* by leaving the position as it was.  Also used for the	*/
+/* routes found by the line probe (see probe.c).		*/
+/*--------------------------------------------------------------*/
+
+int pattern_walk(GRIDP *way, int nway, u_char commit, GRIDP *end)
+{
+   GRIDP cur, next;
+   PROUTE *Pr;
+   u_int forbid;
+   u_char pred;
+   int w, cost, stack, vdir;
+
+   cur = way[0];
+   cur.idx = OGRID(cur.x, cur.y, cur.lay);
+   cost = 0;
+   stack = 0;
+   vdir = 0;
+
+   for (w = 1; w < nway; w++) {
+      while ((cur.x != way[w].x) || (cur.y != way[w].y) ||
+		(cur.lay != way[w].lay)) {
+	 next = cur;
+	 forbid = Obs[cur.lay][cur.idx] & BLOCKED_MASK;
+
+	 if (cur.lay != way[w].lay) {
+	    if (cur.lay < way[w].lay) {
+	       if (vdir < 0) return -1;		// Would retrace the stack
+	       vdir = 1;
+	       next.lay++;
+	       pred = PR_PRED_D;
+	    }
+	    else {
+	       if (vdir > 0) return -1;
+	       vdir = -1;
+	       next.lay--;
+	       pred = PR_PRED_U;
+	    }
+	    if (++stack > StackedContacts) return -1;
+	 }
+	 else {
+	    if (cur.x < way[w].x) {
+	       if ((forbid & BLOCKED_E) || (cur.x + 1 >= NumChannelsX[cur.lay]) ||
+			(cur.x + 1 > RouteArea.x2))
+		  return -1;
+	       next.idx = OGRID_EAST(cur.idx, cur.x);
+	       next.x++;
+	       pred = PR_PRED_W;
+	    }
+	    else if (cur.x > way[w].x) {
+	       if ((forbid & BLOCKED_W) || (cur.x - 1 < 0) ||
+			(cur.x - 1 < RouteArea.x1))
+		  return -1;
+	       next.idx = OGRID_WEST(cur.idx, cur.x);
+	       next.x--;
+	       pred = PR_PRED_E;
+	    }
+	    else if (cur.y < way[w].y) {
+	       if ((forbid & BLOCKED_N) || (cur.y + 1 >= NumChannelsY[cur.lay]) ||
+			(cur.y + 1 > RouteArea.y2))
+		  return -1;
+	       next.idx = OGRID_NORTH(cur.idx, cur.y);
+	       next.y++;
+	       pred = PR_PRED_S;
+	    }
+	    else {
+	       if ((forbid & BLOCKED_S) || (cur.y - 1 < 0) ||
+			(cur.y - 1 < RouteArea.y1))
+		  return -1;
+	       next.idx = OGRID_SOUTH(cur.idx, cur.y);
+	       next.y--;
+	       pred = PR_PRED_N;
+	    }
+	    stack = 0;
+	    vdir = 0;
+	 }
+
+	 Pr = OBS2_AT(next.idx, next.lay);
+	 if (!(Pr->flags & (PR_COST | PR_SOURCE))) return -1;
+
+	 if (Pr->flags & PR_SOURCE) {
+	    cost = 0;
+	    stack = 0;
+	    vdir = 0;
+	 }
+	 else {
+	    cost += step_cost(&cur, &next);
+	    if (commit) {
+	       if ((Pr->flags & PR_PRED_DMASK) != PR_PRED_NONE)
+		  cost = Pr->prdata;	// Back on the route:  drop the loop
+	       else {
+		  Pr->flags |= pred;
+		  Pr->prdata = cost;
+	       }
+	    }
+	 }
+	 cur = next;
+
+	 if (Pr->flags & PR_TARGET) {
+	    *end = cur;
+	    end->cost = cost;
+	    return cost;
+	 }
+      }
+   }
+   return -1;		// Pattern did not end on a target
+}
+
+/*--------------------------------------------------------------*/
+/* Cost out the pattern "way", and keep it in "bestway" if it	*/
+/* is the cheapest so far.					*/
+/*--------------------------------------------------------------*/
+
+static void pattern_try(GRIDP *way, int nway, GRIDP *bestway, int *nbest,
+		int *bestcost)
+{
+   GRIDP end;
+   int cost;
+
+   cost = pattern_walk(way, nway, FALSE, &end);
+   if ((cost >= 0) && (cost < *bestcost)) {
+      *bestcost = cost;
+      memcpy(bestway, way, nway * sizeof(GRIDP));
+      *nbest = nway;
+   }
+}
+
+/*--------------------------------------------------------------*/
+/* pattern_route() ---						*/
+/*								*/
+/* Try the L- and Z-shaped routes between each source tap and	*/
+/* each target tap of "net" no more than PatternRoute tracks	*/
+/* apart, on each pair of a horizontal and a vertical layer.	*/
+/* Obs2[] must be set up for the search, with the source and	*/
+/* target positions marked.					*/
+/*								*/
+/* RETURNS: 1 if a route of cost "maxcost" or less was found,	*/
+/*	    in which case it has been written into Obs2[] and	*/
+/*	    its target position is left in "best";  0 if not.	*/
+/*--------------------------------------------------------------*/
+
+int pattern_route(NET net, GRIDP *best, int maxcost)
+{
+   GRIDP way[PATTERN_MAXWAY], bestway[PATTERN_MAXWAY];
+   NODE snode, tnode;
+   DPOINT stap, ttap;
+   PROUTE *Pr;
+   int nway, nbest, bestcost;
+   int sx, sy, sl, tx, ty, tl, lh, lv, xm, ym, xd, yd;
+
+   nbest = 0;
+   bestcost = maxcost + 1;
+
+   for (snode = net->netnodes; snode; snode = snode->next) {
+      stap = (snode->taps != NULL) ? snode->taps : snode->extend;
+      for (; stap; stap = stap->next) {
+	 sx = stap->gridx;
+	 sy = stap->gridy;
+	 sl = stap->layer;
+	 if ((sx < RouteArea.x1) || (sx > RouteArea.x2) ||
+		(sy < RouteArea.y1) || (sy > RouteArea.y2))
+	    continue;
+	 Pr = OBS2(sx, sy, sl);
+	 if (!(Pr->flags & PR_SOURCE)) continue;
+
+	 for (tnode = net->netnodes; tnode; tnode = tnode->next) {
+	    ttap = (tnode->taps != NULL) ? tnode->taps : tnode->extend;
+	    for (; ttap; ttap = ttap->next) {
+	       tx = ttap->gridx;
+	       ty = ttap->gridy;
+	       tl = ttap->layer;
+	       if ((tx < RouteArea.x1) || (tx > RouteArea.x2) ||
+			(ty < RouteArea.y1) || (ty > RouteArea.y2))
+		  continue;
+	       if (abs(tx - sx) + abs(ty - sy) > PatternRoute) continue;
+	       Pr = OBS2(tx, ty, tl);
+	       if (!(Pr->flags & PR_TARGET)) continue;
+
+	       xd = (tx > sx) ? 1 : -1;
+	       yd = (ty > sy) ? 1 : -1;
+
+	       for (lh = 0; lh < Num_layers; lh++) {
+		  if (LefGetRouteOrientation(lh) != 1) continue;
+		  for (lv = 0; lv < Num_layers; lv++) {
+		     if (LefGetRouteOrientation(lv) == 1) continue;
+
+		     // L-routes, horizontal first and vertical first
+
+		     nway = 0;
+		     pattern_add(way, &nway, sx, sy, sl);
+		     pattern_add(way, &nway, sx, sy, lh);
+		     pattern_add(way, &nway, tx, sy, lh);
+		     pattern_add(way, &nway, tx, sy, lv);
+		     pattern_add(way, &nway, tx, ty, lv);
+		     pattern_add(way, &nway, tx, ty, tl);
+		     pattern_try(way, nway, bestway, &nbest, &bestcost);
+
+		     nway = 0;
+		     pattern_add(way, &nway, sx, sy, sl);
+		     pattern_add(way, &nway, sx, sy, lv);
+		     pattern_add(way, &nway, sx, ty, lv);
+		     pattern_add(way, &nway, sx, ty, lh);
+		     pattern_add(way, &nway, tx, ty, lh);
+		     pattern_add(way, &nway, tx, ty, tl);
+		     pattern_try(way, nway, bestway, &nbest, &bestcost);
+
+		     // Z-routes with a vertical jog at each column between
+
+		     for (xm = sx + xd; (xm - tx) * xd < 0; xm += xd) {
+			nway = 0;
+			pattern_add(way, &nway, sx, sy, sl);
+			pattern_add(way, &nway, sx, sy, lh);
+			pattern_add(way, &nway, xm, sy, lh);
+			pattern_add(way, &nway, xm, sy, lv);
+			pattern_add(way, &nway, xm, ty, lv);
+			pattern_add(way, &nway, xm, ty, lh);
+			pattern_add(way, &nway, tx, ty, lh);
+			pattern_add(way, &nway, tx, ty, tl);
+			pattern_try(way, nway, bestway, &nbest, &bestcost);
+		     }
+
+		     // Z-routes with a horizontal jog at each row between
+
+		     for (ym = sy + yd; (ym - ty) * yd < 0; ym += yd) {
+			nway = 0;
+			pattern_add(way, &nway, sx, sy, sl);
+			pattern_add(way, &nway, sx, sy, lv);
+			pattern_add(way, &nway, sx, ym, lv);
+			pattern_add(way, &nway, sx, ym, lh);
+			pattern_add(way, &nway, tx, ym, lh);
+			pattern_add(way, &nway, tx, ym, lv);
+			pattern_add(way, &nway, tx, ty, lv);
+			pattern_add(way, &nway, tx, ty, tl);
+			pattern_try(way, nway, bestway, &nbest, &bestcost);
+		     }
+		  }
+	       }
+	    }
+	 }
+      }
+   }
+
+   if (nbest == 0) return 0;
+
+   pattern_walk(bestway, nbest, TRUE, best);
+   return 1;
+}
+
+/* end of pattern.c */
@@ -0,0 +1,13 @@
+/*--------------------------------------------------------------*/
+/* pattern.h -- L- and Z-shaped routes of two-node nets		*/
+/*--------------------------------------------------------------*/
+
+#ifndef PATTERN_H
+
+int	pattern_walk(GRIDP *way, int nway, u_char commit, GRIDP *end);
+int	pattern_route(NET net, GRIDP *best, int maxcost);
+
+#define PATTERN_H
+#endif
+
+/* end of pattern.h */
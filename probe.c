@@ -0,0 +1,419 @@
+/*--------------------------------------------------------------*/
+/* probe.c -- line-probe router.				*/
+/*								*/
+/* After Hightower:  lines are shot from the source and target	*/
+/* taps along the preferred direction of each layer, as far as	*/
+/* the track is free.  Where a source line meets a target line	*/
+/* (crossing it on another layer, or overlapping it on the	*/
+/* same track) the net can be routed along the two lines.  If	*/
+/* no lines meet, new lines are shot across the old ones from	*/
+/* "escape points" on them, up to PROBE_LEVELS times.  A long	*/
+/* net through open space connects with a few lines, where the	*/
+/* grid search would have expanded everything within the cost	*/
+/* of the route.  The route is written into Obs2[] and		*/
+/* committed as the search would be (see pattern_walk()).	*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "qrouter.h"
+#include "config.h"
+#include "node.h"
+#include "maze.h"
+#include "lef.h"
+#include "pattern.h"
+#include "probe.h"
+
+#define PROBE_MAXLINES	512	// Lines from each side of the net
+#define PROBE_LEVELS	3	// Times to shoot lines from the last lines
+#define PROBE_MAXWAY	(5 * PROBE_LEVELS + 6)
+
+// A probe line runs along track "pos" of layer "lay", from "lo" to
+// "hi".  It was shot from position (ox, oy) on layer "olay", which is
+// a tap for the first lines, and a point on line "parent" otherwise.
+
+typedef struct probe_ PROBE;
+
+struct probe_ {
+   int lay;
+   u_char horiz;	// TRUE if the line runs along x, so pos is y
+   int pos;
+   int lo, hi;
+   int ox, oy, olay;
+   int parent;		// Index of the line shot from, or -1
+};
+
+// The lines shot from one side of the net
+
+typedef struct probeset_ PROBESET;
+
+struct probeset_ {
+   PROBE line[PROBE_MAXLINES];
+   int count;
+   int gx, gy;		// A tap on the other side, to aim at
+   u_char horiz[MAX_LAYERS];	// Preferred direction of each layer
+};
+
+// Nonzero if the position at offset "idx" on layer "lay" can be routed.
+// Positions not yet copied into Obs2 are read from Obs, so that long
+// lines leave Obs2 alone.
+
+#define PROBE_FREE(idx, lay) ((Obs2stamp[(lay)][idx] == Obs2epoch) ? \
+		(Obs2[(lay)][idx].flags & (PR_COST | PR_SOURCE)) : \
+		!(Obs[(lay)][idx] & ~BLOCKED_MASK))
+
+/*--------------------------------------------------------------*/
+/* Return TRUE if position (x, y) on layer "lay" can be routed.	*/
+/*--------------------------------------------------------------*/
+
+static u_char probe_free(int x, int y, int lay)
+{
+   return PROBE_FREE(OGRID(x, y, lay), lay) ? TRUE : FALSE;
+}
+
+/*--------------------------------------------------------------*/
+/* Return TRUE if a stack of vias at (x, y) from layer "l1" to	*/
+/* layer "l2" can be routed.					*/
+/*--------------------------------------------------------------*/
+
+static u_char probe_stack(int x, int y, int l1, int l2)
+{
+   int l, ld;
+
+   if (abs(l2 - l1) > StackedContacts) return FALSE;
+   ld = (l2 > l1) ? 1 : -1;
+   for (l = l1; l != l2; ) {
+      l += ld;
+      if (!probe_free(x, y, l)) return FALSE;
+   }
+   return TRUE;
+}
+
+/*--------------------------------------------------------------*/
+/* probe_shoot() ---						*/
+/*								*/
+/* Shoot a line on layer "lay" from (ox, oy) on layer "olay",	*/
+/* both ways along the preferred direction of the layer until	*/
+/* the track is blocked, and add it to "ps".  Nothing is added	*/
+/* if the via stack down to the line is blocked, or if a line	*/
+/* on the same track of the side already covers the point.	*/
+/*--------------------------------------------------------------*/
+
+static void probe_shoot(PROBESET *ps, int ox, int oy, int olay, int lay,
+		int parent)
+{
+   PROBE *p;
+   int i, x, y, idx, nidx, oidx;
+
+   if (ps->count >= PROBE_MAXLINES) return;
+   if (!probe_free(ox, oy, lay)) return;
+   if (!probe_stack(ox, oy, olay, lay)) return;
+
+   p = &ps->line[ps->count];
+   p->lay = lay;
+   p->horiz = ps->horiz[lay];
+   p->pos = (p->horiz) ? oy : ox;
+
+   for (i = 0; i < ps->count; i++) {
+      if ((ps->line[i].lay == lay) && (ps->line[i].horiz == p->horiz) &&
+		(ps->line[i].pos == p->pos)) {
+	 x = (p->horiz) ? ox : oy;
+	 if ((x >= ps->line[i].lo) && (x <= ps->line[i].hi)) return;
+      }
+   }
+
+   oidx = OGRID(ox, oy, lay);
+   if (p->horiz) {
+      idx = oidx;
+      for (x = ox; (x + 1 < NumChannelsX[lay]) && (x + 1 <= RouteArea.x2); x++) {
+	 if (Obs[lay][idx] & BLOCKED_E) break;
+	 nidx = OGRID_EAST(idx, x);
+	 if (!PROBE_FREE(nidx, lay)) break;
+	 idx = nidx;
+      }
+      p->hi = x;
+      idx = oidx;
+      for (x = ox; (x > 0) && (x - 1 >= RouteArea.x1); x--) {
+	 if (Obs[lay][idx] & BLOCKED_W) break;
+	 nidx = OGRID_WEST(idx, x);
+	 if (!PROBE_FREE(nidx, lay)) break;
+	 idx = nidx;
+      }
+      p->lo = x;
+   }
+   else {
+      idx = oidx;
+      for (y = oy; (y + 1 < NumChannelsY[lay]) && (y + 1 <= RouteArea.y2); y++) {
+	 if (Obs[lay][idx] & BLOCKED_N) break;
+	 nidx = OGRID_NORTH(idx, y);
+	 if (!PROBE_FREE(nidx, lay)) break;
+	 idx = nidx;
+      }
+      p->hi = y;
+      idx = oidx;
+      for (y = oy; (y > 0) && (y - 1 >= RouteArea.y1); y--) {
+	 if (Obs[lay][idx] & BLOCKED_S) break;
+	 nidx = OGRID_SOUTH(idx, y);
+	 if (!PROBE_FREE(nidx, lay)) break;
+	 idx = nidx;
+      }
+      p->lo = y;
+   }
+
+   p->ox = ox;
+   p->oy = oy;
+   p->olay = olay;
+   p->parent = parent;
+   ps->count++;
+}
+
+/*--------------------------------------------------------------*/
+/* Shoot the first lines of one side of the net, from each tap	*/
+/* marked with "flag" (PR_SOURCE or PR_TARGET) on every layer	*/
+/* it can reach by vias.					*/
+/*--------------------------------------------------------------*/
+
+static void probe_taps(NET net, PROBESET *ps, u_char flag)
+{
+   NODE node;
+   DPOINT tap;
+   int lay;
+
+   ps->count = 0;
+   for (lay = 0; lay < Num_layers; lay++)
+      ps->horiz[lay] = (LefGetRouteOrientation(lay) == 1) ? TRUE : FALSE;
+   for (node = net->netnodes; node; node = node->next) {
+      tap = (node->taps != NULL) ? node->taps : node->extend;
+      for (; tap; tap = tap->next) {
+	 if ((tap->gridx < RouteArea.x1) || (tap->gridx > RouteArea.x2) ||
+		(tap->gridy < RouteArea.y1) || (tap->gridy > RouteArea.y2))
+	    continue;
+	 if (!(OBS2(tap->gridx, tap->gridy, tap->layer)->flags & flag))
+	    continue;
+	 for (lay = 0; lay < Num_layers; lay++)
+	    probe_shoot(ps, tap->gridx, tap->gridy, tap->layer, lay, -1);
+      }
+   }
+}
+
+/*--------------------------------------------------------------*/
+/* Shoot lines across each of lines "first" to the end of the	*/
+/* set, from their ends and from the point nearest the other	*/
+/* side of the net, on the layers just above and below.	*/
+/*--------------------------------------------------------------*/
+
+static void probe_escape(PROBESET *ps, int first)
+{
+   PROBE *p;
+   int i, k, lay, last, near, x, y;
+   int esc[3];
+
+   last = ps->count;
+   for (i = first; i < last; i++) {
+      p = &ps->line[i];
+      near = (p->horiz) ? ps->gx : ps->gy;
+      if (near < p->lo) near = p->lo;
+      if (near > p->hi) near = p->hi;
+      esc[0] = near;
+      esc[1] = p->lo;
+      esc[2] = p->hi;
+
+      for (k = 0; k < 3; k++) {
+	 x = (p->horiz) ? esc[k] : p->pos;
+	 y = (p->horiz) ? p->pos : esc[k];
+	 if ((x == p->ox) && (y == p->oy)) continue;
+	 for (lay = p->lay - 1; lay <= p->lay + 1; lay += 2) {
+	    if ((lay < 0) || (lay >= Num_layers)) continue;
+	    if (ps->horiz[lay] == p->horiz) continue;
+	    probe_shoot(ps, x, y, p->lay, lay, i);
+	 }
+      }
+   }
+}
+
+/*--------------------------------------------------------------*/
+/* Find where lines "s" and "t" meet, if they do.		*/
+/*--------------------------------------------------------------*/
+
+static u_char probe_meet(PROBE *s, PROBE *t, int *x, int *y)
+{
+   PROBE *h, *v;
+   int lo, hi, a;
+
+   if (s->horiz != t->horiz) {
+      h = (s->horiz) ? s : t;
+      v = (s->horiz) ? t : s;
+      if ((v->pos < h->lo) || (v->pos > h->hi)) return FALSE;
+      if ((h->pos < v->lo) || (h->pos > v->hi)) return FALSE;
+      *x = v->pos;
+      *y = h->pos;
+      return probe_stack(*x, *y, s->lay, t->lay);
+   }
+
+   if ((s->lay != t->lay) || (s->pos != t->pos)) return FALSE;
+   lo = MAX(s->lo, t->lo);
+   hi = MIN(s->hi, t->hi);
+   if (lo > hi) return FALSE;
+
+   // Meet as close to the target side as possible
+
+   a = (t->horiz) ? t->ox : t->oy;
+   if (a < lo) a = lo;
+   if (a > hi) a = hi;
+   *x = (t->horiz) ? a : t->pos;
+   *y = (t->horiz) ? t->pos : a;
+   return TRUE;
+}
+
+/*--------------------------------------------------------------*/
+/* Waypoints from the tap of line "i" to its start on its	*/
+/* own layer.							*/
+/*--------------------------------------------------------------*/
+
+static void probe_way_in(PROBESET *ps, int i, GRIDP *way, int *nway)
+{
+   PROBE *p = &ps->line[i];
+
+   if (p->parent >= 0) probe_way_in(ps, p->parent, way, nway);
+   way[*nway].x = p->ox;
+   way[*nway].y = p->oy;
+   way[*nway].lay = p->olay;
+   (*nway)++;
+   way[*nway].x = p->ox;
+   way[*nway].y = p->oy;
+   way[*nway].lay = p->lay;
+   (*nway)++;
+}
+
+/*--------------------------------------------------------------*/
+/* Build the route from the source tap of line "s" along it to	*/
+/* (x, y), and back along target line "t" to its tap.  Return	*/
+/* the number of waypoints.					*/
+/*--------------------------------------------------------------*/
+
+static int probe_way(PROBESET *src, int s, PROBESET *tgt, int t,
+		int x, int y, GRIDP *way)
+{
+   PROBE *p;
+   int nway = 0;
+
+   probe_way_in(src, s, way, &nway);
+   way[nway].x = x;
+   way[nway].y = y;
+   way[nway].lay = src->line[s].lay;
+   nway++;
+
+   for (; t >= 0; t = p->parent) {
+      p = &tgt->line[t];
+      way[nway].x = x;
+      way[nway].y = y;
+      way[nway].lay = p->lay;
+      nway++;
+      way[nway].x = p->ox;
+      way[nway].y = p->oy;
+      way[nway].lay = p->lay;
+      nway++;
+      way[nway].x = p->ox;
+      way[nway].y = p->oy;
+      way[nway].lay = p->olay;
+      nway++;
+      x = p->ox;
+      y = p->oy;
+   }
+   return nway;
+}
+
+/*--------------------------------------------------------------*/
+/* Lower bound on the cost of the route "way", ignoring any	*/
+/* source positions it may cross.				*/
+/*--------------------------------------------------------------*/
+
+static int probe_bound(GRIDP *way, int nway)
+{
+   int i, len, vias;
+
+   len = vias = 0;
+   for (i = 1; i < nway; i++) {
+      len += abs(way[i].x - way[i - 1].x) + abs(way[i].y - way[i - 1].y);
+      vias += abs(way[i].lay - way[i - 1].lay);
+   }
+   return len * MIN(SegCost, JogCost) + vias * ViaCost;
+}
+
+/*--------------------------------------------------------------*/
+/* probe_route() ---						*/
+/*								*/
+/* Route the current leg of "net" by line probes.  Obs2[] must	*/
+/* be set up for the search, with the source and target		*/
+/* positions marked.						*/
+/*								*/
+/* RETURNS: 1 if a route of cost "maxcost" or less was found,	*/
+/*	    in which case it has been written into Obs2[] and	*/
+/*	    its target position is left in "best";  0 if not.	*/
+/*--------------------------------------------------------------*/
+
+int probe_route(NET net, GRIDP *best, int maxcost)
+{
+   PROBESET *src, *tgt;
+   GRIDP way[PROBE_MAXWAY], bestway[PROBE_MAXWAY], end;
+   int s, t, snew, tnew, level;
+   int x, y, nway, nbest, cost, bestcost;
+   u_char met;
+
+   src = (PROBESET *)malloc(2 * sizeof(PROBESET));
+   tgt = src + 1;
+
+   probe_taps(net, src, PR_SOURCE);
+   probe_taps(net, tgt, PR_TARGET);
+   nbest = 0;
+   if ((src->count == 0) || (tgt->count == 0)) goto done;
+
+   src->gx = tgt->line[0].ox;
+   src->gy = tgt->line[0].oy;
+   tgt->gx = src->line[0].ox;
+   tgt->gy = src->line[0].oy;
+
+   bestcost = maxcost + 1;
+   snew = tnew = 0;
+
+   for (level = 0; ; level++) {
+
+      // Pair each new line with every line of the other side.  Lines
+      // shot from lines that already meet only make longer routes.
+
+      met = FALSE;
+      for (s = 0; s < src->count; s++) {
+	 for (t = (s < snew) ? tnew : 0; t < tgt->count; t++) {
+	    if (!probe_meet(&src->line[s], &tgt->line[t], &x, &y)) continue;
+	    met = TRUE;
+	    nway = probe_way(src, s, tgt, t, x, y, way);
+	    if (probe_bound(way, nway) >= bestcost) continue;
+	    cost = pattern_walk(way, nway, FALSE, &end);
+	    if ((cost >= 0) && (cost < bestcost)) {
+	       bestcost = cost;
+	       memcpy(bestway, way, nway * sizeof(GRIDP));
+	       nbest = nway;
+	    }
+	 }
+      }
+      if (met || (level >= PROBE_LEVELS)) break;
+
+      s = src->count;
+      t = tgt->count;
+      probe_escape(src, snew);
+      probe_escape(tgt, tnew);
+      snew = s;
+      tnew = t;
+      if ((src->count == snew) && (tgt->count == tnew)) break;
+   }
+
+   if (nbest > 0) pattern_walk(bestway, nbest, TRUE, best);
+
+done:
+   free(src);
+   return (nbest > 0) ? 1 : 0;
+}
+
+/* end of probe.c */
@@ -0,0 +1,12 @@
+/*--------------------------------------------------------------*/
+/* probe.h -- line-probe (Hightower) router			*/
+/*--------------------------------------------------------------*/
+
+#ifndef PROBE_H
+
+int	probe_route(NET net, GRIDP *best, int maxcost);
+
+#define PROBE_H
+#endif
+
+/* end of probe.h */
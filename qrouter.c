@@ -11,21 +11,35 @@
 #include <stdlib.h>
 #include <string.h>
 #include <getopt.h>
+#include <pthread.h>
 
 #include "qrouter.h"
 #include "config.h"
 #include "node.h"
 #include "maze.h"
 #include "lef.h"
+#include "glroute.h"
+#include "pattern.h"
+#include "probe.h"
+#include "order.h"
+#include "grid.h"
 
 int  Pathon = -1;
 int  TotalRoutes = 0;
+int  PatternRoutes = 0;		// Routes found by each engine
+int  ProbeRoutes = 0;
+int  SearchRoutes = 0;
 
 FILE *Failfptr = NULL;
 FILE *CNfptr = NULL;
+THREAD_LOCAL FILE *Outfptr = NULL;	// see RTOUT and route_worker()
+THREAD_LOCAL FILE *Errfptr = NULL;
+static pthread_mutex_t Outlock = PTHREAD_MUTEX_INITIALIZER;
 
 NET     Nlnets;		// list of nets in the design
-NET	CurNet;		// current net to route, used by 2nd stage
+NET    *Nettab;		// nets by net number (see create_nettab())
+NET    *Netorder;	// nets to route, by order (see create_netorder())
+THREAD_LOCAL NET CurNet;	// current net to route, used by 2nd stage
 STRING  DontRoute;      // a list of nets not to route (e.g., power)
 STRING  CriticalNet;    // list of critical nets to route first
 GATE    GateInfo;       // standard cell macro information
@@ -36,10 +50,37 @@ NETLIST Abandoned;	// list of nets that will never route
 u_char *Mask[MAX_LAYERS];    // mask out best area to route, expand as needed
 u_int  *Obs[MAX_LAYERS];     // net obstructions in layer
 PROUTE *Obs2[MAX_LAYERS];    // used for pt->pt routes on layer
-float  *Stub[MAX_LAYERS];    // used for stub routing to pins
-float  *Obsinfo[MAX_LAYERS]; // temporary array used for detailed obstruction info
-NODE   *Nodeloc[MAX_LAYERS]; // nodes are here. . .
-NODE   *Nodesav[MAX_LAYERS]; // . . . and here (but not to be altered)
+u_int  *Obs2stamp[MAX_LAYERS]; // route generation of each Obs2 entry
+THREAD_LOCAL u_int Obs2epoch = 0; // current route generation
+THREAD_LOCAL int Obs2net = 0;	     // net number of the current route
+u_int  Obs2generation = 0;   // last route generation handed out
+
+// Limits of the route search (grid positions), which confine each
+// net routed in parallel to an area no other thread is routing in.
+THREAD_LOCAL struct seg_ RouteArea = {NULL, 0, 0, 0, MAXRT, MAXRT, 0};
+THREAD_LOCAL u_char RouteParallel = FALSE;
+
+// Search kept from one leg of a multi-node net to the next (see
+// route_segs()).  RouteReuse is set while such a search is running.
+THREAD_LOCAL u_char RouteReuse = FALSE;
+
+// Set while positions already expanded may yet be reached at lower
+// cost, and so must be expanded again:  when the search carries on
+// from the last leg, or after the route mask has been widened.
+THREAD_LOCAL u_char RouteReopen = FALSE;
+static THREAD_LOCAL NET ReuseNet = NULL;
+static THREAD_LOCAL u_char ReuseStage;
+static THREAD_LOCAL u_int ReuseEpoch;
+static THREAD_LOCAL int ReuseMaxcost;
+static THREAD_LOCAL PQUEUE ReuseFrontier;
+u_short *Hist[MAX_LAYERS];   // collision history, for negotiated congestion
+u_int   *Runs[MAX_LAYERS];   // free track runs, for jumps in the search
+int    PresFactor = 1;	     // present collision cost is ConflictCost times this
+SPARSEGRID Stub;	     // used for stub routing to pins
+SPARSEGRID Obsinfo;	     // temporary array used for detailed obstruction info
+u_int  *Nodeid[MAX_LAYERS];  // nodes are here, by number . . .
+NODE   *Nodetab;	     // . . . in this table
+u_char *Crossing[MAX_LAYERS]; // nodes above or below, for the step cost
 DSEG   UserObs;		     // user-defined obstruction layers
 
 u_char needblockX[MAX_LAYERS];
@@ -52,6 +93,7 @@ int   Numnets = 0;
 int   Numgates = 0;
 int   Numpins = 0;
 int   Verbose = 0;
+int   NumThreads = 1;
 int   keepTrying = 0;
 int   forceRoutable = 0;
 
@@ -121,13 +163,12 @@ int allocate_obs_array()
 
    if (Obs[0] != NULL) return;	/* Already been called */
 
-   for (i = 0; i < Num_layers; i++) {
-      Obs[i] = (u_int *)calloc(NumChannelsX[i] * NumChannelsY[i],
-			sizeof(u_int));
-      if (!Obs[i]) {
-	 fprintf(stderr, "Out of memory 4.\n");
-	 return(4);
-      }
+   // Obs is the first of the grid arrays, so set up their layout
+   grid_init();
+
+   if (grid_alloc((void **)Obs, sizeof(u_int), "Obs") != 0) {
+      fprintf(stderr, "Out of memory 4.\n");
+      return(4);
    }
    return 0;
 }
@@ -174,13 +215,14 @@ main(int argc, char *argv[])
    char Filename[256];
    double oscale, sreq;
    int iscale = 1;
+   int order = -1;
 
    NET net;
     
    Filename[0] = 0;
    DEFfilename[0] = 0;
 
-   while ((i = getopt(argc, argv, "c:i:hkfv:p:g:r:")) != -1) {
+   while ((i = getopt(argc, argv, "c:i:hkfv:p:g:r:j:o:")) != -1) {
       switch (i) {
 	 case 'c':
 	    configfile = strdup(optarg);
@@ -214,6 +256,18 @@ main(int argc, char *argv[])
 	 case 'k':
 	    keepTrying = 1;
 	    break;
+	 case 'j':
+	    if ((sscanf(optarg, "%d", &NumThreads) != 1) || (NumThreads < 1)) {
+		fprintf(stderr, "Bad number of threads \"%s\", "
+			"positive integer expected.\n", optarg);
+		NumThreads = 1;
+	    }
+	    break;
+	 case 'o':
+	    if ((order = netorder_lookup(optarg)) < 0)
+		fprintf(stderr, "Bad net order \"%s\", expected fanout, "
+			"area, hpwl, density or critical.\n", optarg);
+	    break;
 	 default:
 	    fprintf(stderr, "bad switch %d\n", i);
       }
@@ -238,6 +292,11 @@ main(int argc, char *argv[])
    }
    if (configfile != configdefault) free(configfile);
 
+   // The net order given on the command line overrides the one
+   // in the configuration file
+
+   if (order >= 0) NetOrder = (u_char)order;
+
    if (infofile != NULL) {
       FILE *infoFILEptr;
 
@@ -281,56 +340,43 @@ main(int argc, char *argv[])
 
    oscale = (double)((float)iscale * DefRead(DEFfilename));
 
+   // The route rules of the layers are all known now, so look them
+   // up once instead of on every call (see LefFreezeRules())
+
+   LefFreezeRules();
+
+   create_nettab();
    create_netorder();
 
    set_num_channels();		// If not called from DefRead()
    allocate_obs_array();	// If not called from DefRead()
 
-   for (i = 0; i < Num_layers; i++) {
+   if (grid_alloc((void **)Mask, sizeof(u_char), "Mask") != 0) {
+      fprintf(stderr, "Out of memory 3.\n");
+      exit(3);
+   }
 
-      /*
-      Mask[i] = (u_char *)calloc(NumChannelsX[i] * NumChannelsY[i],
-			sizeof(u_char));
-      if (!Mask[i]) {
-	 fprintf(stderr, "Out of memory 3.\n");
-	 exit(3);
-      }
-      */
+   // Obsinfo and Stub are sparse, and grow as entries are set
 
-      Obsinfo[i] = (float *)calloc(NumChannelsX[i] * NumChannelsY[i],
-			sizeof(float));
-      if (!Obsinfo[i]) {
-	 fprintf(stderr, "Out of memory 5.\n");
-	 exit(5);
-      }
+   // Nodeid is the reverse lookup table for nodes
 
-      Stub[i] = (float *)calloc(NumChannelsX[i] * NumChannelsY[i],
-			sizeof(float));
-      if (!Stub[i]) {
-	 fprintf( stderr, "Out of memory 6.\n");
-	 exit(6);
-      }
-
-      // Nodeloc is the reverse lookup table for nodes
+   if (grid_alloc((void **)Nodeid, sizeof(u_int), "Nodeid") != 0) {
+      fprintf(stderr, "Out of memory 7.\n");
+      exit(7);
+   }
 
-      Nodeloc[i] = (NODE *)calloc(NumChannelsX[i] * NumChannelsY[i],
-		sizeof(NODE));
-      if (!Nodeloc[i]) {
-         fprintf(stderr, "Out of memory 7.\n");
-         exit(7);
-      }
+   // Crossing flags the positions where crossing a node may cost extra,
+   // kept up by set_nodeloc() (see step_cost())
 
-      Nodesav[i] = (NODE *)calloc(NumChannelsX[i] * NumChannelsY[i],
-		sizeof(NODE));
-      if (!Nodesav[i]) {
-         fprintf(stderr, "Out of memory 8.\n");
-         exit(8);
-      }
+   if (grid_alloc((void **)Crossing, sizeof(u_char), "Crossing") != 0) {
+      fprintf(stderr, "Out of memory 14.\n");
+      exit(14);
    }
+   create_nodetab();
    fflush(stdout);
 
-   fprintf(stderr, "Diagnostic: memory block is %d bytes\n",
-		sizeof(u_int) * NumChannelsX[0] * NumChannelsY[0]);
+   fprintf(stderr, "Diagnostic: route grid arrays use %lu bytes\n",
+		(unsigned long)grid_memory());
 
    /* Be sure to create obstructions from gates first, since we don't	*/
    /* want improperly defined or positioned obstruction layers to over-	*/
@@ -342,21 +388,52 @@ main(int argc, char *argv[])
    create_obstructions_from_variable_pitch();
    adjust_stub_lengths();
    find_route_blocks();
+   find_node_extents();
 
    // Remove the Obsinfo array, which is no longer needed, and allocate
    // the Obs2 array for costing information
 
-   for (i = 0; i < Num_layers; i++) free(Obsinfo[i]);
+   sgrid_free(&Obsinfo);
 
-   for (i = 0; i < Num_layers; i++) {
-      Obs2[i] = (PROUTE *)calloc(NumChannelsX[i] * NumChannelsY[i],
-			sizeof(PROUTE));
-      if (!Obs2[i]) {
-         fprintf( stderr, "Out of memory 9.\n");
-         exit(9);
+   if (grid_alloc((void **)Obs2, sizeof(PROUTE), "Obs2") != 0) {
+      fprintf( stderr, "Out of memory 9.\n");
+      exit(9);
+   }
+
+   // Obs2 entries are filled in from Obs on demand;  the stamp
+   // records which route last did so (see init_proute()).
+
+   if (grid_alloc((void **)Obs2stamp, sizeof(u_int), "Obs2stamp") != 0) {
+      fprintf( stderr, "Out of memory 10.\n");
+      exit(10);
+   }
+
+   // The collision history is kept only for negotiated congestion;
+   // step_cost() skips it while Hist[0] is NULL.
+
+   if (Negotiate > 0) {
+      if (grid_alloc((void **)Hist, sizeof(u_short), "Hist") != 0) {
+         fprintf( stderr, "Out of memory 11.\n");
+         exit(11);
+      }
+   }
+
+   // Free track runs are found once, from the obstructions and pins
+   // alone;  the search checks each position of a jump for routes.
+
+   if (SearchJump) {
+      if (grid_alloc((void **)Runs, sizeof(u_int), "Runs") != 0) {
+         fprintf( stderr, "Out of memory 13.\n");
+         exit(13);
       }
+      find_track_runs();
    }
 
+   // The costs and layer directions are all known now, so the cost
+   // of a step on each layer can be worked out once for the search.
+
+   set_step_costs();
+
    // Fill in needblockX and needblockY, which are used by commit_proute
    // when route layers are too large for the grid size, and grid points
    // around a route need to be marked as blocked whenever something is
@@ -376,14 +453,22 @@ main(int argc, char *argv[])
    fprintf(stderr, "Numnets = %d, Numpins = %d\n",
 	     Numnets - MIN_NET_NUMBER, Numpins );
 
+   // Plan all routes on a coarse grid, to guide the detail router
+
+   if (GlobalTile > 0) global_route();
+
    // print_nlgates( "net.details" );
    // print_nodes( "nodes.details" );
    // print_nlnets( "netlist.out" );
 
-   for (i = 0; i < Numnets; i++) {
-      net = getnettoroute(i);
-      if ((net != NULL) && (net->netnodes != NULL))
-	 doroute(net, (u_char)0);
+   if (NumThreads > 1)
+      route_parallel();
+   else {
+      for (i = 0; i < Numnets; i++) {
+         net = getnettoroute(i);
+         if ((net != NULL) && (net->netnodes != NULL))
+	    doroute(net, (u_char)0);
+      }
    }
 
    fflush(stdout);
@@ -400,13 +485,18 @@ main(int argc, char *argv[])
    }
    fprintf(stdout, "----------------------------------------------\n");
 
+   if (Negotiate > 0) donegotiate();
    dosecondstage();
+   if (GlobalTile > 0) gcell_free();
 
    // Finish up by writing the routes to an annotated DEF file
     
    emit_routes(DEFfilename, oscale, iscale);
 
    fprintf(stdout, "----------------------------------------------\n");
+   if ((PatternRoute > 0) || (ProbeRoute > 0))
+      fprintf(stdout, "Routes found by pattern: %d, line probe: %d, search: %d\n",
+		PatternRoutes, ProbeRoutes, SearchRoutes);
    fprintf(stdout, "Final: ");
    if (FailedNets == (NETLIST)NULL && Abandoned == (NETLIST)NULL)
       fprintf(stdout, "No failed routes!\n");
@@ -702,25 +792,15 @@ void print_nlgates( char *filename )
 
 NET getnettoroute(int order)
 {
-  NET net;
-  
   fflush(stdout);
   fflush(stderr);
 
-  for (net = Nlnets; net; net = net->next) {
-     if (net->netorder == order) {
-	if (net->numnodes >= 2) {
-	   return net;
-        }
-	// Qrouter will route power and ground nets even if the
-	// standard cell power and ground pins are not listed in
-	// the nets section.  Because of this, it is okay to have
-	// only one node.
-	else if (net->numnodes == 1 && (net->netnum == VDD_NET ||
-		net->netnum == GND_NET))
-	   return net;
-     }
-  }
+  // Netorder[] holds only the nets that can be routed (see
+  // create_netorder())
+
+  if ((order >= 0) && (order <= Numnets) && (Netorder[order] != NULL))
+     return Netorder[order];
+
   if (Verbose > 0) {
      fprintf(stderr, "getnettoroute():  Fell through\n");
   }
@@ -728,6 +808,55 @@ NET getnettoroute(int order)
 
 } /* getnettoroute() */
 
+/*--------------------------------------------------------------*/
+/* route_colliding() ---					*/
+/*								*/
+/* Route "net" allowing collisions (stage = 1), except with the	*/
+/* nets on its "noripup" list.  If that fails, the list is	*/
+/* cleared and the net tried once more;  the net is then	*/
+/* flagged NET_PENDING, so that this is done only once.		*/
+/* Returns the result of doroute().				*/
+/*--------------------------------------------------------------*/
+
+static int route_colliding(NET net)
+{
+   NETLIST nl;
+   int result;
+
+   result = doroute(net, (u_char)1);
+   if ((result != 0) && (net->noripup != NULL) &&
+		((net->flags & NET_PENDING) == 0)) {
+      // Clear this net's "noripup" list and try again.
+
+      while (net->noripup) {
+	 nl = net->noripup->next;
+	 free(net->noripup);
+	 net->noripup = nl;
+      }
+      result = doroute(net, (u_char)1);
+      net->flags |= NET_PENDING;	// Next time we abandon it.
+   }
+   return result;
+}
+
+/*--------------------------------------------------------------*/
+/* add_noripup() ---						*/
+/*								*/
+/* Add "ripped" to the "noripup" list of "net", so that "net"	*/
+/* will not route over it again.  Avoids infinite looping in	*/
+/* the rip-up and reroute stages.				*/
+/*--------------------------------------------------------------*/
+
+static void add_noripup(NET net, NET ripped)
+{
+   NETLIST fn;
+
+   fn = (NETLIST)malloc(sizeof(struct netlist_));
+   fn->next = net->noripup;
+   net->noripup = fn;
+   fn->net = ripped;
+}
+
 /*--------------------------------------------------------------*/
 /* dosecondstage() ---						*/
 /*								*/
@@ -778,22 +907,7 @@ dosecondstage()
       if (result != 0) {
 	 fflush(stdout);
 	 fprintf(stderr, "Routing net %s with collisions\n", net->netname);
-         result = doroute(net, (u_char)1);
-         if (result != 0) {
-	    if (net->noripup != NULL) {
-	       if ((net->flags & NET_PENDING) == 0) {
-	          // Clear this net's "noripup" list and try again.
-
-	          while (net->noripup) {
-	             nl = net->noripup->next;
-	             free(net->noripup);
-	             net->noripup = nl;
-	          }
-	          result = doroute(net, (u_char)1);
-		  net->flags |= NET_PENDING;	// Next time we abandon it.
-	       }
-	    }
-	 }
+         result = route_colliding(net);
          if (result != 0) {
 	    // Complete failure to route, even allowing collisions.
 	    // Abandon routing this net.
@@ -837,13 +951,9 @@ dosecondstage()
 	       FailedNets = nl;
 
 	    // Add nl->net to "noripup" list for this net, so it won't be
-	    // routed over again by the net.  Avoids infinite looping in
-	    // the second stage.
+	    // routed over again by the net.
 
-	    fn = (NETLIST)malloc(sizeof(struct net_));
-	    fn->next = net->noripup;
-	    net->noripup = fn;
-	    fn->net = nl->net;
+	    add_noripup(net, nl->net);
 	 }
 
 	 nl->next = (NETLIST)NULL;
@@ -873,6 +983,170 @@ dosecondstage()
    }
 }
 
+/*--------------------------------------------------------------*/
+/* donegotiate() ---						*/
+/*								*/
+/* Negotiated congestion alternative to dosecondstage().	*/
+/* Method:							*/
+/* 1) Take all failing nets as one pass.			*/
+/* 2) Route each with stage = 1, where a collision costs	*/
+/*    ConflictCost times PresFactor, and every position also	*/
+/*    costs HistCost per collision ever recorded there.		*/
+/* 3) Record the collisions in Hist, rip up the colliding	*/
+/*    nets and queue them for the next pass.			*/
+/* 4) Raise PresFactor and repeat until no net fails, or for	*/
+/*    at most Negotiate passes.  Whatever is left over goes	*/
+/*    to dosecondstage().					*/
+/*--------------------------------------------------------------*/
+
+void
+donegotiate()
+{
+   int pass, failcount, ripcount, result;
+   NET net;
+   NETLIST pending, nl, nl2, fn;
+
+   for (pass = 1; (pass <= Negotiate) && (FailedNets != NULL); pass++) {
+
+      pending = FailedNets;
+      FailedNets = (NETLIST)NULL;
+      failcount = countlist(pending);
+      ripcount = 0;
+
+      fprintf(stdout, "------------------------------\n");
+      fprintf(stdout, "Negotiation pass %d: %d nets, collision cost %d\n",
+		pass, failcount, ConflictCost * PresFactor);
+      fprintf(stdout, "------------------------------\n");
+
+      while (pending != NULL) {
+	 net = pending->net;
+	 nl2 = pending;
+	 pending = pending->next;
+	 free(nl2);
+
+	 // Route as much as possible without collisions, then finish
+	 // allowing them, but not with nets this net has already ripped
+	 // up (see route_colliding()).  A failing doroute() puts the net
+	 // back on FailedNets, which is sorted out below.
+
+	 result = doroute(net, (u_char)0);
+	 if (result != 0) result = route_colliding(net);
+
+	 while (FailedNets && (FailedNets->net == net)) {
+	    nl = FailedNets->next;
+	    free(FailedNets);
+	    FailedNets = nl;
+	 }
+
+	 if (result != 0) {
+	    fflush(stdout);
+	    fprintf(stderr, "Complete failure on net %s:  Abandoning.\n",
+			net->netname);
+	    nl = (NETLIST)malloc(sizeof(struct netlist_));
+	    nl->net = net;
+	    nl->next = Abandoned;
+	    Abandoned = nl;
+	    continue;
+	 }
+
+	 // Collisions are charged to history and the colliding nets
+	 // are rerouted on the next pass, when colliding costs more.
+	 // As in dosecondstage(), a net does not rip up the same net
+	 // twice, to keep two nets from ripping each other up in turn.
+
+	 nl = find_colliding(net);
+	 while (nl) {
+	    nl2 = nl->next;
+	    if (ripup_net(nl->net, (u_char)1) == TRUE) {
+	       for (fn = FailedNets; fn && fn->next != NULL; fn = fn->next);
+	       if (fn)
+		  fn->next = nl;
+	       else
+		  FailedNets = nl;
+	       nl->next = (NETLIST)NULL;
+	       add_noripup(net, nl->net);
+	       ripcount++;
+	    }
+	    else
+	       free(nl);
+	    nl = nl2;
+	 }
+	 writeback_all_routes(net);
+      }
+
+      fprintf(stdout, "Negotiation pass %d: %d nets ripped up\n", pass,
+		ripcount);
+
+      if (PresFactor < 256) PresFactor <<= 1;
+   }
+
+   if (FailedNets != NULL)
+      fprintf(stdout, "Negotiation left %d nets for rip-up and reroute\n",
+		countlist(FailedNets));
+   PresFactor = 1;
+}
+
+/*--------------------------------------------------------------*/
+/* Grid positions currently set in Mask[], so that the mask can	*/
+/* be cleared and widened without sweeping the whole grid.	*/
+/* Positions from MaskRing onward are the outermost ring, from	*/
+/* which expandMask() grows the mask.				*/
+/*--------------------------------------------------------------*/
+
+static THREAD_LOCAL GRIDP *MaskCells = NULL;
+static THREAD_LOCAL int NumMaskCells = 0;
+static THREAD_LOCAL int MaxMaskCells = 0;
+static THREAD_LOCAL int MaskRing = 0;
+
+/*--------------------------------------------------------------*/
+/* addMask() ---						*/
+/*								*/
+/* Add grid position (x, y, l) to the mask.  Positions off the	*/
+/* grid or outside of RouteArea, or already in the mask, are	*/
+/* ignored.							*/
+/*--------------------------------------------------------------*/
+
+static void addMask(int x, int y, int l)
+{
+  if (x < 0 || x >= NumChannelsX[l]) return;
+  if (y < 0 || y >= NumChannelsY[l]) return;
+  if (x < RouteArea.x1 || x > RouteArea.x2) return;
+  if (y < RouteArea.y1 || y > RouteArea.y2) return;
+  if (Mask[l][OGRID(x, y, l)] != (u_char)0) return;
+
+  Mask[l][OGRID(x, y, l)] = (u_char)1;
+
+  if (NumMaskCells == MaxMaskCells) {
+     MaxMaskCells = (MaxMaskCells == 0) ? 1024 : (MaxMaskCells << 1);
+     MaskCells = (GRIDP *)realloc(MaskCells, MaxMaskCells * sizeof(GRIDP));
+  }
+  MaskCells[NumMaskCells].x = x;
+  MaskCells[NumMaskCells].y = y;
+  MaskCells[NumMaskCells].lay = l;
+  NumMaskCells++;
+}
+
+/*--------------------------------------------------------------*/
+/* addMaskRect() ---						*/
+/*								*/
+/* Add the rectangle (x1, y1) to (x2, y2) on layer l to the	*/
+/* mask, clipped to the grid.					*/
+/*--------------------------------------------------------------*/
+
+static void addMaskRect(int x1, int y1, int x2, int y2, int l)
+{
+  int i, j;
+
+  if (x1 < 0) x1 = 0;
+  if (y1 < 0) y1 = 0;
+  if (x2 >= NumChannelsX[l]) x2 = NumChannelsX[l] - 1;
+  if (y2 >= NumChannelsY[l]) y2 = NumChannelsY[l] - 1;
+
+  for (i = x1; i <= x2; i++)
+     for (j = y1; j <= y2; j++)
+	addMask(i, j, l);
+}
+
 /*--------------------------------------------------------------*/
 /* createMask() ---						*/
 /*								*/
@@ -887,13 +1161,39 @@ dosecondstage()
 void createMask(NET net)
 {
   NODE n1, n2;
-  int i, j, o, l;
+  int i, o, l;
   DPOINT dtap, d1tap, d2tap, mintap;
   int dx, dy, dist, mindist;
   int x1, x2, y1, y2;
   int xcent, ycent, xmin, ymin, xmax, ymax;
 
-  fillMask(0);
+  // Clear the mask left by the previous route
+  for (i = 0; i < NumMaskCells; i++)
+     Mask[MaskCells[i].lay][OGRID(MaskCells[i].x, MaskCells[i].y,
+		MaskCells[i].lay)] = (u_char)0;
+  NumMaskCells = 0;
+  MaskRing = 0;
+
+  // Allow routes at all tap and extension points
+  for (n1 = net->netnodes; n1 != NULL; n1 = n1->next) {
+     for (dtap = n1->taps; dtap != NULL; dtap = dtap->next)
+	addMask(dtap->gridx, dtap->gridy, dtap->layer);
+     for (dtap = n1->extend; dtap != NULL; dtap = dtap->next)
+	addMask(dtap->gridx, dtap->gridy, dtap->layer);
+  }
+
+  // If the net has a global route, the mask covers its gcells
+
+  if (net->guide != NULL) {
+     for (i = 0; i < net->numguide; i++) {
+	for (l = 0; l < Num_layers; l++) {
+	   gcell_bounds(net->guide[i], l, &x1, &y1, &x2, &y2);
+	   addMaskRect(x1, y1, x2, y2, l);
+	}
+     }
+     fprintf(RTOUT, "Global route mask has %d gcells\n", net->numguide);
+     return;
+  }
 
   if (net->numnodes == 2) { 
 
@@ -904,8 +1204,10 @@ void createMask(NET net)
      // Simple 2-pass---pick up first tap on n1, find closest tap on n2,
      // then find closest tap on n1.
      d1tap = (n1->taps == NULL) ? n1->extend : n1->taps;
-     for (d2tap = (n2->taps == NULL) ? n2->extend : n2->taps; d2tap != NULL;
-		d2tap = d2tap->next) {
+     mintap = (n2->taps == NULL) ? n2->extend : n2->taps;
+     if (d1tap == NULL || mintap == NULL) return;
+
+     for (d2tap = mintap; d2tap != NULL; d2tap = d2tap->next) {
 	dx = d2tap->gridx - d1tap->gridx;
 	dy = d2tap->gridy - d1tap->gridy;
 	dist = dx * dx + dy * dy;
@@ -937,42 +1239,22 @@ void createMask(NET net)
 
      l = (d1tap->layer < d2tap->layer) ? d1tap->layer : d2tap->layer;
 
-     // Place a track on every tap and extend position
-     for (d1tap = n1->taps; d1tap != NULL; d1tap = d1tap->next)
-	Mask[d1tap->layer][OGRID(d1tap->x, d1tap->y, d1tap->layer)] = (u_char)1;
-     for (d1tap = n1->extend; d1tap != NULL; d1tap = d1tap->next)
-	Mask[d1tap->layer][OGRID(d1tap->x, d1tap->y, d1tap->layer)] = (u_char)1;
-     for (d2tap = n2->taps; d2tap != NULL; d2tap = d2tap->next)
-	Mask[d2tap->layer][OGRID(d2tap->x, d2tap->y, d2tap->layer)] = (u_char)1;
-     for (d2tap = n2->extend; d2tap != NULL; d2tap = d2tap->next)
-	Mask[d2tap->layer][OGRID(d2tap->x, d2tap->y, d2tap->layer)] = (u_char)1;
-
      // Find the orientation of the lowest tap layer.  Lay alternate vertical
      // and horizontal tracks according to track orientation.
 
      for (; l < Num_layers; l++) {
         o = LefGetRouteOrientation(l);
 	if (!o) {
-           for (i = x1 - 1; i <= x1 + 1; i++)
-	      for (j = y1 - 1; j <= y2 + 1; j++)	// Left vertical route
-	         Mask[l][OGRID(i, j, l)] = (u_char)1;
-
-           for (i = x2 - 1; i <= x2 + 1; i++)
-	      for (j = y1 - 1; j <= y2 + 1; j++)	// Right vertical route
-	         Mask[l][OGRID(i, j, l)] = (u_char)1;
+	   addMaskRect(x1 - 1, y1 - 1, x1 + 1, y2 + 1, l);  // Left vertical route
+	   addMaskRect(x2 - 1, y1 - 1, x2 + 1, y2 + 1, l);  // Right vertical route
 	}
 	else {
-           for (i = x1 - 1; i <= x2 + 1; i++)
-	      for (j = y1 - 1; j <= y1 + 1; j++)	// Bottom horizontal route
-	         Mask[l][OGRID(i, j, l)] = (u_char)1;
-
-           for (i = x1 - 1; i <= x2 + 1; i++)
-	      for (j = y2 - 1; j <= y2 + 1; j++)	// Top horizontal route
-	         Mask[l][OGRID(i, j, l)] = (u_char)1;
+	   addMaskRect(x1 - 1, y1 - 1, x2 + 1, y1 + 1, l);  // Bottom horizontal route
+	   addMaskRect(x1 - 1, y2 - 1, x2 + 1, y2 + 1, l);  // Top horizontal route
 	}
      }
 
-     fprintf(stdout, "2-port mask edges rectangle (%d %d) to (%d %d)\n",
+     fprintf(RTOUT, "2-port mask edges rectangle (%d %d) to (%d %d)\n",
 		x1, y1, x2, y2);
   }
   else {
@@ -984,6 +1266,7 @@ void createMask(NET net)
      xmin = ymin = MAXRT;
      for (n1 = net->netnodes; n1 != NULL; n1 = n1->next) {
 	dtap = (n1->taps == NULL) ? n1->extend : n1->taps;
+	if (dtap == NULL) continue;
 	xcent += dtap->gridx;
 	ycent += dtap->gridy;
 	if (dtap->gridx > xmax) xmax = dtap->gridx;
@@ -991,6 +1274,7 @@ void createMask(NET net)
 	if (dtap->gridy > ymax) ymax = dtap->gridy;
 	if (dtap->gridy < ymin) ymin = dtap->gridy;
      }
+     if (xmax < xmin) return;
      xcent /= net->numnodes;
      ycent /= net->numnodes;
 
@@ -1004,102 +1288,298 @@ void createMask(NET net)
 	xmin = xmax = xcent;
      }
 
-     // Allow routes at all tap and extension points
-     for (n1 = net->netnodes; n1 != NULL; n1 = n1->next) {
-        for (dtap = n1->taps; dtap != NULL; dtap = dtap->next)
-	   Mask[dtap->layer][OGRID(dtap->gridx, dtap->gridy, dtap->layer)] = (u_char)1;
-        for (dtap = n1->extend; dtap != NULL; dtap = dtap->next)
-	   Mask[dtap->layer][OGRID(dtap->gridx, dtap->gridy, dtap->layer)] = (u_char)1;
-     }
-
      for (l = 0; l < Num_layers; l++) {
 	// If the layer orientation is the same as the trunk, place mask around
 	// trunk line.
 	if (o == LefGetRouteOrientation(l)) {
-           for (i = xmin - 1; i <= xmax + 1; i++)
-	      for (j = ymin - 1; j <= ymax + 1; j++)
-	         Mask[l][OGRID(i, j, l)] = (u_char)1;
+	   addMaskRect(xmin - 1, ymin - 1, xmax + 1, ymax + 1, l);
 	}
 	else {
            for (n1 = net->netnodes; n1 != NULL; n1 = n1->next) {
 	      dtap = (n1->taps == NULL) ? n1->extend : n1->taps;
+	      if (dtap == NULL) continue;
 	      if (o == 1) {	// Horizontal trunk, vertical branches
-                 for (i = dtap->gridx - 1; i <= dtap->gridx + 1; i++) {
-	            for (j = dtap->gridy - 1; j <= ycent + 1; j++)
-	               Mask[l][OGRID(i, j, l)] = (u_char)1;
-	            for (j = ycent - 1; j <= dtap->gridy + 1; j++)
-	               Mask[l][OGRID(i, j, l)] = (u_char)1;
-	         }
+		 addMaskRect(dtap->gridx - 1, MIN(dtap->gridy, ycent) - 1,
+			dtap->gridx + 1, MAX(dtap->gridy, ycent) + 1, l);
 	      } 
 	      else {		// Vertical trunk, horizontal branches
-                 for (j = dtap->gridy - 1; j <= dtap->gridy + 1; j++) {
-	            for (i = dtap->gridx - 1; i <= xcent + 1; i++)
-	               Mask[l][OGRID(i, j, l)] = (u_char)1;
-	            for (i = xcent - 1; i <= dtap->gridx + 1; i++)
-	               Mask[l][OGRID(i, j, l)] = (u_char)1;
-		 }
+		 addMaskRect(MIN(dtap->gridx, xcent) - 1, dtap->gridy - 1,
+			MAX(dtap->gridx, xcent) + 1, dtap->gridy + 1, l);
 	      }
 	   }
 	}
      }
-     fprintf(stdout, "multi-port mask has trunk line (%d %d) to (%d %d)\n",
+     fprintf(RTOUT, "multi-port mask has trunk line (%d %d) to (%d %d)\n",
 		xmin, ymin, xmax, ymax);
   }
 }
 
 /*--------------------------------------------------------------*/
-/* expandMask --- Extend the Mask area by 1 in all directions	*/
-/* by recursive search over all active mask positions (set to	*/
-/* nonzero).  Value 1 is used for new mask positions; value 2	*/
-/* tracks mask positions that have been processed.		*/
+/* expandMask --- Extend the Mask area by 1 in all directions,	*/
+/* including one layer up and down.  Only the positions added	*/
+/* by the last call (or by createMask()) need to be visited.	*/
+/* Returns the number of positions added to the mask.		*/
 /*--------------------------------------------------------------*/
 
-void expandMask(int x, int y, int l) {
-   if (Mask[l][OGRID(x, y, l)] == 0) {
-      Mask[l][OGRID(x, y, l)] = (u_char)2;
-   }
-   else if (Mask[l][OGRID(x, y, l)] == 1) {
-      Mask[l][OGRID(x, y, l)] = (u_char)2;	// Mark processed
-      if (x > 0) expandMask(x - 1, y, l);
-      else if (x < NumChannelsX[l] - 1) expandMask(x + 1, y, l);
-      if (y > 0) expandMask(x, y - 1, l);
-      else if (y < NumChannelsY[l] - 1) expandMask(x, y + 1, l);
-      if (l > 0) expandMask(x, y, l - 1);
-      else if (l < Num_layers - 1) expandMask(x, y, l + 1);
+int expandMask()
+{
+   int i, x, y, l, last;
+
+   last = NumMaskCells;
+   for (i = MaskRing; i < last; i++) {
+      x = MaskCells[i].x;
+      y = MaskCells[i].y;
+      l = MaskCells[i].lay;
+
+      addMask(x - 1, y, l);
+      addMask(x + 1, y, l);
+      addMask(x, y - 1, l);
+      addMask(x, y + 1, l);
+      if (l > 0) addMask(x, y, l - 1);
+      if (l < Num_layers - 1) addMask(x, y, l + 1);
    }
+   MaskRing = last;
+   return NumMaskCells - last;
 }
 
 /*--------------------------------------------------------------*/
-/* setMask() is the same routine as expandMask() but cleans up,	*/
-/* turning all values 2 back into mask value 1.			*/
+/* Parallel routing.  Each net routed in parallel is confined	*/
+/* to its route area, the bounding box of its terminals plus	*/
+/* PARALLEL_MARGIN tracks.  Nets are sorted into levels, such	*/
+/* that the areas of the nets in a level, plus PARALLEL_HALO	*/
+/* tracks touched by the route around its area, do not share	*/
+/* any of the PARALLEL_BIN tracks square bins of the grid, and	*/
+/* a net comes in a later level than every earlier net that it	*/
+/* overlaps.  The nets of each level are then routed at the	*/
+/* same time, each one seeing only its own part of Obs[], so	*/
+/* that the result does not depend on the number of threads or	*/
+/* on the order in which the threads run.			*/
+/*--------------------------------------------------------------*/
+
+#define PARALLEL_MARGIN	10
+#define PARALLEL_HALO	2
+#define PARALLEL_BIN	8
+
+typedef struct pnet_ {
+   NET net;
+   struct seg_ area;	// route area, in grid positions
+   int level;
+   int result;		// return value of doroute()
+} PNET;
+
+static PNET *PNets;	// Nets to route, sorted by level
+static int PNext;	// Next net to be taken by a thread
+static int PEnd;	// End of the level being routed
+
+/*--------------------------------------------------------------*/
+/* route_area() ---						*/
+/*								*/
+/* Set "area" to the route area of "net" (see above).  Power	*/
+/* buses can go anywhere, so their area is the whole grid.	*/
 /*--------------------------------------------------------------*/
 
-void setMask(int x, int y, int l) {
-   if (Mask[l][OGRID(x, y, l)] == 2) {
-      Mask[l][OGRID(x, y, l)] = (u_char)1;
+static void route_area(NET net, SEG area)
+{
+   NODE node;
+   DPOINT tap;
+   int pass;
+
+   area->x1 = area->y1 = MAXRT;
+   area->x2 = area->y2 = -1;
+
+   if ((net->netnum != VDD_NET) && (net->netnum != GND_NET)) {
+      for (node = net->netnodes; node != NULL; node = node->next) {
+	 for (pass = 0; pass < 2; pass++) {
+	    tap = (pass == 0) ? node->taps : node->extend;
+	    for (; tap != NULL; tap = tap->next) {
+	       if (tap->gridx < area->x1) area->x1 = tap->gridx;
+	       if (tap->gridx > area->x2) area->x2 = tap->gridx;
+	       if (tap->gridy < area->y1) area->y1 = tap->gridy;
+	       if (tap->gridy > area->y2) area->y2 = tap->gridy;
+	    }
+	 }
+      }
+   }
 
-      if (x > 0) setMask(x - 1, y, l);
-      else if (x < NumChannelsX[l] - 1) setMask(x + 1, y, l);
-      if (y > 0) setMask(x, y - 1, l);
-      else if (y < NumChannelsY[l] - 1) setMask(x, y + 1, l);
-      if (l > 0) setMask(x, y, l - 1);
-      else if (l < Num_layers - 1) setMask(x, y, l + 1);
+   if (area->x2 < 0) {
+      area->x1 = area->y1 = 0;
+      area->x2 = NumChannelsX[0] - 1;
+      area->y2 = NumChannelsY[0] - 1;
+   }
+   else {
+      area->x1 = MAX(area->x1 - PARALLEL_MARGIN, 0);
+      area->y1 = MAX(area->y1 - PARALLEL_MARGIN, 0);
+      area->x2 = MIN(area->x2 + PARALLEL_MARGIN, NumChannelsX[0] - 1);
+      area->y2 = MIN(area->y2 + PARALLEL_MARGIN, NumChannelsY[0] - 1);
    }
 }
 
 /*--------------------------------------------------------------*/
-/* fillMask() fills the Mask[] array with all 1s as a last	*/
-/* resort, ensuring that no valid routes are missed due to a	*/
-/* bad guess about the optimal route positions.			*/
+/* route_worker() ---						*/
+/*								*/
+/* Thread routine for route_parallel():  take nets of the	*/
+/* current level one at a time and route them inside their	*/
+/* route areas until there are none left.			*/
 /*--------------------------------------------------------------*/
 
-void fillMask(int value) {
+static void *route_worker(void *arg)
+{
+   char *outbuf, *errbuf;
+   size_t outsize, errsize;
    int i;
 
-   for (i = 0; i < Num_layers; i++) {
-      memset((void *)Mask[i], value,
-		(size_t)(NumChannelsX[i] * NumChannelsY[i] * sizeof(u_char)));
+   RouteParallel = TRUE;
+   while ((i = __sync_fetch_and_add(&PNext, 1)) < PEnd) {
+
+      // Keep the messages of the net, and write them out in one piece
+      // so that they do not mix with those of other threads.
+
+      Outfptr = open_memstream(&outbuf, &outsize);
+      Errfptr = open_memstream(&errbuf, &errsize);
+
+      RouteArea = PNets[i].area;
+      PNets[i].result = doroute(PNets[i].net, (u_char)0);
+
+      if (Outfptr != NULL) fclose(Outfptr);
+      if (Errfptr != NULL) fclose(Errfptr);
+      pthread_mutex_lock(&Outlock);
+      if (Outfptr != NULL) {
+	 fwrite(outbuf, 1, outsize, stdout);
+	 fflush(stdout);
+      }
+      if (Errfptr != NULL) {
+	 fwrite(errbuf, 1, errsize, stderr);
+	 fflush(stderr);
+      }
+      pthread_mutex_unlock(&Outlock);
+      if (Outfptr != NULL) free(outbuf);
+      if (Errfptr != NULL) free(errbuf);
+      Outfptr = Errfptr = NULL;
    }
+   return NULL;
+}
+
+/*--------------------------------------------------------------*/
+/* route_parallel() ---						*/
+/*								*/
+/* First stage routing of all nets on NumThreads threads.	*/
+/* Equivalent to calling doroute() on each net in turn, except	*/
+/* that nets which do not overlap are routed concurrently.	*/
+/* A level holding only one net is routed on the main thread	*/
+/* without a route area.  Nets that fail inside their route	*/
+/* area are routed again, in order and without a route area,	*/
+/* once their level is done.					*/
+/*--------------------------------------------------------------*/
+
+void route_parallel()
+{
+   NET net;
+   PNET *pnets;
+   pthread_t *threads;
+   int numnets, maxlevel, level, nthreads;
+   int nbinx, nbiny, bx1, by1, bx2, by2, bx, by;
+   int *binlevel, *first;
+   int i, j;
+
+   // Collect the nets in routing order, with their route areas
+
+   pnets = (PNET *)malloc(Numnets * sizeof(PNET));
+   numnets = 0;
+   for (i = 0; i < Numnets; i++) {
+      net = getnettoroute(i);
+      if ((net == NULL) || (net->netnodes == NULL)) continue;
+      pnets[numnets].net = net;
+      route_area(net, &pnets[numnets].area);
+      numnets++;
+   }
+
+   // Assign levels.  binlevel[] holds the last level using each bin.
+
+   nbinx = (NumChannelsX[0] + PARALLEL_BIN - 1) / PARALLEL_BIN;
+   nbiny = (NumChannelsY[0] + PARALLEL_BIN - 1) / PARALLEL_BIN;
+   binlevel = (int *)calloc(nbinx * nbiny, sizeof(int));
+   maxlevel = 0;
+
+   for (i = 0; i < numnets; i++) {
+      bx1 = MAX(pnets[i].area.x1 - PARALLEL_HALO, 0) / PARALLEL_BIN;
+      by1 = MAX(pnets[i].area.y1 - PARALLEL_HALO, 0) / PARALLEL_BIN;
+      bx2 = MIN(pnets[i].area.x2 + PARALLEL_HALO, NumChannelsX[0] - 1)
+		/ PARALLEL_BIN;
+      by2 = MIN(pnets[i].area.y2 + PARALLEL_HALO, NumChannelsY[0] - 1)
+		/ PARALLEL_BIN;
+
+      level = 0;
+      for (by = by1; by <= by2; by++)
+	 for (bx = bx1; bx <= bx2; bx++)
+	    if (binlevel[by * nbinx + bx] > level)
+	       level = binlevel[by * nbinx + bx];
+      level++;
+      for (by = by1; by <= by2; by++)
+	 for (bx = bx1; bx <= bx2; bx++)
+	    binlevel[by * nbinx + bx] = level;
+
+      pnets[i].level = level;
+      if (level > maxlevel) maxlevel = level;
+   }
+   free(binlevel);
+
+   // Sort by level, keeping the routing order within each level
+
+   first = (int *)calloc(maxlevel + 2, sizeof(int));
+   for (i = 0; i < numnets; i++) first[pnets[i].level + 1]++;
+   for (level = 1; level <= maxlevel; level++) first[level + 1] += first[level];
+   PNets = (PNET *)malloc(numnets * sizeof(PNET));
+   for (i = 0; i < numnets; i++) PNets[first[pnets[i].level]++] = pnets[i];
+   free(first);
+   free(pnets);
+
+   fprintf(RTOUT, "Routing %d nets in %d levels on %d threads\n",
+		numnets, maxlevel, NumThreads);
+
+   threads = (pthread_t *)malloc(NumThreads * sizeof(pthread_t));
+
+   for (i = 0; i < numnets; i = PEnd) {
+      level = PNets[i].level;
+      for (PEnd = i; (PEnd < numnets) && (PNets[PEnd].level == level); PEnd++);
+
+      if (PEnd - i == 1) {
+	 doroute(PNets[i].net, (u_char)0);
+	 continue;
+      }
+
+      // Route generations are handed out to the threads as they go,
+      // so make sure the count cannot wrap around during the level.
+
+      if (Obs2generation > 0xf0000000) clear_obs2_stamps();
+
+      PNext = i;
+      nthreads = MIN(NumThreads, PEnd - i);
+      for (j = 0; j < nthreads; j++)
+	 if (pthread_create(&threads[j], NULL, route_worker, NULL) != 0)
+	    break;
+
+      // The threads that did start take all the nets of the level
+      // between them.  If none could start, route the rest of the nets
+      // here, one at a time.
+
+      if (j == 0) {
+	 fprintf(stderr, "Cannot start routing threads;  routing the "
+		"remaining nets on one thread.\n");
+	 for (j = i; j < numnets; j++)
+	    doroute(PNets[j].net, (u_char)0);
+	 break;
+      }
+      nthreads = j;
+      for (j = 0; j < nthreads; j++)
+	 pthread_join(threads[j], NULL);
+
+      for (j = i; j < PEnd; j++)
+	 if (PNets[j].result < 0)
+	    doroute(PNets[j].net, (u_char)0);
+   }
+
+   free(threads);
+   free(PNets);
 }
 
 /*--------------------------------------------------------------*/
@@ -1121,12 +1601,20 @@ int doroute(NET net, u_char stage)
   int result;
 
   if (!net) {
-     fprintf(stderr, "doroute():  no net to route.\n");
+     fprintf(RTERR, "doroute():  no net to route.\n");
      return 0;
   }
 
   CurNet = net;				// Global, used by 2nd stage
 
+  // A search kept by route_segs() carries over only between the legs
+  // routed by this call.
+
+  if (ReuseNet != NULL) {
+     pqueue_free(&ReuseFrontier);
+     ReuseNet = NULL;
+  }
+
   if (net->netnum == VDD_NET || net->netnum == GND_NET)
      pwrbus_src = 0;
 
@@ -1136,7 +1624,7 @@ int doroute(NET net, u_char stage)
      rt1->netnum = net->netnum;
 
      if (Verbose > 0) {
-        fprintf(stdout,"doroute(): added net %d path start %d\n", 
+        fprintf(RTOUT,"doroute(): added net %d path start %d\n", 
 	       net->netnum, net->netnodes->nodenum);
      }
 
@@ -1155,6 +1643,10 @@ int doroute(NET net, u_char stage)
      }
 
      if (result < 0) {		// Route failure.
+	if (RouteParallel) {	// Will be retried by route_parallel()
+	   free(rt1);
+	   return -1;
+	}
 	nlist = (NETLIST)malloc(sizeof(struct netlist_));
 	nlist->net = net;
 	nlist->next = FailedNets;
@@ -1163,7 +1655,7 @@ int doroute(NET net, u_char stage)
 	return -1;
      }
 
-     TotalRoutes++;
+     __sync_fetch_and_add(&TotalRoutes, 1);
 
      if (net->routes) {
         for (lrt = net->routes; lrt->next; lrt = lrt->next);
@@ -1188,53 +1680,55 @@ int doroute(NET net, u_char stage)
 
 int route_segs(NET net, ROUTE rt, u_char stage)
 {
-  POINT gpoint, glist, gunproc;
+  POINT gpoint, glist, deferred;
+  PQUEUE frontier;
   SEG  seg;
   struct seg_ bbox;
-  int  i, j, k, o;
-  int  x, y;
+  int  i, j, k;
+  int  x, y, x1, y1, x2, y2, xmin, ymin, xmax, ymax;
   NODE n1, n2, n2save;
-  u_int netnum, dir, forbid;
+  u_int netnum, dir;
   char filename[32];
-  int  dist, max, min, maxcost;
+  int  dist, max, maxcost;
   int  thisnetnum, thisindex, index, pass;
   GRIDP best, curpt;
   int  result, rval;
+  u_int keycost;
   u_char first = (u_char)1;
-  u_char do_pwrbus;
-  u_char check_order[6];
+  u_char do_pwrbus, astar, jump, usemask, keep;
+  int  widen;
   DPOINT n1tap, n2tap;
   PROUTE *Pr;
-
-  // Make Obs2[][] a copy of Obs[][].  Convert pin obstructions to
-  // terminal positions for the net being routed.
-
-  for (i = 0; i < Num_layers; i++) {
-      for (x = 0; x < NumChannelsX[i]; x++) {
-	  for (y = 0; y < NumChannelsY[i]; y++) {
-	      netnum = Obs[i][OGRID(x, y, i)] & (~BLOCKED_MASK);
-	      Pr = &Obs2[i][OGRID(x, y, i)];
-	      if (netnum != 0) {
-	         Pr->flags = 0;		// Clear all flags
-	         Pr->prdata.net = netnum & NETNUM_MASK;
-	         dir = netnum & PINOBSTRUCTMASK;
-	         if ((dir != 0) && ((dir & STUBROUTE_X) == STUBROUTE_X)) {
-		    if ((netnum & NETNUM_MASK) == rt->netnum)
-		       Pr->prdata.net = 0;	// STUBROUTE_X not routable
-	         }
-	      } else {
-	         Pr->flags = PR_COST;		// This location is routable
-	         Pr->prdata.cost = MAXRT;
-	      }
-	  }
-      }
+  char *engine;
+  int  *wins;
+
+  // If the last leg of this net kept its search, carry on from there:
+  // Obs2, the POINT records and the frontier are as it left them, with
+  // the route it committed turned into source (see set_route_to_source()).
+  // Any other route in between makes the kept search stale.
+
+  if ((ReuseNet != NULL) && ((ReuseNet != net) || (ReuseStage != stage) ||
+		(ReuseEpoch != Obs2epoch))) {
+     pqueue_free(&ReuseFrontier);
+     ReuseNet = NULL;
   }
+  RouteReuse = (ReuseNet != NULL) ? TRUE : FALSE;
+  RouteReopen = RouteReuse;
+
+  // Make Obs2[][] a copy of Obs[][].  Pin obstructions are converted
+  // to terminal positions for the net being routed.  This is done
+  // lazily:  each Obs2 entry is copied from Obs the first time the
+  // search touches it (see OBS2() and init_proute()).
+
+  if (!RouteReuse) reset_obs2(rt->netnum);
 
   best.cost = MAXRT;
 
-  // Stack of points to search
+  // POINT records from the last route are no longer in use
+  if (!RouteReuse) reset_points();
+
+  // List of source points from which to start the search
   glist = (POINT)NULL;
-  gunproc = (POINT)NULL;
 
   n1 = net->netnodes;
 
@@ -1256,11 +1750,11 @@ int route_segs(NET net, ROUTE rt, u_char stage)
   bbox.x1 = NumChannelsX[0];
   bbox.y1 = NumChannelsY[0];
 
-  if (n1 != NULL) {
+  if ((n1 != NULL) && !RouteReuse) {
      rval = set_node_to_net(n1, PR_SOURCE, &glist, &bbox, stage);
 
      if (rval == -2) {
-        printf("Node of net %s has no tap points---unable to route!\n", n1->netname);
+        fprintf(RTOUT, "Node of net %s has no tap points---unable to route!\n", n1->netname);
 	if (forceRoutable) make_routable(n1);
         return -1;
      }
@@ -1269,11 +1763,13 @@ int route_segs(NET net, ROUTE rt, u_char stage)
   if (do_pwrbus == FALSE) {
 
      // Set associated routes to PR_SOURCE
-     rval = set_routes_to_net(net, PR_SOURCE, &glist, &bbox, stage);
+     if (!RouteReuse) {
+        rval = set_routes_to_net(net, PR_SOURCE, &glist, &bbox, stage);
 
-     if (rval == -2) {
-        printf("Node of net %s has no tap points---unable to route!\n", net->netname);
-        return -1;
+        if (rval == -2) {
+           fprintf(RTOUT, "Node of net %s has no tap points---unable to route!\n", net->netname);
+           return -1;
+        }
      }
 
      // Now search for all other nodes on the same net that have not yet been
@@ -1281,13 +1777,16 @@ int route_segs(NET net, ROUTE rt, u_char stage)
 
      result = 0;
      for (n2 = n1->next; n2; n2 = n2->next) {
-        rval = set_node_to_net(n2, PR_TARGET, NULL, &bbox, stage);
+        if (RouteReuse)		// Targets are as the last leg left them
+           rval = node_is_target(n2) ? 0 : 1;
+        else
+           rval = set_node_to_net(n2, PR_TARGET, NULL, &bbox, stage);
         if (rval == 0) {
 	   n2save = n2;
 	   result = 1;
         }
         else if (rval == -2) {
-           printf("Node of net %s has no tap points---unable to route!\n", n2->netname);
+           fprintf(RTOUT, "Node of net %s has no tap points---unable to route!\n", n2->netname);
 	   if (forceRoutable) make_routable(n2);
 	   if (result == 0) result = -1;
         }
@@ -1295,6 +1794,12 @@ int route_segs(NET net, ROUTE rt, u_char stage)
 
      /* If there's only one node left and it's not routable, then fail. */
      if (result == -1) return -1;
+
+     // For the A* search and for jumps, record where the targets are
+
+     i = (SearchAStar || SearchJump) ? astar_set_targets(net) : 0;
+     astar = (SearchAStar && (i > 0)) ? TRUE : FALSE;
+     jump = (SearchJump && (i > 0) && !RouteReuse) ? TRUE : FALSE;
   }
   else {	/* Do this for power bus connections */
 
@@ -1312,22 +1817,46 @@ int route_segs(NET net, ROUTE rt, u_char stage)
         set_powerbus_to_net(n1->netnum);
 	result = 1;
      }
+     astar = FALSE;	// Power bus targets are everywhere
+     jump = FALSE;
   }
 
   // Check for the possibility that there is already a route to the target
   if (!result) {
-     fprintf(stdout, "Finished routing net %s\n", net->netname);
+     fprintf(RTOUT, "Finished routing net %s\n", net->netname);
 
      // Remove nodes of the net from Nodeloc so that they will not be
-     // used for crossover costing of future routes.
+     // used for crossover costing of future routes.  Only the area
+     // covered by the net's nodes (see find_node_extents()) is scanned.
+     // Power and ground pins of gates have nodes that are not on the
+     // node list of the net, so for those nets the whole area is used.
+
+     x1 = MAX(RouteArea.x1, 0);
+     y1 = MAX(RouteArea.y1, 0);
+     x2 = RouteArea.x2;
+     y2 = RouteArea.y2;
+     if ((net->netnum != VDD_NET) && (net->netnum != GND_NET)) {
+        xmin = ymin = MAXRT;
+        xmax = ymax = -1;
+        for (n1 = net->netnodes; n1; n1 = n1->next) {
+	   if (n1->xmin < xmin) xmin = n1->xmin;
+	   if (n1->ymin < ymin) ymin = n1->ymin;
+	   if (n1->xmax > xmax) xmax = n1->xmax;
+	   if (n1->ymax > ymax) ymax = n1->ymax;
+        }
+        if (xmin > x1) x1 = xmin;
+        if (ymin > y1) y1 = ymin;
+        if (xmax < x2) x2 = xmax;
+        if (ymax < y2) y2 = ymax;
+     }
 
      for (i = 0; i < Num_layers; i++) {
-        for (x = 0; x < NumChannelsX[i]; x++) {
-	   for (y = 0; y < NumChannelsY[i]; y++) {
-	      n1 = Nodeloc[i][OGRID(x, y, i)];
+        for (y = y1; (y <= y2) && (y < NumChannelsY[i]); y++) {
+	   for (x = x1; (x <= x2) && (x < NumChannelsX[i]); x++) {
+	      n1 = NODELOC(x, y, i);
 	      if (n1 != (NODE)NULL)
 		 if (n1->netnum == rt->netnum)
-		    Nodeloc[i][OGRID(x, y, i)] = (NODE)NULL;
+		    Nodeid[i][OGRID(x, y, i)] |= NODE_HIDDEN;
 	   }
         }
      }
@@ -1335,13 +1864,24 @@ int route_segs(NET net, ROUTE rt, u_char stage)
      while (glist) {
 	gpoint = glist;
 	glist = glist->next;
-	free(gpoint);
+	free_point(gpoint);
+     }
+     if (RouteReuse) {
+        pqueue_free(&ReuseFrontier);
+        ReuseNet = NULL;
      }
      return 0;
   }
 
   // Generate a search area mask representing the "likely best route".
-  // createMask(CurNet);
+  // Points popped from the frontier outside of the mask are set aside
+  // on the "deferred" list, to be put back if the mask must be widened.
+
+  usemask = (!do_pwrbus && ((MaskExpand >= 0) || (net->guide != NULL))) ?
+		TRUE : FALSE;
+  if (usemask) createMask(net);
+  deferred = (POINT)NULL;
+  widen = 0;
 
   // Heuristic:  Set the initial cost beyond which we stop searching.
   // This value is twice the cost of a direct route across the
@@ -1358,6 +1898,16 @@ int route_segs(NET net, ROUTE rt, u_char stage)
 		(int)stage * ConflictCost;
      maxcost /= (n1->numnodes - 1);
   }
+  if (RouteReuse) maxcost = ReuseMaxcost;
+
+  // Large nets keep the search for the next leg, where nothing else
+  // changes the search between legs:  no mask or A* targets to redo,
+  // and no blockages placed beside the route by commit_proute().
+
+  keep = ((ReuseSearch > 0) && (net->numnodes >= ReuseSearch) &&
+		!do_pwrbus && !astar && !jump && !usemask) ? TRUE : FALSE;
+  for (i = 0; keep && (i < Num_layers); i++)
+     if (needblockX[i] || needblockY[i]) keep = FALSE;
 
   netnum = rt->netnum;
   n1tap = n1->taps;
@@ -1367,238 +1917,188 @@ int route_segs(NET net, ROUTE rt, u_char stage)
   }
 
   if (n1tap == NULL && n1->extend == NULL) {
-     printf("Node of net %s has no tap points---unable to route!\n", n1->netname);
+     fprintf(RTOUT, "Node of net %s has no tap points---unable to route!\n", n1->netname);
      return -1;
   }
   if (n1tap == NULL) n1tap = n1->extend;
 
   if (!do_pwrbus) {
      if (n2tap == NULL && n2->extend == NULL) {
-        printf("Node of net %s has no tap points---unable to route!\n", n2->netname);
+        fprintf(RTOUT, "Node of net %s has no tap points---unable to route!\n", n2->netname);
         return -1;
      }
      if (n2tap == NULL) n2tap = n2->extend;
   }
 
-  printf("Source node @ %gum %gum layer=%d grid=(%d %d)\n",
+  fprintf(RTOUT, "Source node @ %gum %gum layer=%d grid=(%d %d)\n",
 	  n1tap->x, n1tap->y, n1tap->layer,
 	  n1tap->gridx, n1tap->gridy);
   if (!do_pwrbus) {
-     printf("Dest node @ %gum %gum layer=%d grid=(%d %d)\n",
+     fprintf(RTOUT, "Dest node @ %gum %gum layer=%d grid=(%d %d)\n",
 	  n2tap->x, n2tap->y, n2tap->layer,
 	  n2tap->gridx, n2tap->gridy);
   }
-  printf("netname = %s, route number %d\n", n1->netname, TotalRoutes );
-  fflush(stdout);
+  fprintf(RTOUT, "netname = %s, route number %d\n", n1->netname,
+		__sync_fetch_and_add(&TotalRoutes, 0));
+  fflush(RTOUT);
+
+  // Seed the search frontier with the source points, all at zero cost
+
+  if (RouteReuse)
+     frontier = ReuseFrontier;
+  else
+     pqueue_init(&frontier);
+  while (glist) {
+     gpoint = glist;
+     glist = glist->next;
+     pqueue_push(&frontier, gpoint->x1, gpoint->y1, gpoint->layer, 0);
+     free_point(gpoint);
+  }
+
+  // Try the L- and Z-shaped routes of short two-node nets first, and
+  // line probes on long nets, and search the grid only if neither
+  // finds a route within maxcost.
+
+  if (!do_pwrbus && !RouteReuse && !keep && (stage == 0)) {
+     wins = NULL;
+     if ((PatternRoute > 0) && (net->numnodes == 2) &&
+		(pattern_route(net, &best, maxcost) == 1)) {
+	engine = "pattern";
+	wins = &PatternRoutes;
+     }
+     else if ((ProbeRoute > 0) && ((bbox.x2 - bbox.x1) + (bbox.y2 - bbox.y1)
+		>= ProbeRoute) && (probe_route(net, &best, maxcost) == 1)) {
+	engine = "line probe";
+	wins = &ProbeRoutes;
+     }
+     if (wins != NULL) {
+	curpt.x = best.x;
+	curpt.y = best.y;
+	curpt.lay = best.lay;
+	if ((rval = commit_proute(rt, &curpt, stage)) == 1) {
+	   __sync_fetch_and_add(wins, 1);
+	   fprintf(RTOUT, "Commit to a %s route of cost %d\n", engine,
+			best.cost);
+	   fprintf(RTOUT, "Between positions (%d %d) and (%d %d)\n",
+		best.x, best.y, curpt.x, curpt.y);
+	   goto done;
+	}
+	pass = 0;
+	goto failed;
+     }
+  }
 
   for (pass = 0; pass < Numpasses; pass++) {
 
     if (!first) {
-       fprintf(stdout, "\n");
+       fprintf(RTOUT, "\n");
        first = (u_char)1;
     }
-    fprintf(stdout, "Pass %d", pass + 1);
-    fprintf(stdout, " (maxcost is %d)\n", maxcost);
+    fprintf(RTOUT, "Pass %d", pass + 1);
+    fprintf(RTOUT, " (maxcost is %d)\n", maxcost);
 
-    while (gpoint = glist) {
+    // Points are taken from the frontier in order of increasing cost,
+    // so each point is expanded only once, at its minimum cost.  Points
+    // costing more than maxcost stay on the frontier, and we pick up
+    // from there on the next pass, if needed.  For the A* search, the
+    // frontier is ordered on cost plus the lower bound to a target, and
+    // that is the value compared against maxcost.
 
-      glist = gpoint->next;
+resume:
+    while ((gpoint = pqueue_pop(&frontier, (u_int)maxcost, &keycost)) != NULL) {
 
       curpt.x = gpoint->x1;
       curpt.y = gpoint->y1;
       curpt.lay = gpoint->layer;
+      curpt.idx = OGRID(curpt.x, curpt.y, curpt.lay);
+      free_point(gpoint);
 	
-      Pr = &Obs2[curpt.lay][OGRID(curpt.x, curpt.y, curpt.lay)];
+      Pr = OBS2_AT(curpt.idx, curpt.lay);
 
-      // ignore grid positions that have already been processed
-      if (Pr->flags & PR_PROCESSED) {
-	 free(gpoint);
-	 continue;
-      }
+      // ignore grid positions that have already been processed (a
+      // position may be pushed more than once as its cost is lowered)
+      if (Pr->flags & PR_PROCESSED) continue;
 
       if (Pr->flags & PR_COST)
-	 curpt.cost = Pr->prdata.cost;	// Route points, including target
+	 curpt.cost = Pr->prdata;	// Route points, including target
       else
 	 curpt.cost = 0;			// For source tap points
 
-      // if the grid position is the destination, save the position and
-      // cost if minimum.
+      // if the grid position is the destination, then it is the
+      // minimum cost route to any target, so save it and stop.
 
       if (Pr->flags & PR_TARGET) {
-
- 	 if (curpt.cost < best.cost) {
-	    if (first) {
-	       fprintf(stdout, "Found a route of cost ");
-	       first = (u_char)0;
-	    }
-	    else
-	       fprintf(stdout, "|");
-	    fprintf(stdout, "%d", curpt.cost);
-	    fflush(stdout);
-
-	    // This position may be on a route, not at a terminal, so
-	    // record it.
-	    best.x = curpt.x;
-	    best.y = curpt.y;
-	    best.lay = curpt.lay;
-	    best.cost = curpt.cost;
-
-	    // If a complete route has been found, then there's no point
-	    // in searching paths with a greater cost than this one.
-	    if (best.cost < maxcost) maxcost = best.cost;
+	 if (first) {
+	    fprintf(RTOUT, "Found a route of cost ");
+	    first = (u_char)0;
 	 }
+	 else
+	    fprintf(RTOUT, "|");
+	 fprintf(RTOUT, "%d", curpt.cost);
+	 fflush(RTOUT);
+
+	 // This position may be on a route, not at a terminal, so
+	 // record it.
+	 best.x = curpt.x;
+	 best.y = curpt.y;
+	 best.lay = curpt.lay;
+	 best.cost = curpt.cost;
+	 break;
+      }
 
-         // Don't continue processing from the target
-	 free(gpoint);
+      // Severely limit the search space by not processing anything that
+      // is not under the current route mask, which identifies a narrow
+      // "best route" solution.  Source points are always processed.
+
+      if (usemask && !(Pr->flags & PR_SOURCE) &&
+		(Mask[curpt.lay][curpt.idx] == (u_char)0)) {
+	 gpoint = alloc_point();
+	 gpoint->x1 = curpt.x;
+	 gpoint->y1 = curpt.y;
+	 gpoint->layer = curpt.lay;
+	 gpoint->next = deferred;
+	 deferred = gpoint;
 	 continue;
       }
 
-      if (curpt.cost < MAXRT) {
-
-	 // Severely limit the search space by not processing anything that
-	 // is not under the current route mask, which identifies a narrow
-	 // "best route" solution.
-
-	 // if (Mask[curpt.lay][OGRID(curpt.x, curpt.y, curpt.lay)] == (u_char)0) {
-	 //    gpoint->next = gunproc;
-	 //    gunproc = gpoint;
-	 //    continue;
-	 // }
-
-         // Quick check:  Limit maximum cost to limit search space
-         // Move the point onto the "unprocessed" stack and we'll pick up
-         // from this point on the next pass, if needed.
-
-	 // else
-         if (curpt.cost > maxcost) {
-	    gpoint->next = gunproc;
-	    gunproc = gpoint;
-	    continue;
-	 }
-      }
-      free(gpoint);
+      // Evaluate the steps to the neighbors, with the copy of the
+      // search step for this stage (see expand_pt()).
 
-      // check east/west/north/south, and bottom to top
+      if (stage)
+	 expand_pt_stage1(&curpt, &frontier,
+		(usemask) ? Mask[curpt.lay] : NULL, jump, astar);
+      else
+	 expand_pt_stage0(&curpt, &frontier,
+		(usemask) ? Mask[curpt.lay] : NULL, jump, astar);
 
-      // 1st optimization:  Direction of route on current layer is preferred.
-      o = LefGetRouteOrientation(curpt.lay);
-      forbid = Obs[curpt.lay][OGRID(curpt.x, curpt.y, curpt.lay)] & BLOCKED_MASK;
+      // Mark this node as processed
+      Pr->flags |= PR_PROCESSED;
 
-      if (o == 1) {			// horizontal routes---check EAST and WEST first
-	 check_order[0] = (forbid & BLOCKED_E) ? 0 : EAST;
-	 check_order[1] = (forbid & BLOCKED_W) ? 0 : WEST;
-	 check_order[2] = UP;
-	 check_order[3] = DOWN;
-	 check_order[4] = (forbid & BLOCKED_N) ? 0 : NORTH;
-	 check_order[5] = (forbid & BLOCKED_S) ? 0 : SOUTH;
-      }
-      else {				// vertical routes---check NORTH and SOUTH first
-	 check_order[0] = (forbid & BLOCKED_N) ? 0 : NORTH;
-	 check_order[1] = (forbid & BLOCKED_S) ? 0 : SOUTH;
-	 check_order[2] = UP;
-	 check_order[3] = DOWN;
-	 check_order[4] = (forbid & BLOCKED_E) ? 0 : EAST;
-	 check_order[5] = (forbid & BLOCKED_W) ? 0 : WEST;
-      }
+    } // while frontier is not empty
 
-      min = MAXRT;
-
-      // Check order is from 0 (1st priority) to 5 (last priority).  However, this
-      // is a stack system, so the last one placed on the stack is the first to be
-      // pulled and processed.  Therefore we evaluate and drop positions to check
-      // on the stack in reverse order (5 to 0).
-
-      for (i = 5; i >= 0; i--) {
-	 switch (check_order[i]) {
-	    case EAST:
-               if ((curpt.x + 1) < NumChannelsX[curpt.lay]) {
-         	  if ((result = eval_pt(&curpt, PR_PRED_W, stage)) == 1) {
-         	     gpoint = (POINT)malloc(sizeof(struct point_));
-         	     gpoint->x1 = curpt.x + 1;
-         	     gpoint->y1 = curpt.y;
-         	     gpoint->layer = curpt.lay;
-         	     gpoint->next = glist;
-         	     glist = gpoint;
-                   }
-               }
-	       break;
-
-	    case WEST:
-               if ((curpt.x - 1) >= 0) {
-         	  if ((result = eval_pt(&curpt, PR_PRED_E, stage)) == 1) {
-         	     gpoint = (POINT)malloc(sizeof(struct point_));
-         	     gpoint->x1 = curpt.x - 1;
-         	     gpoint->y1 = curpt.y;
-         	     gpoint->layer = curpt.lay;
-         	     gpoint->next = glist;
-         	     glist = gpoint;
-                  }
-               }
-	       break;
-         
-	    case SOUTH:
-               if ((curpt.y - 1) >= 0) {
-         	  if ((result = eval_pt(&curpt, PR_PRED_N, stage)) == 1) {
-         	     gpoint = (POINT)malloc(sizeof(struct point_));
-         	     gpoint->x1 = curpt.x;
-         	     gpoint->y1 = curpt.y - 1;
-         	     gpoint->layer = curpt.lay;
-         	     gpoint->next = glist;
-         	     glist = gpoint;
-                   }
-               }
-	       break;
-
-	    case NORTH:
-               if ((curpt.y + 1) < NumChannelsY[curpt.lay]) {
-         	  if ((result = eval_pt(&curpt, PR_PRED_S, stage)) == 1) {
-         	     gpoint = (POINT)malloc(sizeof(struct point_));
-         	     gpoint->x1 = curpt.x;
-         	     gpoint->y1 = curpt.y + 1;
-         	     gpoint->layer = curpt.lay;
-         	     gpoint->next = glist;
-         	     glist = gpoint;
-                  }
-               }
-	       break;
-      
-	    case DOWN:
-               if (curpt.lay > 0) {
-         	  if ((result = eval_pt(&curpt, PR_PRED_U, stage)) == 1) {
-         	     gpoint = (POINT)malloc(sizeof(struct point_));
-         	     gpoint->x1 = curpt.x;
-         	     gpoint->y1 = curpt.y;
-         	     gpoint->layer = curpt.lay - 1;
-         	     gpoint->next = glist;
-         	     glist = gpoint;
-         	  }
-               }
-	       break;
-         
-	    case UP:
-               if (curpt.lay < (Num_layers - 1)) {
-         	  if ((result = eval_pt(&curpt, PR_PRED_D, stage)) == 1) {
-         	     gpoint = (POINT)malloc(sizeof(struct point_));
-         	     gpoint->x1 = curpt.x;
-         	     gpoint->y1 = curpt.y;
-         	     gpoint->layer = curpt.lay + 1;
-         	     gpoint->next = glist;
-         	     glist = gpoint;
-         	  }
-               }
-	       break;
-            }
-         }
+    // If no route was found inside the mask, widen the mask by one
+    // track, or drop it altogether after MaskExpand tries, and resume
+    // from the points set aside.  This is done before maxcost is raised,
+    // so that a route just outside the mask is preferred to a much more
+    // expensive one inside it.
 
-      // Mark this node as processed
-      Pr->flags |= PR_PROCESSED;
+    if ((best.cost == MAXRT) && (deferred != NULL)) {
+       if ((widen < MaskExpand) && (expandMask() > 0)) {
+	  widen++;
+	  fprintf(RTOUT, "Widening route mask (%d)\n", widen);
+       }
+       else {
+	  usemask = FALSE;
+	  fprintf(RTOUT, "Route mask removed\n");
+       }
 
-    } // while stack is not empty
+       // Paths through the new area may lower the cost of positions
+       // already expanded inside the old mask, which are then expanded
+       // again with their new predecessors.
 
-    while (glist) {
-       gpoint = glist;
-       glist = glist->next;
-       free(gpoint);
+       RouteReopen = TRUE;
+       pqueue_reseed(&frontier, &deferred, astar);
+       goto resume;
     }
 
     // If we found a route, save it and return
@@ -1608,9 +2108,25 @@ int route_segs(NET net, ROUTE rt, u_char stage)
 	curpt.y = best.y;
 	curpt.lay = best.lay;
 	if ((rval = commit_proute(rt, &curpt, stage)) != 1) break;
-	fprintf(stdout, "\nCommit to a route of cost %d\n", best.cost);
-	fprintf(stdout, "Between positions (%d %d) and (%d %d)\n",
+	__sync_fetch_and_add(&SearchRoutes, 1);
+	fprintf(RTOUT, "\nCommit to a route of cost %d\n", best.cost);
+	fprintf(RTOUT, "Between positions (%d %d) and (%d %d)\n",
 		best.x, best.y, curpt.x, curpt.y);
+
+	// Keep the search for the next leg, with this route as source.
+	// The positions left on the frontier stay valid, and any that
+	// the new source reaches at lower cost are expanded again.
+
+	if (keep) {
+	   set_route_to_source(net, rt, &glist);
+	   pqueue_reseed(&frontier, &glist, FALSE);
+	   ReuseFrontier = frontier;
+	   ReuseNet = net;
+	   ReuseStage = stage;
+	   ReuseEpoch = Obs2epoch;
+	   ReuseMaxcost = maxcost;
+	   return rval;
+	}
 	goto done;	/* route success */
     }
 
@@ -1622,37 +2138,36 @@ int route_segs(NET net, ROUTE rt, u_char stage)
 					// probably completely hosed long before
 					// this.
 
-    if (gunproc == NULL) break;		// route failure not due to limiting
+    if (frontier.count == 0) break;	// route failure not due to limiting
 					// search to maxcost
-
-    // Regenerate the stack of unprocessed nodes
-    glist = gunproc;
-    gunproc = NULL;
-    
   } // pass
-  
-  if (!first) fprintf(stdout, "\n");
-  fflush(stdout);
-  fprintf(stderr, "Fell through %d passes\n", pass);
+
+failed:
+  if (!first) fprintf(RTOUT, "\n");
+  fflush(RTOUT);
+  fprintf(RTERR, "Fell through %d passes\n", pass);
   if (!do_pwrbus)
-     fprintf(stderr, "(%g,%g) <==> (%g,%g) net=%s\n",
+     fprintf(RTERR, "(%g,%g) <==> (%g,%g) net=%s\n",
 	   n1tap->x, n1tap->y, n2tap->x, n2tap->y, n1->netname);
-  if (!Failfptr) openFailFile();
-  if (!do_pwrbus)
-     fprintf(Failfptr, "(%g,%g) <==> (%g,%g) net=%s\tRoute=%d\n",
-	   n1tap->x, n1tap->y, n2tap->x, n2tap->y, n1->netname, TotalRoutes);
-  fprintf(CNfptr, "Route Priority\t%s\n", n1->netname);
-  fflush(CNfptr);
-  fflush(Failfptr);
+
+  // A net that fails on a parallel thread will be tried again
+  // without the parallel route area limits, so don't log it yet.
+
+  if (!RouteParallel) {
+     if (!Failfptr) openFailFile();
+     if (!do_pwrbus)
+        fprintf(Failfptr, "(%g,%g) <==> (%g,%g) net=%s\tRoute=%d\n",
+	      n1tap->x, n1tap->y, n2tap->x, n2tap->y, n1->netname, TotalRoutes);
+     fprintf(CNfptr, "Route Priority\t%s\n", n1->netname);
+     fflush(CNfptr);
+     fflush(Failfptr);
+  }
   rval = -1;
 
 done:
   
-  while (gunproc) {
-     gpoint = gunproc;
-     gunproc = gunproc->next;
-     free(gpoint);
-  }
+  pqueue_free(&frontier);
+  ReuseNet = NULL;
   return rval;
   
 } /* route_segs() */
@@ -1768,18 +2283,18 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
 	       if (special == (u_char)0)
 		  fprintf(stdout, "Stub route distance %g to terminal"
 				" at %d %d (%d)\n",
-				Stub[layer][OGRID(seg->x1, seg->y1, layer)],
+				STUB(seg->x1, seg->y1, layer),
 				seg->x1, seg->y1, layer);
 
 	       dc = Xlowerbound + (double)seg->x1 * PitchX[layer];
 	       x = (int)((dc + EPS) * oscale);
 	       if (dir1 == STUBROUTE_EW)
-		  dc += Stub[layer][OGRID(seg->x1, seg->y1, layer)];
+		  dc += STUB(seg->x1, seg->y1, layer);
 	       x2 = (int)((dc + EPS) * oscale);
 	       dc = Ylowerbound + (double)seg->y1 * PitchY[layer];
 	       y = (int)((dc + EPS) * oscale);
 	       if (dir1 == STUBROUTE_NS)
-		  dc += Stub[layer][OGRID(seg->x1, seg->y1, layer)];
+		  dc += STUB(seg->x1, seg->y1, layer);
 	       y2 = (int)((dc + EPS) * oscale);
 	       if (dir1 == STUBROUTE_EW) {
 		  horizontal = TRUE;
@@ -1800,7 +2315,7 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
 		     tdir = Obs[layer][OGRID(seg->x1 + 1, seg->y1, layer)];
 		     if ((tdir & ~PINOBSTRUCTMASK) ==
 					(net->netnum | ROUTED_NET)) {
-			if (Stub[layer][OGRID(seg->x1, seg->y1, layer)] +
+			if (STUB(seg->x1, seg->y1, layer) +
 					LefGetRouteKeepout(layer) >= PitchX[layer]) {
 		      	   dc = Xlowerbound + (double)(seg->x1 + 1)
 					* PitchX[layer];
@@ -1812,7 +2327,7 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
 		     tdir = Obs[layer][OGRID(seg->x1 - 1, seg->y1, layer)];
 		     if ((tdir & ~PINOBSTRUCTMASK) ==
 					(net->netnum | ROUTED_NET)) {
-			if (-Stub[layer][OGRID(seg->x1, seg->y1, layer)] +
+			if (-STUB(seg->x1, seg->y1, layer) +
 					LefGetRouteKeepout(layer) >= PitchX[layer]) {
 		      	   dc = Xlowerbound + (double)(seg->x1 - 1)
 					* PitchX[layer];
@@ -1860,7 +2375,7 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
 		     tdir = Obs[layer][OGRID(seg->x1, seg->y1 + 1, layer)];
 		     if ((tdir & ~PINOBSTRUCTMASK) ==
 						(net->netnum | ROUTED_NET)) {
-			if (Stub[layer][OGRID(seg->x1, seg->y1, layer)] +
+			if (STUB(seg->x1, seg->y1, layer) +
 					LefGetRouteKeepout(layer) >= PitchY[layer]) {
 		      	   dc = Ylowerbound + (double)(seg->y1 + 1)
 					* PitchY[layer];
@@ -1872,7 +2387,7 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
 		     tdir = Obs[layer][OGRID(seg->x1, seg->y1 - 1, layer)];
 		     if ((tdir & ~PINOBSTRUCTMASK) ==
 						(net->netnum | ROUTED_NET)) {
-			if (-Stub[layer][OGRID(seg->x1, seg->y1, layer)] +
+			if (-STUB(seg->x1, seg->y1, layer) +
 					LefGetRouteKeepout(layer) >= PitchY[layer]) {
 		      	   dc = Ylowerbound + (double)(seg->y1 - 1)
 					* PitchY[layer];
@@ -1934,11 +2449,10 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
 	       if (dir1 == 0 && lastseg) {
 		  dir1 = Obs[lastseg->layer][OGRID(lastseg->x2, lastseg->y2,
 					lastseg->layer)] & PINOBSTRUCTMASK;
-		  offset1 = Stub[lastseg->layer][OGRID(lastseg->x2,
-					lastseg->y2, lastseg->layer)];
+		  offset1 = STUB(lastseg->x2, lastseg->y2, lastseg->layer);
 	       }
 	       else
-		  offset1 = Stub[seg->layer][OGRID(seg->x1, seg->y1, seg->layer)];
+		  offset1 = STUB(seg->x1, seg->y1, seg->layer);
 
 	       // Additional offset for vias vs. plain route layer
 	       if (seg->segtype & ST_VIA) {
@@ -1964,11 +2478,10 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
 		  dir2 = Obs[seg->next->layer][OGRID(seg->next->x1,
 					seg->next->y1, seg->next->layer)] &
 					PINOBSTRUCTMASK;
-		  offset2 = Stub[seg->next->layer][OGRID(seg->next->x1,
-					seg->next->y1, seg->next->layer)];
+		  offset2 = STUB(seg->next->x1, seg->next->y1, seg->next->layer);
 	       }
 	       else
-		  offset2 = Stub[seg->layer][OGRID(seg->x2, seg->y2, seg->layer)];
+		  offset2 = STUB(seg->x2, seg->y2, seg->layer);
 
 	       // Additional offset for vias vs. plain route layer
 	       if (seg->segtype & ST_VIA) {
@@ -2169,18 +2682,18 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
 		if (special == (u_char)0)
 		   fprintf(stdout, "Stub route distance %g to terminal"
 				" at %d %d (%d)\n",
-				Stub[layer][OGRID(seg->x2, seg->y2, layer)],
+				STUB(seg->x2, seg->y2, layer),
 				seg->x2, seg->y2, layer);
 
 		dc = Xlowerbound + (double)seg->x2 * PitchX[layer];
 		x = (int)((dc + EPS) * oscale);
 		if (dir2 == STUBROUTE_EW)
-		   dc += Stub[layer][OGRID(seg->x2, seg->y2, layer)];
+		   dc += STUB(seg->x2, seg->y2, layer);
 		x2 = (int)((dc + EPS) * oscale);
 		dc = Ylowerbound + (double)seg->y2 * PitchY[layer];
 		y = (int)((dc + EPS) * oscale);
 		if (dir2 == STUBROUTE_NS)
-		   dc += Stub[layer][OGRID(seg->x2, seg->y2, layer)];
+		   dc += STUB(seg->x2, seg->y2, layer);
 		y2 = (int)((dc + EPS) * oscale);
 		if (dir2 == STUBROUTE_EW) {
 		   horizontal = TRUE;
@@ -2195,7 +2708,7 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
 		      tdir = Obs[layer][OGRID(seg->x2 + 1, seg->y2, layer)];
 		      if ((tdir & ~PINOBSTRUCTMASK) ==
 						(net->netnum | ROUTED_NET)) {
-			 if (Stub[layer][OGRID(seg->x2, seg->y2, layer)] +
+			 if (STUB(seg->x2, seg->y2, layer) +
 					LefGetRouteKeepout(layer) >= PitchX[layer]) {
 		      	    dc = Xlowerbound + (double)(seg->x2 + 1)
 					* PitchX[layer];
@@ -2207,7 +2720,7 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
 		      tdir = Obs[layer][OGRID(seg->x2 - 1, seg->y2, layer)];
 		      if ((tdir & ~PINOBSTRUCTMASK) ==
 						(net->netnum | ROUTED_NET)) {
-			 if (-Stub[layer][OGRID(seg->x2, seg->y2, layer)] +
+			 if (-STUB(seg->x2, seg->y2, layer) +
 					LefGetRouteKeepout(layer) >= PitchX[layer]) {
 		      	    dc = Xlowerbound + (double)(seg->x2 - 1)
 					* PitchX[layer];
@@ -2255,7 +2768,7 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
 		      tdir = Obs[layer][OGRID(seg->x2, seg->y2 + 1, layer)];
 		      if ((tdir & ~PINOBSTRUCTMASK) ==
 						(net->netnum | ROUTED_NET)) {
-			 if (Stub[layer][OGRID(seg->x2, seg->y2, layer)] +
+			 if (STUB(seg->x2, seg->y2, layer) +
 					LefGetRouteKeepout(layer) >= PitchY[layer]) {
 		      	    dc = Ylowerbound + (double)(seg->y2 + 1)
 					* PitchY[layer];
@@ -2267,7 +2780,7 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
 		      tdir = Obs[layer][OGRID(seg->x2, seg->y2 - 1, layer)];
 		      if ((tdir & ~PINOBSTRUCTMASK) ==
 						(net->netnum | ROUTED_NET)) {
-			 if (-Stub[layer][OGRID(seg->x2, seg->y2, layer)] +
+			 if (-STUB(seg->x2, seg->y2, layer) +
 					LefGetRouteKeepout(layer) >= PitchY[layer]) {
 		      	    dc = Ylowerbound + (double)(seg->y2 - 1)
 					* PitchY[layer];
@@ -2429,10 +2942,7 @@ void emit_routes(char *filename, double oscale, int iscale)
 
        /* Find this net */
 
-       for (net = Nlnets; net; net = net->next) {
-	  if (!strcmp(net->netname, netname))
-	     break;
-       }
+       net = find_net(netname);
        if (!net) {
 	  fprintf(stderr, "emit_routes():  Net %s cannot be found.\n",
 		netname);
@@ -2513,6 +3023,9 @@ void helpmessage()
     fprintf(stdout, "\t-i <file>\t\t\tPrint route names and pitches and exit.\n");
     fprintf(stdout, "\t-p <name>\t\t\tSpecify global power bus name.\n");
     fprintf(stdout, "\t-g <name>\t\t\tSpecify global ground bus name.\n");
+    fprintf(stdout, "\t-j <n>\t\t\t\tRoute nets in parallel on <n> threads.\n");
+    fprintf(stdout, "\t-o <order>\t\t\tNet order:  fanout, area, hpwl, density,\n");
+    fprintf(stdout, "\t\t\t\t\tor critical.\n");
     fprintf(stdout, "\n");
     fprintf(stdout, "%s.%s\n", VERSION, REVISION);
 
@@ -7,7 +7,109 @@
 
 #ifndef QROUTER_H
 
-#define OGRID(x, y, layer) ((int)((x) + ((y) * NumChannelsX[(layer)])))
+// The grid arrays are stored in tiles of GRID_TILE x GRID_TILE
+// positions, with the tiles of all layers interleaved (see grid.c).
+// OGRID() is the offset of (x, y) in the array of any layer.  When
+// compiled with -DGRID_DEBUG, OGRID() checks (x, y) against the size
+// of the layer (see grid_index()).
+
+#define GRID_TILE_BITS	3
+#define GRID_TILE	(1 << GRID_TILE_BITS)
+#define GRID_TILE_MASK	(GRID_TILE - 1)
+
+#define GRID_OFFSET(x, y) ((int)(((((y) >> GRID_TILE_BITS) * GridTilesX + \
+		((x) >> GRID_TILE_BITS)) * GridStride) + \
+		(((y) & GRID_TILE_MASK) << GRID_TILE_BITS) + ((x) & GRID_TILE_MASK)))
+
+#ifdef GRID_DEBUG
+int grid_index(int x, int y, int lay);
+#define OGRID(x, y, layer) grid_index(x, y, layer)
+#else
+#define OGRID(x, y, layer) GRID_OFFSET(x, y)
+#endif
+
+// Offset of the neighbor of position (x, y) at offset "idx", for
+// stepping through the grid without recomputing OGRID().  A step up
+// or down a layer keeps the same offset.
+
+#define OGRID_EAST(idx, x) ((((x) & GRID_TILE_MASK) != GRID_TILE_MASK) ? \
+		(idx) + 1 : (idx) + GridStride - GRID_TILE_MASK)
+#define OGRID_WEST(idx, x) ((((x) & GRID_TILE_MASK) != 0) ? \
+		(idx) - 1 : (idx) - GridStride + GRID_TILE_MASK)
+#define OGRID_NORTH(idx, y) ((((y) & GRID_TILE_MASK) != GRID_TILE_MASK) ? \
+		(idx) + GRID_TILE : (idx) + GridRowStride - \
+		(GRID_TILE_MASK << GRID_TILE_BITS))
+#define OGRID_SOUTH(idx, y) ((((y) & GRID_TILE_MASK) != 0) ? \
+		(idx) - GRID_TILE : (idx) - GridRowStride + \
+		(GRID_TILE_MASK << GRID_TILE_BITS))
+
+// Pointer to the Obs2 entry at (x, y, layer), copied from Obs if it
+// has not yet been touched during the current route.  OBS2_AT() is
+// the same given the offset of (x, y).
+#define OBS2_AT(idx, layer) ((Obs2stamp[(layer)][idx] == Obs2epoch) ? \
+		&Obs2[(layer)][idx] : init_proute(idx, layer))
+#define OBS2(x, y, layer) OBS2_AT(OGRID(x, y, layer), layer)
+// Nodes attached to grid points, for reverse lookup.  NODESAV() is
+// the node at a position as set up from the pin geometry.  NODELOC()
+// is the same, except that the positions of a net are hidden while
+// the net is routed, so that they are not costed as crossovers (and
+// shown again when the net is ripped up).  Both are kept in Nodeid
+// as an index in Nodetab, with NODE_HIDDEN set where NODELOC() is
+// NULL.
+
+#define NODE_HIDDEN	0x80000000
+
+#define NODESAV_AT(idx, layer) (Nodetab[Nodeid[(layer)][idx] & ~NODE_HIDDEN])
+#define NODELOC_AT(idx, layer) ((Nodeid[(layer)][idx] & NODE_HIDDEN) ? \
+		(NODE)NULL : Nodetab[Nodeid[(layer)][idx]])
+#define NODESAV(x, y, layer) NODESAV_AT(OGRID(x, y, layer), layer)
+#define NODELOC(x, y, layer) NODELOC_AT(OGRID(x, y, layer), layer)
+
+// Crossing[] flags for grid positions with a node on the layer above or
+// below, where a route may have to pay XverCost or BlockCost
+
+#define CROSS_BELOW	0x01
+#define CROSS_ABOVE	0x02
+
+// Free track runs, for jumps along the preferred direction of a layer
+// in the search.  RUN_AHEAD() is the number of grid steps that can be
+// taken east (horizontal layers) or north (vertical layers) from a
+// position through plain free track, where each step costs the same
+// and opens up no via or jog that the last one did not;  RUN_BEHIND()
+// is the same to the west or south.  See find_track_runs().
+
+#define RUN_MAX		0xffff
+#define RUN_AHEAD(r)	((r) & RUN_MAX)
+#define RUN_BEHIND(r)	((r) >> 16)
+
+// Array of values at grid positions, most of which are zero, kept
+// as a hash table (see sgrid_get() and sgrid_set() in grid.c).
+
+typedef struct sparsegrid_ SPARSEGRID;
+
+struct sparsegrid_ {
+   u_int *key;		// grid position of each entry plus one, 0 if empty
+   float *value;	// value of each entry
+   u_int size;		// number of slots (power of two)
+   u_int count;		// number of slots used
+};
+
+#define STUB(x, y, layer) sgrid_get(&Stub, x, y, layer)
+#define OBSINFO(x, y, layer) sgrid_get(&Obsinfo, x, y, layer)
+
+// Storage class of the route search state, which is private to each
+// thread when nets are routed in parallel (see route_parallel()).
+#define THREAD_LOCAL __thread
+
+// Inline a function into every call, so that arguments which are
+// constants at the call (such as the routing stage) fold away.
+#define ALWAYS_INLINE __inline__ __attribute__((always_inline))
+
+// Streams for the messages of a route.  Parallel threads collect the
+// messages of each net and write them out whole (see route_worker()).
+#define RTOUT ((Outfptr != NULL) ? Outfptr : stdout)
+#define RTERR ((Errfptr != NULL) ? Errfptr : stderr)
+
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
 
@@ -67,6 +169,14 @@ typedef unsigned long  u_long;
 #define VIA_PATTERN_NORMAL	 0
 #define VIA_PATTERN_INVERT	 1
 
+// Net ordering strategies (see order.c)
+
+#define ORDER_FANOUT	 0
+#define ORDER_AREA	 1
+#define ORDER_HPWL	 2
+#define ORDER_DENSITY	 3
+#define ORDER_CRITICAL	 4
+
 // define a structure containing x, y, and layer
 
 typedef struct gridp_ GRIDP;
@@ -75,17 +185,17 @@ struct gridp_ {
    int x;
    int y;
    int lay;
+   int idx;		// OGRID() offset of (x, y)
    u_int cost;
 };
 
 typedef struct proute_ PROUTE;
 
-struct proute_ {        // partial route
-   u_char flags; 	// values PR_PROCESSED and PR_CONFLICT
-   union {
-      u_int cost;	// cost of route coming from predecessor
-      u_int net;	// net number at route point
-   } prdata;
+struct proute_ {        // partial route, packed into 32 bits
+   u_int flags : 8; 	// values PR_PROCESSED and PR_CONFLICT
+   u_int prdata : 24;	// if PR_COST, cost of route coming from
+			// predecessor (at most MAXRT);  otherwise net
+			// number at route point, as set by PR_NETNUM()
 };
 
 // Bit values for "flags" in PROUTE
@@ -104,7 +214,7 @@ struct proute_ {        // partial route
 #define PR_CONFLICT	0x10		// Two nets collide here during stage 2
 #define PR_SOURCE	0x20		// This is a source node
 #define PR_TARGET	0x40		// This is a target node
-#define PR_COST		0x80		// if 1, use prdata.cost, not prdata.net
+#define PR_COST		0x80		// if 1, prdata is a cost, not a net number
 
 // Linked string list
 
@@ -154,6 +264,22 @@ struct point_ {
   int x1, y1;
 };
 
+// Search frontier for route_segs().  This is a bucket queue ("Dial's
+// algorithm") keyed on route cost.  Costs are small integers built
+// up from SegCost, ViaCost, etc., and no cost is ever pushed lower
+// than the cost last popped, so a ring of buckets indexed by cost
+// modulo the ring size keeps the frontier in cost order.  The ring
+// grows if a step cost exceeds its span.
+
+typedef struct pqueue_ PQUEUE;
+
+struct pqueue_ {
+   POINT *bucket;	// ring of lists of grid points of equal cost
+   int   nbuckets;	// size of ring (power of two)
+   u_int mincost;	// cost of the lowest (possibly empty) bucket
+   int   count;		// number of entries in the queue
+};
+
 /* DPOINT is a point location with  coordinates given *both* as an	*/
 /* integer (for the grid-based routing) and as a physical dimension	*/
 /* (microns).								*/
@@ -186,6 +312,9 @@ struct node_ {
   char    *netname;   		   // name of net this node belongs to
   int     netnum;                  // number of net this node belongs to
   int     numnodes;		   // number of nodes on this net
+  u_int   gridid;		   // index in Nodetab (see Nodeid)
+  int     xmin, ymin;		   // extent of the node's grid positions
+  int     xmax, ymax;		   // (see find_node_extents())
 };
 
 // these are instances of gates in the netlist.  The description of a 
@@ -234,6 +363,8 @@ struct net_ {
 			// route this net.  This will not be allowed
 			// a second time, to avoid looping.
    ROUTE   routes;	// routes for this net
+   int  *guide;		// gcells of the global route (see glroute.c)
+   int  numguide;	// number of gcells in guide
 };
 
 // Flags used by NET "flags" record
@@ -247,7 +378,7 @@ struct netlist_ {
    NET net;
 };
 
-#define MAXRT		10000000		// "Infinite" route cost
+#define MAXRT		10000000		// "Infinite" route cost (fits PROUTE)
 
 // The following values are added to the Obs[] structure for unobstructed
 // route positions close to a terminal, but not close enough to connect
@@ -278,6 +409,13 @@ struct netlist_ {
 
 #define MAX_NETNUMS	((u_int)0x007fffff)  // Maximum net number
 
+// Net numbers in PROUTE have 24 bits, so NO_NET moves down to the
+// bit left free by ROUTED_NET.  Compare PROUTE net numbers against
+// PR_NETNUM() of values that may include NO_NET.
+
+#define PR_NO_NET	ROUTED_NET
+#define PR_NETNUM(n)	(((n) & MAX_NETNUMS) | (((n) & NO_NET) ? PR_NO_NET : 0))
+
 // Definitions used along with the NO_NET bit.
 #define OBSTRUCT_MASK	((u_int)0x0000000f)  // Tells where obstruction is
 #define OBSTRUCT_N	((u_int)0x00000008)  // relative to the grid point.
@@ -288,21 +426,39 @@ struct netlist_ {
 extern STRING DontRoute;
 extern STRING CriticalNet;
 extern GATE   GateInfo;		// standard cell macro information
-extern NET    CurNet;
+extern THREAD_LOCAL NET CurNet;
 extern NETLIST FailedNets;	// nets that have failed the first pass
 extern NETLIST Abandoned;	// nets that have failed the second pass
 
 extern GATE   Nlgates;
 extern NET    Nlnets;
+extern NET   *Nettab;		// nets by net number
+extern NET   *Netorder;		// nets to route, by order
 
+extern int    GridTilesX;		// grid tiles across (see OGRID())
+extern int    GridStride;		// grid positions from tile to tile
+extern int    GridRowStride;	// grid positions from tile row to row
 extern u_int  *Obs[MAX_LAYERS];		// obstructions by layer, y, x
 extern PROUTE *Obs2[MAX_LAYERS]; 	// working copy of Obs 
-extern float  *Obsinfo[MAX_LAYERS];	// temporary detailed obstruction info
-extern float  *Stub[MAX_LAYERS];	// stub route distances to pins
-extern NODE   *Nodeloc[MAX_LAYERS];	// nodes are attached to grid points
-					// for reverse lookup
-extern NODE   *Nodesav[MAX_LAYERS];	// copy of Nodeloc used for restoring
-					// Nodeloc after net rip-up
+extern u_int  *Obs2stamp[MAX_LAYERS];	// route generation of Obs2 entries
+extern THREAD_LOCAL u_int Obs2epoch;	// current route generation
+extern THREAD_LOCAL int Obs2net;	// net number of the current route
+extern u_int  Obs2generation;		// last route generation handed out
+extern THREAD_LOCAL struct seg_ RouteArea;	// limits of the route search
+extern THREAD_LOCAL u_char RouteParallel;	// routing on a parallel thread
+extern THREAD_LOCAL u_char RouteReuse;	// search carries on from the last leg
+extern THREAD_LOCAL u_char RouteReopen;	// expanded positions may be lowered
+extern THREAD_LOCAL FILE *Outfptr;	// messages of the net routed, if kept
+extern THREAD_LOCAL FILE *Errfptr;	// errors of the net routed, if kept
+extern u_short *Hist[MAX_LAYERS];	// past collisions at each position
+extern u_int  *Runs[MAX_LAYERS];	// free track runs (see RUN_AHEAD())
+extern int    PresFactor;		// scale of the present collision cost
+extern SPARSEGRID Obsinfo;		// temporary detailed obstruction info
+extern SPARSEGRID Stub;			// stub route distances to pins
+extern u_int  *Nodeid[MAX_LAYERS];	// node at each grid point, as an
+					// index in Nodetab (see NODELOC())
+extern NODE   *Nodetab;			// nodes by index
+extern u_char *Crossing[MAX_LAYERS];	// nodes above or below (CROSS_*)
 extern DSEG  UserObs;			// user-defined obstruction layers
 
 extern u_char needblockX[MAX_LAYERS];
@@ -312,6 +468,7 @@ extern int   Numnets;
 extern int   Numgates;
 extern int   Numpins;
 extern int   Verbose;
+extern int   NumThreads;
 
 extern char *vddnet;
 extern char *gndnet;
@@ -321,15 +478,15 @@ extern int    allocate_obs_array();
 
 NET    getnettoroute();
 void   dosecondstage();
+void   donegotiate();
 int    doroute(NET net, u_char stage);
+void   route_parallel();
 int    route_segs(NET net, ROUTE rt, u_char stage);
 ROUTE  createemptyroute();
 void   emit_routes(char *filename, double oscale, int iscale);
 
-void   createMask();
-void   fillMask();
-void   setMask();
-void   expandMask();
+void   createMask(NET net);
+int    expandMask();
 
 void   pathstart(FILE *cmd, int layer, int x, int y, u_char special, double oscale,
 			double invscale);